@@ -1,8 +1,55 @@
 #pragma once
 
+#include <cmath>
 #include <string>
 #include <ratio>
 #include <limits>
+#include <type_traits>
+
+/*
+ * Defining MESI_DEBUG_INLINE forces the members of RationalTypeReduced and
+ * the operators on it to be inlined even in unoptimised builds, where each
+ * operation would otherwise be several out-of-line calls. They are also
+ * marked as artificial, so debuggers step over them.
+ */
+#ifndef MESI_INLINE
+#	if defined(MESI_DEBUG_INLINE) && (defined(__GNUC__) || defined(__clang__))
+#		define MESI_INLINE inline __attribute__((always_inline, artificial))
+#	elif defined(MESI_DEBUG_INLINE) && defined(_MSC_VER)
+#		define MESI_INLINE __forceinline
+#	else
+#		define MESI_INLINE
+#	endif
+#endif
+
+/*
+ * Whether the compiler is evaluating a constant expression, where it can
+ * tell. Scale factors that need pow() at run time are computed without it
+ * then, and instrumentation is skipped.
+ */
+#if defined(__GNUC__) && __GNUC__ >= 9 && !defined(__clang__)
+#	define MESI_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#elif defined(__has_builtin)
+#	if __has_builtin(__builtin_is_constant_evaluated)
+#		define MESI_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#	endif
+#endif
+#ifndef MESI_CONSTANT_EVALUATED
+#	define MESI_CONSTANT_EVALUATED() false
+#endif
+
+/*
+ * Defining MESI_INSTRUMENT makes scale conversions, Mesi::pow and scale
+ * factors computed at run time report themselves to the hooks in
+ * mesitype_instrument.h. Where the compiler can tell, nothing is reported
+ * during constant evaluation, so conversions stay constexpr.
+ */
+#ifdef MESI_INSTRUMENT
+#	include "mesitype_instrument.h"
+#	define MESI_INSTRUMENT_EVENT(event, from, to) if(!MESI_CONSTANT_EVALUATED()) ::Mesi::_internal::instrumentEvent(::Mesi::Instrument::Event::event, from, to)
+#else
+#	define MESI_INSTRUMENT_EVENT(event, from, to)
+#endif
 
 namespace Mesi {
 	namespace _internal {
@@ -32,6 +79,155 @@ namespace Mesi {
 			static constexpr intmax_t value = 1;
 		};
 
+		/**
+		 * The scale and dimensions of a type as plain data, so that code
+		 * working on them is shared by all types instead of instantiated for
+		 * each one
+		 */
+		struct UnitInfo
+		{
+			intmax_t ratio_num;
+			intmax_t ratio_den;
+			intmax_t exponent_denominator;
+			intmax_t power_of_ten_num;
+			intmax_t power_of_ten_den;
+			intmax_t exponents[7][2];
+		};
+
+		/**
+		 * Builds the string returned by getUnit
+		 */
+		inline std::string unitString(UnitInfo const& info)
+		{
+			static char const* const s_names[7] = { "m", "s", "kg", "A", "K", "mol", "cd" };
+			std::string ret;
+
+			if( info.ratio_num != 1 )
+			{
+				ret += " * ";
+				if( info.exponent_denominator != 1 && info.ratio_den != 1 )
+				{
+					ret += "(";
+				}
+				ret += std::to_string(info.ratio_num);
+				if( info.ratio_den != 1 )
+				{
+					ret += "/" + std::to_string(info.ratio_den);
+				}
+				if( info.exponent_denominator != 1 )
+				{
+					if( info.ratio_den != 1 )
+					{
+						ret += ")";
+					}
+					ret += "^(1/";
+					ret += std::to_string(info.exponent_denominator);
+					ret += ")";
+				}
+				ret += " ";
+			}
+
+			if( info.power_of_ten_num != 0 )
+			{
+				ret += "* 10^";
+				if(info.power_of_ten_den != 1)
+				{
+					ret += "(";
+				}
+				ret += std::to_string(info.power_of_ten_num);
+				if(info.power_of_ten_den != 1)
+				{
+					ret += "/" + std::to_string(info.power_of_ten_den) + ")";
+				}
+				ret += " ";
+			}
+
+			for(int i = 0; i < 7; i++)
+			{
+				intmax_t const num = info.exponents[i][0];
+				intmax_t const den = info.exponents[i][1];
+				if( num == 1 && den == 1 )
+				{
+					ret += std::string(s_names[i]) + " ";
+				}
+				else if( num != 0 && den == 1 )
+				{
+					ret += std::string(s_names[i]) + "^" + std::to_string(static_cast<long long>(num)) + " ";
+				}
+				else if( num != 0 )
+				{
+					ret += std::string(s_names[i]) + "^(" + std::to_string(static_cast<long long>(num)) + "/" + std::to_string(static_cast<long long>(den)) + ") ";
+				}
+			}
+
+			return ret.substr(0, ret.size() - 1);
+		}
+
+		/**
+		 * 10^(num/den), for powers of ten that cannot be computed at compile
+		 * time. This is shared by all scales with the storage type T.
+		 */
+		template<typename T>
+		T fractionalPowerOfTen(intmax_t num, intmax_t den)
+		{
+			return std::pow(T(10), T(num)/T(den));
+		}
+
+		/**
+		 * (num/den)^(1/root), shared by all scales with the storage type T
+		 */
+		template<typename T>
+		T ratioRoot(intmax_t num, intmax_t den, intmax_t root)
+		{
+			return std::pow(T(num)/T(den), T(1)/T(root));
+		}
+
+		/**
+		 * x^(1/root) for x > 0 by Newton's method, which approaches the
+		 * root from above, for use in constant expressions. This is slow,
+		 * but only runs in the compiler.
+		 */
+		constexpr long double constantRoot(long double x, intmax_t root)
+		{
+			long double y = x > 1 ? x : 1;
+			for(int i = 0; root > 1 && i < 100000; i++)
+			{
+				long double p = 1;
+				for(intmax_t k = 1; k < root; k++)
+				{
+					p *= y;
+				}
+				long double const next = ((root - 1) * y + x / p) / root;
+				if(next >= y)
+				{
+					break;
+				}
+				y = next;
+			}
+			return y;
+		}
+
+		/**
+		 * 10^(num/den) for use in constant expressions, as the integral
+		 * power of ten times the root of the rest
+		 */
+		constexpr long double constantPowerOfTen(intmax_t num, intmax_t den)
+		{
+			long double whole = 1;
+			for(intmax_t i = 0; i < (num / den < 0 ? -(num / den) : num / den); i++)
+			{
+				whole *= 10;
+			}
+			long double part = 1;
+			for(intmax_t i = 0; i < (num % den < 0 ? -(num % den) : num % den); i++)
+			{
+				part *= 10;
+			}
+			whole = num / den < 0 ? 1 / whole : whole;
+			part = num % den < 0 ? 1 / part : part;
+			return whole * constantRoot(part, den);
+		}
+
 		/**
 		 * Type to hold scaling information for Mesi types.
 		 *
@@ -48,7 +244,11 @@ namespace Mesi {
 			{
 				static T value()
 				{
-					static T v = pow(T(10), T(p::num)/T(p::den));
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+					static_assert(p::den == 1, "MESI_STRICT_CONSTEXPR_SCALES: a fractional power of ten can only be computed at run time");
+#endif
+					MESI_INSTRUMENT_EVENT(RuntimePowerOfTen, &Scale::getUnit, &Scale::getUnit);
+					static T const v = fractionalPowerOfTen<T>(p::num, p::den);
 					return v;
 				}
 			};
@@ -58,19 +258,28 @@ namespace Mesi {
 			{
 			private:
 				static constexpr T calculate_value() {
+					// Negative powers are the reciprocal of the positive
+					// power, which rounds once rather than at every division,
+					// unless the positive power does not fit into T
+					intmax_t const n = num < 0 ? -num : num;
+					bool const reciprocal = std::numeric_limits<T>::is_specialized && !std::numeric_limits<T>::is_integer && n <= std::numeric_limits<T>::max_exponent10;
 					T ret = 1;
-					for(intmax_t i = 0; i < num; i++)
+					if(num >= 0 || reciprocal)
 					{
-						ret *= T(10);
+						for(intmax_t i = 0; i < n; i++)
+						{
+							ret *= T(10);
+						}
+						return num >= 0 ? ret : T(1) / ret;
 					}
-					for(intmax_t i = 0; i > num; i--)
+					for(intmax_t i = 0; i < n; i++)
 					{
 						ret /= T(10);
 					}
 					return ret;
 				}
 			public:
-				static constexpr T value()
+				MESI_INLINE static constexpr T value()
 				{
 					constexpr T v = calculate_value();
 					return v;
@@ -81,21 +290,25 @@ namespace Mesi {
 			{
 				static T value()
 				{
-					static T v = pow(T(r::num)/T(r::den), T(1)/T(e));
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+					static_assert(e == 1, "MESI_STRICT_CONSTEXPR_SCALES: the root of a ratio can only be computed at run time");
+#endif
+					MESI_INSTRUMENT_EVENT(RuntimeRatioRoot, &Scale::getUnit, &Scale::getUnit);
+					static T const v = ratioRoot<T>(r::num, r::den, e);
 					return v;
 				}
 			};
 			template<typename T, typename r>
 			struct RatioValue<T, r, 1>
 			{
-				static constexpr T value()
+				MESI_INLINE static constexpr T value()
 				{
 					constexpr T v = T(r::num)/T(r::den);
 					return v;
 				}
 			};
 			template<typename T, typename ratio, intmax_t exponent_denominator, typename power_of_ten>
-			static constexpr T calculate_value()
+			MESI_INLINE static constexpr T calculate_value()
 			{
 				return RatioValue<T, ratio, exponent_denominator>::value() * PowerOfTenValue<T, power_of_ten>::value();
 			}
@@ -111,11 +324,34 @@ namespace Mesi {
 			 * non-constexpr pow() has to be used.
 			 */
 			template<typename T>
-			static constexpr T value()
+			MESI_INLINE static constexpr T value()
 			{
 				return calculate_value<T, ratio, exponent_denominator, power_of_ten>();
 			}
 
+			/**
+			 * Calculates the full scaling factor as type T without pow(), so
+			 * it is constexpr for every scale. This is what conversions use
+			 * for roots and fractional powers of ten in constant
+			 * expressions; the result may differ from value() in the last
+			 * digit.
+			 */
+			template<typename T>
+			MESI_INLINE static constexpr T constantValue()
+			{
+				return T(constantRoot((long double)ratio::num / (long double)ratio::den, exponent_denominator)
+					* constantPowerOfTen(power_of_ten::num, power_of_ten::den));
+			}
+
+			/**
+			 * The scaling factor as a string in the format of getUnit
+			 */
+			static std::string getUnit()
+			{
+				return unitString(UnitInfo{ ratio::num, ratio::den, exponent_denominator, power_of_ten::num, power_of_ten::den,
+					{ { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 } } });
+			}
+
 			/**
 			 * The inverse of the type, i.e. 1/Scale
 			 */
@@ -264,9 +500,71 @@ namespace Mesi {
 			using Scale = typename ScaleSimplify<::Mesi::_internal::Scale<std::ratio<num(), den()>, t_scale::exponent_denominator * t_power::den, std::ratio_multiply<typename t_scale::power_of_ten, t_power>>>::Scale;
 		};
 	}
+	namespace _internal {
+		/**
+		 * Whether a scaling factor can be computed at compile time, i.e. has
+		 * no root and an integral power of ten
+		 */
+		template<typename t_scale>
+		struct ScaleIsConstant : std::integral_constant<bool, t_scale::exponent_denominator == 1 && t_scale::power_of_ten::den == 1> {};
+
+		/**
+		 * A scaling factor as type T, which is guaranteed to be computed at
+		 * compile time whenever it can be, even without optimisations
+		 */
+		template<typename t_scale, typename T, bool t_constant = ScaleIsConstant<t_scale>::value>
+		struct ScaleFactor
+		{
+			MESI_INLINE static constexpr T value()
+			{
+				constexpr T v = t_scale::template value<T>();
+				return v;
+			}
+		};
+
+		/**
+		 * Scaling factors with a root or a fractional power of ten need
+		 * pow() at run time. In constant expressions, floating point
+		 * factors are computed with constantValue() instead, where the
+		 * compiler can tell them apart.
+		 */
+		template<typename t_scale, typename T>
+		struct ScaleFactor<t_scale, T, false>
+		{
+			MESI_INLINE static constexpr T value()
+			{
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+				// Conversions check this with StrictScaleCheck first, for a
+				// message that names the two types; this catches any other use
+				static_assert(ScaleIsConstant<t_scale>::value, "MESI_STRICT_CONSTEXPR_SCALES: a root or a fractional power of ten can only be computed at run time");
+				return t_scale::template value<T>();
+#else
+				return std::is_floating_point<T>::value && MESI_CONSTANT_EVALUATED() ? t_scale::template constantValue<T>() : t_scale::template value<T>();
+#endif
+			}
+		};
+
+		/**
+		 * Checks a conversion from t_from to t_to, which multiplies by
+		 * t_factor, in MESI_STRICT_CONSTEXPR_SCALES mode. The two types
+		 * appear in the compiler's diagnostic as the arguments of this
+		 * template.
+		 */
+		template<typename t_from, typename t_to, typename t_factor>
+		struct StrictScaleCheck
+		{
+			static_assert(ScaleIsConstant<t_factor>::value,
+				"MESI_STRICT_CONSTEXPR_SCALES: converting from t_from to t_to needs a root or a fractional power of ten, which can only be computed at run time");
+			static_assert(!std::is_integral<typename t_to::BaseType>::value || (t_factor::ratio::den == 1 && t_factor::power_of_ten::num >= 0),
+				"MESI_STRICT_CONSTEXPR_SCALES: converting integers from t_from to t_to needs a factor below one, which is not an integer");
+			static constexpr bool value = true;
+		};
+	}
+
 /* Utility macro for applying another macro to all known units, for internal use only */
 #define ALL_UNITS(op) op(m) op(s) op(kg) op(A) op(K) op(mol) op(cd)
 
+
 	template<typename T, typename U>
 	struct TypeOperationsDefaults
 	{
@@ -331,6 +629,12 @@ namespace Mesi {
 	public:
 		using ScalarType = RationalTypeReduced<T, Zero, Zero, Zero, Zero, Zero, Zero, Zero, _internal::ScaleOne>;
 
+		/**
+		 * The same unit with a different storage type, e.g. std::complex<T>
+		 */
+		template<typename U>
+		using WithBaseType = RationalTypeReduced<U, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale>;
+
 		template<typename t_scale_ratio, intmax_t t_scale_exponent_denominator, typename t_scale_10_to_the>
 		using Scale = RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, typename _internal::ScaleMultiply<t_scale, _internal::Scale<t_scale_ratio, t_scale_exponent_denominator, t_scale_10_to_the>>::Scale>;
 
@@ -356,30 +660,30 @@ namespace Mesi {
 
 		T val;
 
-		constexpr RationalTypeReduced()
+		MESI_INLINE constexpr RationalTypeReduced()
 		{}
 
-		constexpr explicit RationalTypeReduced(T const in)
+		MESI_INLINE constexpr explicit RationalTypeReduced(T const in)
 			:val(in)
 		{}
 
-		constexpr RationalTypeReduced(RationalTypeReduced const& in)
-			:val(in.val)
-		{}
-
 		template<typename U>
-		constexpr RationalTypeReduced(RationalTypeReduced<U, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale> const& in)
+		MESI_INLINE constexpr RationalTypeReduced(RationalTypeReduced<U, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale> const& in)
 			:val(in.val)
 		{}
 
-		explicit operator T() const {
+		MESI_INLINE explicit constexpr operator T() const {
 			return val;
 		}
 
 		template<typename t_scale2>
-		explicit constexpr operator RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale2>() const {
+		MESI_INLINE explicit constexpr operator RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale2>() const {
 			using Scale = typename _internal::ScaleMultiply<t_scale, typename t_scale2::Inverse>::Scale;
-			T nv = val * Scale::template value<T>();
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+			static_assert(_internal::StrictScaleCheck<RationalTypeReduced, RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale2>, Scale>::value, "Strict scale check");
+#endif
+			MESI_INSTRUMENT_EVENT(Conversion, &getUnit, (&RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale2>::getUnit));
+			T nv = val * _internal::ScaleFactor<Scale, T>::value();
 
 			return RationalTypeReduced<T, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale2>(nv);
 		}
@@ -388,83 +692,40 @@ namespace Mesi {
 		 * getUnit will get a SI-style unit string for this class
 		 */
 		static std::string getUnit() {
-			static std::string s_unitString("");
-			if( s_unitString.size() > 0 )
-				return s_unitString;
-
-			if( t_scale::ratio::num != 1 )
-			{
-				s_unitString += " * ";
-				if( t_scale::exponent_denominator != 1 && t_scale::ratio::den != 1 )
-				{
-					s_unitString += "(";
-				}
-				s_unitString += std::to_string(t_scale::ratio::num);
-				if( t_scale::ratio::den != 1 )
-				{
-					s_unitString += "/" + std::to_string(t_scale::ratio::den);
-				}
-				if( t_scale::exponent_denominator != 1 )
-				{
-					if( t_scale::ratio::den != 1 )
-					{
-						s_unitString += ")";
-					}
-					s_unitString += "^(1/";
-					s_unitString += std::to_string(t_scale::exponent_denominator);
-					s_unitString += ")";
-				}
-				s_unitString += " ";
-			}
-
-			if( t_scale::power_of_ten::num != 0 )
-			{
-				s_unitString += "* 10^";
-				if(t_scale::power_of_ten::den != 1)
-				{
-					s_unitString += "(";
-				}
-				s_unitString += std::to_string(t_scale::power_of_ten::num);
-				if(t_scale::power_of_ten::den != 1)
-				{
-					s_unitString += "/" + std::to_string(t_scale::power_of_ten::den) + ")";
-				}
-				s_unitString += " ";
-			}
-
-#define DIM_TO_STRING(TP) if( t_##TP ::num == 1 && t_##TP ::den == 1 ) s_unitString += std::string(#TP) + " "; else if( t_##TP ::num != 0 && t_##TP ::den == 1) s_unitString += std::string(#TP) + "^" + std::to_string(static_cast<long long>(t_##TP ::num)) + " "; else if(t_##TP ::num != 0) s_unitString += std::string(#TP) + "^(" + std::to_string(static_cast<long long>(t_##TP ::num)) + "/" + std::to_string(static_cast<long long>(t_##TP ::den)) + ") ";
-			ALL_UNITS(DIM_TO_STRING)
-#undef DIM_TO_STRING
-
-			s_unitString = s_unitString.substr(0, s_unitString.size() - 1);
+#define DIM_INFO(TP) { t_##TP ::num, t_##TP ::den },
+			static std::string const s_unitString = _internal::unitString(_internal::UnitInfo{
+				t_scale::ratio::num, t_scale::ratio::den, t_scale::exponent_denominator,
+				t_scale::power_of_ten::num, t_scale::power_of_ten::den,
+				{ ALL_UNITS(DIM_INFO) } });
+#undef DIM_INFO
 			return s_unitString;
 		}
 
-		constexpr RationalTypeReduced& operator+=(
+		MESI_INLINE constexpr RationalTypeReduced& operator+=(
 			RationalTypeReduced const& rhs
 		) {
 			return (*this) = (*this) + rhs;
 		}
 
-		constexpr RationalTypeReduced& operator-=(
+		MESI_INLINE constexpr RationalTypeReduced& operator-=(
 			RationalTypeReduced const& rhs
 		) {
 			return (*this) = (*this) - rhs;
 		}
 
-		constexpr RationalTypeReduced& operator*=(T const& rhs) {
+		MESI_INLINE constexpr RationalTypeReduced& operator*=(T const& rhs) {
 			return (*this) = (*this) * rhs;
 		}
 
-		constexpr RationalTypeReduced& operator/=(T const& rhs) {
+		MESI_INLINE constexpr RationalTypeReduced& operator/=(T const& rhs) {
 			return (*this) = (*this) / rhs;
 		}
 
-		constexpr RationalTypeReduced& operator*=(ScalarType const& rhs) {
+		MESI_INLINE constexpr RationalTypeReduced& operator*=(ScalarType const& rhs) {
 			return (*this) = (*this) * rhs;
 		}
 
-		constexpr RationalTypeReduced& operator/=(ScalarType const& rhs) {
+		MESI_INLINE constexpr RationalTypeReduced& operator/=(ScalarType const& rhs) {
 			return (*this) = (*this) / rhs;
 		}
 	};
@@ -480,7 +741,7 @@ namespace Mesi {
 	 * Arithmatic operators for combining SI values.
 	 */
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr auto operator+(
+	MESI_INLINE constexpr auto operator+(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -488,7 +749,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr auto operator-(
+	MESI_INLINE constexpr auto operator-(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -496,7 +757,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS, TYPE_B_FULL_PARAMS>
-	constexpr auto operator*(
+	MESI_INLINE constexpr auto operator*(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_B_PARAMS> const& right
 	) {
@@ -508,7 +769,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS, TYPE_B_FULL_PARAMS>
-	constexpr auto operator/(
+	MESI_INLINE constexpr auto operator/(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_B_PARAMS> const& right
 	) {
@@ -524,14 +785,14 @@ namespace Mesi {
 	 */
 
 	template<typename T, TYPE_A_FULL_PARAMS>
-	constexpr auto operator-(
+	MESI_INLINE constexpr auto operator-(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& op
 	) {
 		return RationalTypeReduced<T, TYPE_A_PARAMS>(-op.val);
 	}
 
 	template<typename T, TYPE_A_FULL_PARAMS>
-	constexpr auto operator+(
+	MESI_INLINE constexpr auto operator+(
 			RationalTypeReduced<T, TYPE_A_PARAMS> const& op
 	) {
 		return RationalTypeReduced<T, TYPE_A_PARAMS>(op);
@@ -542,7 +803,7 @@ namespace Mesi {
 	 */
 
 	template<typename T, TYPE_A_FULL_PARAMS, typename S>
-	constexpr auto operator*(
+	MESI_INLINE constexpr auto operator*(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		S const& right
 	) {
@@ -550,7 +811,7 @@ namespace Mesi {
 	}
 
 	template<typename T, TYPE_A_FULL_PARAMS, typename S>
-	constexpr auto operator*(
+	MESI_INLINE constexpr auto operator*(
 		S const & left,
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& right
 	) {
@@ -558,7 +819,7 @@ namespace Mesi {
 	}
 
 	template<typename T, TYPE_A_FULL_PARAMS, typename S>
-	constexpr auto operator/(
+	MESI_INLINE constexpr auto operator/(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		S const& right
 	) {
@@ -567,7 +828,7 @@ namespace Mesi {
 	}
 
 	template<typename T, TYPE_A_FULL_PARAMS, typename S>
-	constexpr auto operator/(
+	MESI_INLINE constexpr auto operator/(
 		S const & left,
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& right
 	) {
@@ -579,7 +840,7 @@ namespace Mesi {
 	 * Comparison operators
 	 */
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator==(
+	MESI_INLINE constexpr bool operator==(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -587,7 +848,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator<(
+	MESI_INLINE constexpr bool operator<(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -595,7 +856,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator!=(
+	MESI_INLINE constexpr bool operator!=(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -603,7 +864,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator<=(
+	MESI_INLINE constexpr bool operator<=(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -611,7 +872,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator>(
+	MESI_INLINE constexpr bool operator>(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -619,7 +880,7 @@ namespace Mesi {
 	}
 
 	template<typename T, typename U, TYPE_A_FULL_PARAMS>
-	constexpr bool operator>=(
+	MESI_INLINE constexpr bool operator>=(
 		RationalTypeReduced<T, TYPE_A_PARAMS> const& left,
 		RationalTypeReduced<U, TYPE_A_PARAMS> const& right
 	) {
@@ -627,11 +888,32 @@ namespace Mesi {
 	}
 
 	template<typename t_pow_ratio, typename T, TYPE_A_FULL_PARAMS>
-	auto pow(RationalTypeReduced<T, TYPE_A_PARAMS> v)
+	MESI_INLINE auto pow(RationalTypeReduced<T, TYPE_A_PARAMS> v)
 	{
+		MESI_INSTRUMENT_EVENT(Pow, (&RationalTypeReduced<T, TYPE_A_PARAMS>::getUnit), (&RationalTypeReduced<T, TYPE_A_PARAMS>::template Pow<t_pow_ratio>::getUnit));
 		return typename RationalTypeReduced<T, TYPE_A_PARAMS>::template Pow<t_pow_ratio>(std::pow(T(v.val), T(t_pow_ratio::num)/T(t_pow_ratio::den)));
 	}
 
+	namespace _internal {
+		/**
+		 * Views an array of Mesi values as an array of their storage type.
+		 * Mesi types hold nothing but their value, so the layouts match.
+		 */
+		template<typename Q>
+		typename Q::BaseType* raw(Q* q)
+		{
+			static_assert(sizeof(Q) == sizeof(typename Q::BaseType) && std::is_standard_layout<Q>::value, "Mesi types must have the layout of their storage type");
+			return reinterpret_cast<typename Q::BaseType*>(q);
+		}
+
+		template<typename Q>
+		typename Q::BaseType const* raw(Q const* q)
+		{
+			static_assert(sizeof(Q) == sizeof(typename Q::BaseType) && std::is_standard_layout<Q>::value, "Mesi types must have the layout of their storage type");
+			return reinterpret_cast<typename Q::BaseType const*>(q);
+		}
+	}
+
 #undef TYPE_A_FULL_PARAMS
 #undef TYPE_A_PARAMS
 #undef TYPE_B_FULL_PARAMS
@@ -647,6 +929,14 @@ namespace Mesi {
 
 #ifndef MESI_LITERAL_TYPE
 #	define MESI_LITERAL_TYPE float
+#endif
+
+	/*
+	 * Alignment in bytes used by containers of Mesi types that are meant to
+	 * be processed with SIMD instructions
+	 */
+#ifndef MESI_SIMD_ALIGNMENT
+#	define MESI_SIMD_ALIGNMENT 32
 #endif
 
 	template<intmax_t t_power, typename T>
@@ -0,0 +1,532 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	/*
+	 * Plane angles. An angle is dimensionless, but it is kept apart from
+	 * Scalar so that radians and degrees cannot be mixed up: AngleType only
+	 * combines with angles of the same scale, plain numbers and Scalars, and
+	 * leaves the tag only through radians(). Degrees are radians scaled by
+	 * pi/180 through the usual Scale mechanism. pi is irrational, so the
+	 * ratio is the continued fraction convergent 21023143/1204537366, which
+	 * is within 2.2e-18 of pi/180 and so rounds to the same double.
+	 */
+	namespace _internal {
+		using DegreeRatio = std::ratio<21023143, 1204537366>;
+	}
+
+	/**
+	 * An angle stored as T, in radians times t_scale
+	 */
+	template<typename T, typename t_scale = _internal::ScaleOne>
+	struct AngleType
+	{
+		using BaseType = T;
+		using ScaleInfo = t_scale;
+		using ScalarType = Type<T, 0, 0, 0>;
+
+		/**
+		 * The same angle with a different storage type
+		 */
+		template<typename U>
+		using WithBaseType = AngleType<U, t_scale>;
+
+		template<typename t_scale_ratio, intmax_t t_scale_exponent_denominator, typename t_scale_10_to_the>
+		using Scale = AngleType<T, typename _internal::ScaleMultiply<t_scale, _internal::Scale<t_scale_ratio, t_scale_exponent_denominator, t_scale_10_to_the>>::Scale>;
+
+		template<intmax_t t_scale_by>
+		using Multiply = Scale<std::ratio<t_scale_by, 1>, 1, std::ratio<0,1>>;
+
+		template<intmax_t t_scale_by>
+		using Divide = Scale<std::ratio<1, t_scale_by>, 1, std::ratio<0,1>>;
+
+		T val;
+
+		MESI_INLINE constexpr AngleType()
+		{}
+
+		MESI_INLINE constexpr explicit AngleType(T const in)
+			:val(in)
+		{}
+
+		template<typename U>
+		MESI_INLINE constexpr AngleType(AngleType<U, t_scale> const& in)
+			:val(in.val)
+		{}
+
+		MESI_INLINE explicit constexpr operator T() const {
+			return val;
+		}
+
+		template<typename t_scale2>
+		MESI_INLINE explicit constexpr operator AngleType<T, t_scale2>() const {
+			using Scale = typename _internal::ScaleMultiply<t_scale, typename t_scale2::Inverse>::Scale;
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+			static_assert(_internal::StrictScaleCheck<AngleType, AngleType<T, t_scale2>, Scale>::value, "Strict scale check");
+#endif
+			return AngleType<T, t_scale2>(val * _internal::ScaleFactor<Scale, T>::value());
+		}
+
+		/**
+		 * The angle in radians as a Scalar, e.g. to compute an arc length
+		 * as radius * angle.radians()
+		 */
+		MESI_INLINE constexpr ScalarType radians() const {
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+			static_assert(_internal::StrictScaleCheck<AngleType, AngleType<T>, t_scale>::value, "Strict scale check");
+#endif
+			return ScalarType(val * _internal::ScaleFactor<t_scale, T>::value());
+		}
+
+		/**
+		 * getUnit will get a unit string in the format of
+		 * RationalTypeReduced::getUnit, with rad as the unit
+		 */
+		static std::string getUnit() {
+			static std::string const s_unitString = t_scale::getUnit().empty() ? std::string("rad") : t_scale::getUnit() + " rad";
+			return s_unitString;
+		}
+
+		MESI_INLINE constexpr AngleType& operator+=(AngleType const& rhs) {
+			return (*this) = (*this) + rhs;
+		}
+
+		MESI_INLINE constexpr AngleType& operator-=(AngleType const& rhs) {
+			return (*this) = (*this) - rhs;
+		}
+
+		MESI_INLINE constexpr AngleType& operator*=(T const& rhs) {
+			return (*this) = (*this) * rhs;
+		}
+
+		MESI_INLINE constexpr AngleType& operator/=(T const& rhs) {
+			return (*this) = (*this) / rhs;
+		}
+	};
+
+	using Radians = AngleType<MESI_LITERAL_TYPE>;
+	using Degrees = Radians::Scale<_internal::DegreeRatio, 1, std::ratio<0,1>>;
+
+	/*
+	 * Arithmetic on angles. Plain numbers and Scalars scale an angle;
+	 * anything with a unit has to go through radians().
+	 */
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr auto operator+(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return AngleType<typename TypeOperations<T,U>::AddResult, t_scale>(left.val + right.val);
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr auto operator-(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return AngleType<typename TypeOperations<T,U>::SubtractResult, t_scale>(left.val - right.val);
+	}
+
+	template<typename T, typename t_scale>
+	MESI_INLINE constexpr auto operator-(AngleType<T, t_scale> const& op)
+	{
+		return AngleType<T, t_scale>(-op.val);
+	}
+
+	template<typename T, typename t_scale>
+	MESI_INLINE constexpr auto operator+(AngleType<T, t_scale> const& op)
+	{
+		return op;
+	}
+
+	/**
+	 * The ratio of two angles of the same scale
+	 */
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr auto operator/(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return Type<typename TypeOperations<T,U>::DivideResult, 0, 0, 0>(left.val / right.val);
+	}
+
+	template<typename T, typename t_scale, typename S, typename = std::enable_if_t<std::is_arithmetic<S>::value>>
+	MESI_INLINE constexpr auto operator*(AngleType<T, t_scale> const& left, S const& right)
+	{
+		return AngleType<typename TypeOperations<T,S>::MultiplyResult, t_scale>(left.val * right);
+	}
+
+	template<typename T, typename t_scale, typename S, typename = std::enable_if_t<std::is_arithmetic<S>::value>>
+	MESI_INLINE constexpr auto operator*(S const& left, AngleType<T, t_scale> const& right)
+	{
+		return right * left;
+	}
+
+	template<typename T, typename t_scale, typename S, typename = std::enable_if_t<std::is_arithmetic<S>::value>>
+	MESI_INLINE constexpr auto operator/(AngleType<T, t_scale> const& left, S const& right)
+	{
+		return AngleType<typename TypeOperations<T,S>::DivideResult, t_scale>(left.val / right);
+	}
+
+	template<typename T, typename t_scale, typename U, typename Z>
+	MESI_INLINE constexpr auto operator*(AngleType<T, t_scale> const& left, RationalTypeReduced<U, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& right)
+	{
+		static_assert(Z::num == 0, "Angles can only be multiplied by Scalars");
+		return left * right.val;
+	}
+
+	template<typename T, typename t_scale, typename U, typename Z>
+	MESI_INLINE constexpr auto operator*(RationalTypeReduced<U, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& left, AngleType<T, t_scale> const& right)
+	{
+		static_assert(Z::num == 0, "Angles can only be multiplied by Scalars");
+		return right * left.val;
+	}
+
+	template<typename T, typename t_scale, typename U, typename Z>
+	MESI_INLINE constexpr auto operator/(AngleType<T, t_scale> const& left, RationalTypeReduced<U, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& right)
+	{
+		static_assert(Z::num == 0, "Angles can only be divided by Scalars");
+		return left / right.val;
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator==(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return left.val == right.val;
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator!=(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return !(left == right);
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator<(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return left.val < right.val;
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator<=(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return left.val <= right.val;
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator>(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return right < left;
+	}
+
+	template<typename T, typename U, typename t_scale>
+	MESI_INLINE constexpr bool operator>=(AngleType<T, t_scale> const& left, AngleType<U, t_scale> const& right)
+	{
+		return right <= left;
+	}
+
+	/*
+	 * Trigonometry. The functions on single angles use the standard
+	 * library; the ones on arrays use the polynomials below.
+	 */
+
+	/**
+	 * The sine and cosine of an angle
+	 */
+	template<typename S>
+	struct SinCos
+	{
+		S sin;
+		S cos;
+	};
+
+	template<typename T, typename t_scale>
+	auto sin(AngleType<T, t_scale> const& a)
+	{
+		using std::sin;
+		return Type<T, 0, 0, 0>(sin(a.radians().val));
+	}
+
+	template<typename T, typename t_scale>
+	auto cos(AngleType<T, t_scale> const& a)
+	{
+		using std::cos;
+		return Type<T, 0, 0, 0>(cos(a.radians().val));
+	}
+
+	template<typename T, typename t_scale>
+	auto tan(AngleType<T, t_scale> const& a)
+	{
+		using std::tan;
+		return Type<T, 0, 0, 0>(tan(a.radians().val));
+	}
+
+	template<typename T, typename t_scale>
+	SinCos<Type<T, 0, 0, 0>> sincos(AngleType<T, t_scale> const& a)
+	{
+		using std::sin;
+		using std::cos;
+		T const r = a.radians().val;
+		return SinCos<Type<T, 0, 0, 0>>{ Type<T, 0, 0, 0>(sin(r)), Type<T, 0, 0, 0>(cos(r)) };
+	}
+
+	/**
+	 * The angle of the point (x, y), e.g. of two lengths. Both need the
+	 * same unit, so their ratio does not depend on its scale.
+	 */
+	template<typename T, typename U, typename... t_unit>
+	auto atan2(RationalTypeReduced<T, t_unit...> const& y, RationalTypeReduced<U, t_unit...> const& x)
+	{
+		using std::atan2;
+		using R = decltype(atan2(y.val, x.val));
+		return AngleType<R>(atan2(y.val, x.val));
+	}
+
+	template<typename T, typename Z>
+	auto asin(RationalTypeReduced<T, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& v)
+	{
+		static_assert(Z::num == 0, "asin needs a Scalar");
+		using std::asin;
+		return AngleType<T>(asin(v.val));
+	}
+
+	template<typename T, typename Z>
+	auto acos(RationalTypeReduced<T, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& v)
+	{
+		static_assert(Z::num == 0, "acos needs a Scalar");
+		using std::acos;
+		return AngleType<T>(acos(v.val));
+	}
+
+	template<typename T, typename Z>
+	auto atan(RationalTypeReduced<T, Z, Z, Z, Z, Z, Z, Z, _internal::ScaleOne> const& v)
+	{
+		static_assert(Z::num == 0, "atan needs a Scalar");
+		using std::atan;
+		return AngleType<T>(atan(v.val));
+	}
+
+	namespace _internal {
+		/**
+		 * Polynomial sine and cosine for storage type T. The argument is
+		 * reduced to [-pi/4, pi/4] by subtracting a multiple of pi/2 in
+		 * three parts dp1 + dp2 + dp3, each short enough for the product
+		 * with the multiple to be exact below limit(). Beyond it, and for
+		 * types without polynomials, the standard library is used.
+		 *
+		 * The reduction depends on the order of its subtractions, so it
+		 * loses accuracy if the compiler may reassociate them, as with
+		 * -ffast-math. The coefficients are those of the Cephes library.
+		 */
+		template<typename T>
+		struct TrigPolynomial
+		{
+			static constexpr bool available = false;
+		};
+
+		template<>
+		struct TrigPolynomial<float>
+		{
+			static constexpr bool available = true;
+			static constexpr float limit() { return 8192.0f; }
+			static constexpr float fourOverPi() { return 1.27323954473516f; }
+			static constexpr float dp1() { return 0.78515625f; }
+			static constexpr float dp2() { return 2.4187564849853515625e-4f; }
+			static constexpr float dp3() { return 3.77489497744594108e-8f; }
+
+			MESI_INLINE static constexpr float sin(float x, float z)
+			{
+				return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+			}
+
+			MESI_INLINE static constexpr float cos(float z)
+			{
+				return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+			}
+		};
+
+		template<>
+		struct TrigPolynomial<double>
+		{
+			static constexpr bool available = true;
+			static constexpr double limit() { return 1073741824.0; }
+			static constexpr double fourOverPi() { return 1.27323954473516268615; }
+			static constexpr double dp1() { return 7.85398125648498535156e-1; }
+			static constexpr double dp2() { return 3.77489470793079817668e-8; }
+			static constexpr double dp3() { return 2.69515142907905952645e-15; }
+
+			MESI_INLINE static constexpr double sin(double x, double z)
+			{
+				return x + x * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z
+					+ 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z
+					+ 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+			}
+
+			MESI_INLINE static constexpr double cos(double z)
+			{
+				return 1.0 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z
+					- 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z
+					- 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+			}
+		};
+
+		/**
+		 * Computes the sine and/or cosine of in[i] * factor for each i, as
+		 * selected by t_sin and t_cos. The input is processed in blocks:
+		 * blocks whose arguments are all within limit() take a loop without
+		 * branches, so that it vectorises, and any other block is done one
+		 * argument at a time, with the standard library beyond limit().
+		 */
+		template<typename T, bool t_polynomial = TrigPolynomial<T>::available>
+		struct BulkTrig
+		{
+			using P = TrigPolynomial<T>;
+
+			/**
+			 * Evaluates the polynomials for x, which must be within limit()
+			 */
+			template<bool t_sin, bool t_cos>
+			MESI_INLINE static void evaluate(T const x, T* sinOut, T* cosOut, std::size_t i)
+			{
+				T const ax = std::abs(x);
+
+				// Round the octant up to even, making q/2 the quadrant
+				std::int32_t const q = (std::int32_t(ax * P::fourOverPi()) + 1) & ~std::int32_t(1);
+				T const y = T(q);
+				T const r = ((ax - y * P::dp1()) - y * P::dp2()) - y * P::dp3();
+				T const z = r * r;
+				T const s = P::sin(r, z);
+				T const c = P::cos(z);
+				std::int32_t const quadrant = (q >> 1) & 3;
+				if(t_sin)
+				{
+					T const v = (quadrant & 1) ? c : s;
+					sinOut[i] = ((quadrant >> 1) ^ std::int32_t(x < T(0))) ? -v : v;
+				}
+				if(t_cos)
+				{
+					T const v = (quadrant & 1) ? s : c;
+					cosOut[i] = ((quadrant + 1) & 2) ? -v : v;
+				}
+			}
+
+			template<bool t_sin, bool t_cos>
+			static void run(T const* in, std::size_t n, T factor, T* sinOut, T* cosOut)
+			{
+				constexpr std::size_t block = 256;
+				for(std::size_t begin = 0; begin < n; begin += block)
+				{
+					std::size_t const end = n - begin < block ? n : begin + block;
+					std::int32_t outside = 0;
+					for(std::size_t i = begin; i < end; i++)
+					{
+						outside += !(std::abs(in[i] * factor) <= P::limit());
+					}
+					if(!outside)
+					{
+						for(std::size_t i = begin; i < end; i++)
+						{
+							evaluate<t_sin, t_cos>(in[i] * factor, sinOut, cosOut, i);
+						}
+						continue;
+					}
+					for(std::size_t i = begin; i < end; i++)
+					{
+						T const x = in[i] * factor;
+						if(std::abs(x) <= P::limit())
+						{
+							evaluate<t_sin, t_cos>(x, sinOut, cosOut, i);
+							continue;
+						}
+						if(t_sin)
+						{
+							sinOut[i] = std::sin(x);
+						}
+						if(t_cos)
+						{
+							cosOut[i] = std::cos(x);
+						}
+					}
+				}
+			}
+		};
+
+		template<typename T>
+		struct BulkTrig<T, false>
+		{
+			template<bool t_sin, bool t_cos>
+			static void run(T const* in, std::size_t n, T factor, T* sinOut, T* cosOut)
+			{
+				using std::sin;
+				using std::cos;
+				for(std::size_t i = 0; i < n; i++)
+				{
+					T const x = in[i] * factor;
+					if(t_sin)
+					{
+						sinOut[i] = sin(x);
+					}
+					if(t_cos)
+					{
+						cosOut[i] = cos(x);
+					}
+				}
+			}
+		};
+	}
+
+	namespace _internal {
+		/**
+		 * The factor from angles in t_scale to radians
+		 */
+		template<typename T, typename t_scale>
+		MESI_INLINE constexpr T radiansFactor()
+		{
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+			static_assert(StrictScaleCheck<AngleType<T, t_scale>, AngleType<T>, t_scale>::value, "Strict scale check");
+#endif
+			return ScaleFactor<t_scale, T>::value();
+		}
+	}
+
+	/**
+	 * Writes the sines of n angles to out. For float and double storage
+	 * this evaluates polynomials that vectorise, with an absolute error
+	 * below 1e-7 for float and 2e-16 for double while |angle| is at most
+	 * 8192 rad for float or 2^30 rad for double, and falls back to
+	 * std::sin beyond.
+	 */
+	template<typename T, typename t_scale>
+	void sin(AngleType<T, t_scale> const* in, std::size_t n, Type<T, 0, 0, 0>* out)
+	{
+		_internal::BulkTrig<T>::template run<true, false>(_internal::raw(in), n, _internal::radiansFactor<T, t_scale>(), _internal::raw(out), nullptr);
+	}
+
+	/**
+	 * Writes the cosines of n angles to out, as sin() does the sines
+	 */
+	template<typename T, typename t_scale>
+	void cos(AngleType<T, t_scale> const* in, std::size_t n, Type<T, 0, 0, 0>* out)
+	{
+		_internal::BulkTrig<T>::template run<false, true>(_internal::raw(in), n, _internal::radiansFactor<T, t_scale>(), nullptr, _internal::raw(out));
+	}
+
+	/**
+	 * Writes the sines and cosines of n angles to sinOut and cosOut in a
+	 * single pass, as sin() does the sines
+	 */
+	template<typename T, typename t_scale>
+	void sincos(AngleType<T, t_scale> const* in, std::size_t n, Type<T, 0, 0, 0>* sinOut, Type<T, 0, 0, 0>* cosOut)
+	{
+		_internal::BulkTrig<T>::template run<true, true>(_internal::raw(in), n, _internal::radiansFactor<T, t_scale>(), _internal::raw(sinOut), _internal::raw(cosOut));
+	}
+
+	namespace Literals {
+		constexpr auto operator "" _rad(long double arg) { return Mesi::Radians(arg); }
+		constexpr auto operator "" _rad(unsigned long long arg) { return Mesi::Radians(arg); }
+		constexpr auto operator "" _deg(long double arg) { return Mesi::Degrees(arg); }
+		constexpr auto operator "" _deg(unsigned long long arg) { return Mesi::Degrees(arg); }
+	}
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	namespace _internal {
+		/**
+		 * Sums f(i) for i in [0, n) into several independent accumulators,
+		 * so the additions can be vectorised without reassociating
+		 * floating point math
+		 */
+		template<typename T, typename F>
+		T laneSum(std::size_t n, F&& f)
+		{
+			constexpr std::size_t lanes = 8;
+			T acc[lanes] = {};
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+			{
+				for(std::size_t l = 0; l < lanes; l++)
+				{
+					acc[l] += f(i + l);
+				}
+			}
+			for(; i < n; i++)
+			{
+				acc[0] += f(i);
+			}
+			T ret = T(0);
+			for(std::size_t l = 0; l < lanes; l++)
+			{
+				ret += acc[l];
+			}
+			return ret;
+		}
+
+		template<typename Q, typename t_time>
+		using Integral = decltype(Q{} * t_time{});
+
+		template<typename Q, typename t_time>
+		using Rate = decltype(Q{} / t_time{});
+
+		template<typename T>
+		struct IsSpan : std::false_type {};
+
+		template<typename T>
+		struct IsSpan<Span<T>> : std::true_type {};
+
+		/**
+		 * Selects the uniform step overloads, which take the step size in
+		 * place of the array or Span of sample times
+		 */
+		template<typename t_time>
+		using UniformStep = typename std::enable_if<!std::is_pointer<t_time>::value && !IsSpan<t_time>::value>::type;
+
+		inline void checkSamples(std::size_t a, std::size_t b)
+		{
+			if(a != b)
+			{
+				throw std::invalid_argument("The sample spans must have the same size");
+			}
+		}
+	}
+
+	/*
+	 * Every function takes its samples either as a pointer and a count or as
+	 * Mesi::Span, which stands in for std::span until the library moves past
+	 * C++14. The Span forms throw std::invalid_argument if the times, values
+	 * and output do not all have the same size.
+	 */
+
+	/**
+	 * Trapezoidal integral of the n samples y taken at times t
+	 */
+	template<typename Q, typename t_time>
+	_internal::Integral<Q, t_time> trapz(t_time const* t, Q const* y, std::size_t n)
+	{
+		using R = _internal::Integral<Q, t_time>;
+		using T = typename R::BaseType;
+		if(n < 2)
+		{
+			return R(T(0));
+		}
+		T const sum = _internal::laneSum<T>(n - 1, [&](std::size_t i) {
+			return T(t[i + 1].val - t[i].val) * T(y[i + 1].val + y[i].val);
+		});
+		return R(sum / T(2));
+	}
+
+	template<typename t_times, typename t_values>
+	auto trapz(Span<t_times> t, Span<t_values> y)
+	{
+		_internal::checkSamples(t.size(), y.size());
+		return trapz(t.data(), y.data(), y.size());
+	}
+
+	/**
+	 * Trapezoidal integral of the n samples y taken every dt. Only the
+	 * samples are read.
+	 */
+	template<typename Q, typename t_time, typename = _internal::UniformStep<t_time>>
+	_internal::Integral<Q, t_time> trapz(t_time dt, Q const* y, std::size_t n)
+	{
+		using R = _internal::Integral<Q, t_time>;
+		using T = typename R::BaseType;
+		if(n < 2)
+		{
+			return R(T(0));
+		}
+		T const sum = _internal::laneSum<T>(n, [&](std::size_t i) { return T(y[i].val); });
+		return R((sum - T(y[0].val + y[n - 1].val) / T(2)) * T(dt.val));
+	}
+
+	template<typename t_values, typename t_time, typename = _internal::UniformStep<t_time>>
+	auto trapz(t_time dt, Span<t_values> y)
+	{
+		return trapz(dt, y.data(), y.size());
+	}
+
+	/**
+	 * Running trapezoidal integral: out[i] is the integral from t[0] to
+	 * t[i], so out[0] is zero
+	 */
+	template<typename Q, typename t_time>
+	void cumtrapz(t_time const* t, Q const* y, std::size_t n, _internal::Integral<Q, t_time>* out)
+	{
+		using T = typename _internal::Integral<Q, t_time>::BaseType;
+		T acc = T(0);
+		for(std::size_t i = 0; i < n; i++)
+		{
+			if(i > 0)
+			{
+				acc += T(t[i].val - t[i - 1].val) * T(y[i].val + y[i - 1].val) / T(2);
+			}
+			out[i].val = acc;
+		}
+	}
+
+	template<typename t_times, typename t_values, typename t_out>
+	void cumtrapz(Span<t_times> t, Span<t_values> y, Span<t_out> out)
+	{
+		_internal::checkSamples(t.size(), y.size());
+		_internal::checkSamples(y.size(), out.size());
+		cumtrapz(t.data(), y.data(), y.size(), out.data());
+	}
+
+	template<typename Q, typename t_time, typename = _internal::UniformStep<t_time>>
+	void cumtrapz(t_time dt, Q const* y, std::size_t n, _internal::Integral<Q, t_time>* out)
+	{
+		using T = typename _internal::Integral<Q, t_time>::BaseType;
+		T const half = T(dt.val) / T(2);
+		T acc = T(0);
+		for(std::size_t i = 0; i < n; i++)
+		{
+			if(i > 0)
+			{
+				acc += T(y[i].val + y[i - 1].val) * half;
+			}
+			out[i].val = acc;
+		}
+	}
+
+	template<typename t_values, typename t_out, typename t_time, typename = _internal::UniformStep<t_time>>
+	void cumtrapz(t_time dt, Span<t_values> y, Span<t_out> out)
+	{
+		_internal::checkSamples(y.size(), out.size());
+		cumtrapz(dt, y.data(), y.size(), out.data());
+	}
+
+	/**
+	 * Composite Simpson integral of the n samples y taken at times t, using
+	 * the non-uniform form of the rule on pairs of intervals. With an even
+	 * number of samples, the last interval is integrated as a trapezoid.
+	 */
+	template<typename Q, typename t_time>
+	_internal::Integral<Q, t_time> simpson(t_time const* t, Q const* y, std::size_t n)
+	{
+		using R = _internal::Integral<Q, t_time>;
+		using T = typename R::BaseType;
+		if(n < 3)
+		{
+			return trapz(t, y, n);
+		}
+		std::size_t const pairs = (n - 1) / 2;
+		T sum = _internal::laneSum<T>(pairs, [&](std::size_t p) {
+			std::size_t const i = 2 * p;
+			T const h0 = T(t[i + 1].val - t[i].val);
+			T const h1 = T(t[i + 2].val - t[i + 1].val);
+			T const hs = h0 + h1;
+			return hs / T(6) * ((T(2) - h1 / h0) * T(y[i].val) + hs * hs / (h0 * h1) * T(y[i + 1].val) + (T(2) - h0 / h1) * T(y[i + 2].val));
+		});
+		if(n % 2 == 0)
+		{
+			sum += T(t[n - 1].val - t[n - 2].val) * T(y[n - 1].val + y[n - 2].val) / T(2);
+		}
+		return R(sum);
+	}
+
+	template<typename t_times, typename t_values>
+	auto simpson(Span<t_times> t, Span<t_values> y)
+	{
+		_internal::checkSamples(t.size(), y.size());
+		return simpson(t.data(), y.data(), y.size());
+	}
+
+	/**
+	 * Composite Simpson integral of the n samples y taken every dt. With an
+	 * even number of samples, the last three intervals use Simpson's 3/8
+	 * rule.
+	 */
+	template<typename Q, typename t_time, typename = _internal::UniformStep<t_time>>
+	_internal::Integral<Q, t_time> simpson(t_time dt, Q const* y, std::size_t n)
+	{
+		using R = _internal::Integral<Q, t_time>;
+		using T = typename R::BaseType;
+		if(n < 3)
+		{
+			return trapz(dt, y, n);
+		}
+		std::size_t const m = n % 2 == 0 && n >= 4 ? n - 3 : n;
+		T sum = _internal::laneSum<T>((m - 1) / 2, [&](std::size_t p) {
+			std::size_t const i = 2 * p;
+			return T(y[i].val) + T(4) * T(y[i + 1].val) + T(y[i + 2].val);
+		}) / T(3);
+		if(m != n)
+		{
+			sum += T(3) / T(8) * (T(y[m - 1].val) + T(3) * T(y[m].val) + T(3) * T(y[m + 1].val) + T(y[m + 2].val));
+		}
+		return R(sum * T(dt.val));
+	}
+
+	template<typename t_values, typename t_time, typename = _internal::UniformStep<t_time>>
+	auto simpson(t_time dt, Span<t_values> y)
+	{
+		return simpson(dt, y.data(), y.size());
+	}
+
+	/**
+	 * Derivative of the n samples y taken at times t: second order central
+	 * differences inside, first order one-sided differences at both ends
+	 */
+	template<typename Q, typename t_time>
+	void gradient(t_time const* t, Q const* y, std::size_t n, _internal::Rate<Q, t_time>* out)
+	{
+		using T = typename _internal::Rate<Q, t_time>::BaseType;
+		if(n < 2)
+		{
+			for(std::size_t i = 0; i < n; i++)
+			{
+				out[i].val = T(0);
+			}
+			return;
+		}
+		out[0].val = T(y[1].val - y[0].val) / T(t[1].val - t[0].val);
+		for(std::size_t i = 1; i + 1 < n; i++)
+		{
+			T const h0 = T(t[i].val - t[i - 1].val);
+			T const h1 = T(t[i + 1].val - t[i].val);
+			out[i].val = (h0 * h0 * T(y[i + 1].val) - h1 * h1 * T(y[i - 1].val) + (h1 * h1 - h0 * h0) * T(y[i].val)) / (h0 * h1 * (h0 + h1));
+		}
+		out[n - 1].val = T(y[n - 1].val - y[n - 2].val) / T(t[n - 1].val - t[n - 2].val);
+	}
+
+	template<typename t_times, typename t_values, typename t_out>
+	void gradient(Span<t_times> t, Span<t_values> y, Span<t_out> out)
+	{
+		_internal::checkSamples(t.size(), y.size());
+		_internal::checkSamples(y.size(), out.size());
+		gradient(t.data(), y.data(), y.size(), out.data());
+	}
+
+	/**
+	 * Derivative of the n samples y taken every dt. Only the samples are
+	 * read.
+	 */
+	template<typename Q, typename t_time, typename = _internal::UniformStep<t_time>>
+	void gradient(t_time dt, Q const* y, std::size_t n, _internal::Rate<Q, t_time>* out)
+	{
+		using T = typename _internal::Rate<Q, t_time>::BaseType;
+		if(n < 2)
+		{
+			for(std::size_t i = 0; i < n; i++)
+			{
+				out[i].val = T(0);
+			}
+			return;
+		}
+		T const inv = T(1) / T(dt.val);
+		T const inv2 = inv / T(2);
+		out[0].val = T(y[1].val - y[0].val) * inv;
+		for(std::size_t i = 1; i + 1 < n; i++)
+		{
+			out[i].val = T(y[i + 1].val - y[i - 1].val) * inv2;
+		}
+		out[n - 1].val = T(y[n - 1].val - y[n - 2].val) * inv;
+	}
+
+	template<typename t_values, typename t_out, typename t_time, typename = _internal::UniformStep<t_time>>
+	void gradient(t_time dt, Span<t_values> y, Span<t_out> out)
+	{
+		_internal::checkSamples(y.size(), out.size());
+		gradient(dt, y.data(), y.size(), out.data());
+	}
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	/**
+	 * Names a component with the value type Q, so that a pool can hold
+	 * several components of one quantity type, e.g.
+	 *
+	 *     struct VelocityX;
+	 *     using Vx = Component<VelocityX, decltype(Meters{} / Seconds{})>;
+	 *
+	 * Quantity types can also be used as components directly.
+	 */
+	template<typename t_name, typename Q>
+	struct Component
+	{
+		using Value = Q;
+	};
+
+	namespace _internal {
+		template<typename C>
+		struct ComponentValue
+		{
+			using Type = C;
+		};
+
+		template<typename t_name, typename Q>
+		struct ComponentValue<Component<t_name, Q>>
+		{
+			using Type = Q;
+		};
+
+		/**
+		 * Position of C in t_list
+		 */
+		template<typename C, typename... t_list>
+		struct ComponentIndex
+		{
+			static_assert(!std::is_same<C, C>::value, "The component is not part of the pool");
+			static constexpr std::size_t value = 0;
+		};
+
+		template<typename C, typename... t_rest>
+		struct ComponentIndex<C, C, t_rest...> : std::integral_constant<std::size_t, 0> {};
+
+		template<typename C, typename t_first, typename... t_rest>
+		struct ComponentIndex<C, t_first, t_rest...> : std::integral_constant<std::size_t, 1 + ComponentIndex<C, t_rest...>::value> {};
+
+		/**
+		 * Whether no type appears twice in t_list
+		 */
+		template<typename... t_list>
+		struct ComponentsUnique : std::true_type {};
+
+		template<typename t_first, typename... t_rest>
+		struct ComponentsUnique<t_first, t_rest...> : std::integral_constant<bool,
+			ComponentIndex<t_first, t_rest..., t_first>::value == sizeof...(t_rest) && ComponentsUnique<t_rest...>::value> {};
+
+		/**
+		 * Allocator for arrays that start on a MESI_SIMD_ALIGNMENT byte
+		 * boundary. The address returned by operator new is kept just
+		 * before the array.
+		 */
+		template<typename T>
+		struct AlignedAllocator
+		{
+			using value_type = T;
+
+			template<typename U>
+			struct rebind
+			{
+				using other = AlignedAllocator<U>;
+			};
+
+			AlignedAllocator() = default;
+
+			template<typename U>
+			AlignedAllocator(AlignedAllocator<U> const&)
+			{}
+
+			T* allocate(std::size_t n)
+			{
+				static_assert(MESI_SIMD_ALIGNMENT >= alignof(void*) && (MESI_SIMD_ALIGNMENT & (MESI_SIMD_ALIGNMENT - 1)) == 0,
+					"MESI_SIMD_ALIGNMENT must be a power of two of at least the alignment of a pointer");
+				if(n > (std::numeric_limits<std::size_t>::max() - MESI_SIMD_ALIGNMENT - sizeof(void*)) / sizeof(T))
+				{
+					throw std::bad_alloc();
+				}
+				void* const raw = ::operator new(n * sizeof(T) + MESI_SIMD_ALIGNMENT + sizeof(void*));
+				std::uintptr_t const start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+				std::uintptr_t const aligned = (start + MESI_SIMD_ALIGNMENT - 1) & ~std::uintptr_t(MESI_SIMD_ALIGNMENT - 1);
+				reinterpret_cast<void**>(aligned)[-1] = raw;
+				return reinterpret_cast<T*>(aligned);
+			}
+
+			void deallocate(T* p, std::size_t)
+			{
+				::operator delete(reinterpret_cast<void**>(p)[-1]);
+			}
+
+			template<typename U>
+			bool operator==(AlignedAllocator<U> const&) const
+			{
+				return true;
+			}
+
+			template<typename U>
+			bool operator!=(AlignedAllocator<U> const&) const
+			{
+				return false;
+			}
+		};
+
+		template<typename T>
+		using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+	}
+
+	/**
+	 * @brief Entities with one value of each of t_components, stored as
+	 * one array per component
+	 *
+	 * Each component is a quantity type or a Component<Name, Q>. Its values
+	 * are kept densely packed in an array of their own that starts on a
+	 * MESI_SIMD_ALIGNMENT byte boundary, so a system that reads one or two
+	 * components only touches their memory and can process them in
+	 * vectorised loops. query() passes a system the arrays of the
+	 * components it names as Spans.
+	 *
+	 * Entities are referred to by handles, which stay valid while other
+	 * entities are created and destroyed; destroying an entity moves the
+	 * last one into its place, so the arrays stay dense but their order
+	 * changes. A handle of a destroyed entity is detected as such, even
+	 * after its slot has been reused.
+	 *
+	 * Every entity of a pool has all of its components; entities with
+	 * different sets of components go into different pools.
+	 */
+	template<typename... t_components>
+	class ComponentPool
+	{
+		static_assert(sizeof...(t_components) > 0, "A pool needs at least one component");
+		static_assert(_internal::ComponentsUnique<t_components...>::value, "A component may only appear once in a pool");
+	public:
+		template<typename C>
+		using Value = typename _internal::ComponentValue<C>::Type;
+
+		/**
+		 * Handle of an entity
+		 */
+		struct Entity
+		{
+			std::uint32_t slot;
+			std::uint32_t generation;
+
+			bool operator==(Entity const& other) const
+			{
+				return slot == other.slot && generation == other.generation;
+			}
+
+			bool operator!=(Entity const& other) const
+			{
+				return !(*this == other);
+			}
+		};
+
+		std::size_t size() const
+		{
+			return m_entities.size();
+		}
+
+		bool empty() const
+		{
+			return m_entities.empty();
+		}
+
+		void reserve(std::size_t n)
+		{
+			m_entities.reserve(n);
+			forEachComponent([n](auto& v) { v.reserve(n); });
+		}
+
+		/**
+		 * Creates an entity with all components zero
+		 */
+		Entity create()
+		{
+			return create(Value<t_components>(typename Value<t_components>::BaseType(0))...);
+		}
+
+		Entity create(Value<t_components> const&... values)
+		{
+			std::uint32_t slot;
+			if(m_free.empty())
+			{
+				if(m_slots.size() >= std::numeric_limits<std::uint32_t>::max())
+				{
+					throw std::length_error("Too many entities");
+				}
+				slot = std::uint32_t(m_slots.size());
+				m_slots.push_back(Slot{ 0, 0 });
+			}
+			else
+			{
+				slot = m_free.back();
+				m_free.pop_back();
+			}
+			m_slots[slot].index = std::uint32_t(m_entities.size());
+			m_entities.push_back(slot);
+			push(std::index_sequence_for<t_components...>(), values...);
+			return Entity{ slot, m_slots[slot].generation };
+		}
+
+		/**
+		 * Destroys an entity, moving the last entity into its place
+		 */
+		void destroy(Entity e)
+		{
+			check(e);
+			std::size_t const i = m_slots[e.slot].index;
+			std::size_t const last = m_entities.size() - 1;
+			forEachComponent([i](auto& v) {
+				v[i] = v.back();
+				v.pop_back();
+			});
+			m_entities[i] = m_entities[last];
+			m_entities.pop_back();
+			if(i != last)
+			{
+				m_slots[m_entities[i]].index = std::uint32_t(i);
+			}
+			m_slots[e.slot].generation++;
+			m_free.push_back(e.slot);
+		}
+
+		/**
+		 * Destroys all entities, invalidating all handles
+		 */
+		void clear()
+		{
+			for(auto const slot : m_entities)
+			{
+				m_slots[slot].generation++;
+				m_free.push_back(slot);
+			}
+			m_entities.clear();
+			forEachComponent([](auto& v) { v.clear(); });
+		}
+
+		bool alive(Entity e) const
+		{
+			return e.slot < m_slots.size() && m_slots[e.slot].generation == e.generation;
+		}
+
+		/**
+		 * Position of an entity in the component arrays, which changes
+		 * when other entities are destroyed
+		 */
+		std::size_t index(Entity e) const
+		{
+			check(e);
+			return m_slots[e.slot].index;
+		}
+
+		/**
+		 * Handle of the entity at position i of the component arrays
+		 */
+		Entity entity(std::size_t i) const
+		{
+			std::uint32_t const slot = m_entities[i];
+			return Entity{ slot, m_slots[slot].generation };
+		}
+
+		template<typename C>
+		Value<C>& get(Entity e)
+		{
+			return array<C>()[index(e)];
+		}
+
+		template<typename C>
+		Value<C> const& get(Entity e) const
+		{
+			return array<C>()[index(e)];
+		}
+
+		/**
+		 * The values of component C of all entities, in the order of their
+		 * positions
+		 */
+		template<typename C>
+		Span<Value<C>> span()
+		{
+			auto& v = array<C>();
+			return Span<Value<C>>(v.data(), v.size());
+		}
+
+		template<typename C>
+		Span<Value<C> const> span() const
+		{
+			auto const& v = array<C>();
+			return Span<Value<C> const>(v.data(), v.size());
+		}
+
+		/**
+		 * Calls f with a Span of each of the components t_query, e.g.
+		 *
+		 *     pool.query<Vx, X>([dt](Span<Velocity> v, Span<Meters> x) {
+		 *         for(std::size_t i = 0; i < x.size(); i++)
+		 *             x[i] += v[i] * dt;
+		 *     });
+		 *
+		 * With a chunk size, f is called once per chunk of that many
+		 * entities instead, which keeps the chunks of all components in
+		 * the cache together. Chunks start on a MESI_SIMD_ALIGNMENT byte
+		 * boundary if chunk times the size of each value is a multiple of
+		 * it.
+		 */
+		template<typename... t_query, typename F>
+		void query(F&& f, std::size_t chunk = 0)
+		{
+			std::size_t const n = size();
+			std::size_t const step = chunk == 0 ? n : chunk;
+			for(std::size_t begin = 0; begin < n; begin += step)
+			{
+				std::size_t const count = n - begin < step ? n - begin : step;
+				f(Span<Value<t_query>>(array<t_query>().data() + begin, count)...);
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			/** Position in the arrays while alive */
+			std::uint32_t index;
+			std::uint32_t generation;
+		};
+
+		using Arrays = std::tuple<_internal::AlignedVector<Value<t_components>>...>;
+
+		template<typename C>
+		_internal::AlignedVector<Value<C>>& array()
+		{
+			return std::get<_internal::ComponentIndex<C, t_components...>::value>(m_arrays);
+		}
+
+		template<typename C>
+		_internal::AlignedVector<Value<C>> const& array() const
+		{
+			return std::get<_internal::ComponentIndex<C, t_components...>::value>(m_arrays);
+		}
+
+		template<typename F>
+		void forEachComponent(F&& f)
+		{
+			forEachComponent(f, std::index_sequence_for<t_components...>());
+		}
+
+		template<typename F, std::size_t... t_i>
+		void forEachComponent(F& f, std::index_sequence<t_i...>)
+		{
+			(void)std::initializer_list<int>{ (f(std::get<t_i>(m_arrays)), 0)... };
+		}
+
+		template<std::size_t... t_i>
+		void push(std::index_sequence<t_i...>, Value<t_components> const&... values)
+		{
+			(void)std::initializer_list<int>{ (std::get<t_i>(m_arrays).push_back(values), 0)... };
+		}
+
+		void check(Entity e) const
+		{
+			if(!alive(e))
+			{
+				throw std::out_of_range("The entity has been destroyed");
+			}
+		}
+
+		Arrays m_arrays;
+		/** Slot of the entity at each position */
+		std::vector<std::uint32_t> m_entities;
+		std::vector<Slot> m_slots;
+		std::vector<std::uint32_t> m_free;
+	};
+}
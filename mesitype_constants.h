@@ -0,0 +1,59 @@
+#pragma once
+
+#include <ratio>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	/**
+	 * Physical constants as dimensioned quantities, with the SI 2019 exact
+	 * values and CODATA 2018 recommended values for measured ones.
+	 *
+	 * Constants whose value is an exact rational number times a power of ten
+	 * also have a unit form in Constants::Unit: a quantity with the value 1
+	 * in a type whose Scale holds the constant. Multiplying by a unit form
+	 * only changes the type, and the factor is applied once, with a constant
+	 * known at compile time, when the result is converted to an unscaled
+	 * type:
+	 *
+	 *     auto e = m * Constants::Unit::SpeedOfLight * Constants::Unit::SpeedOfLight;
+	 *     Joules j = Joules(e);
+	 *
+	 * Since their value is exactly 1, unit forms also keep the full
+	 * precision of the storage type they are multiplied with, whereas the
+	 * plain constants are rounded to MESI_LITERAL_TYPE. Chaining many unit
+	 * forms can overflow the ratio of the Scale, which fails to compile, and
+	 * factors with large negative powers of ten such as the Planck constant
+	 * lose precision on conversion to float.
+	 */
+	namespace Constants {
+		namespace Unit {
+			constexpr Type<MESI_LITERAL_TYPE, 1, -2, 0>::Scale<std::ratio<980665>, 1, std::ratio<-5>> StandardGravity(1);
+			constexpr Type<MESI_LITERAL_TYPE, 1, -1, 0>::Scale<std::ratio<299792458>, 1, std::ratio<0>> SpeedOfLight(1);
+			constexpr Type<MESI_LITERAL_TYPE, 2, -1, 1>::Scale<std::ratio<662607015>, 1, std::ratio<-42>> Planck(1);
+			constexpr Type<MESI_LITERAL_TYPE, 0, 1, 0, 1>::Scale<std::ratio<1602176634>, 1, std::ratio<-28>> ElementaryCharge(1);
+			constexpr Type<MESI_LITERAL_TYPE, 2, -2, 1, 0, -1>::Scale<std::ratio<1380649>, 1, std::ratio<-29>> Boltzmann(1);
+			constexpr Type<MESI_LITERAL_TYPE, 0, 0, 0, 0, 0, -1>::Scale<std::ratio<602214076>, 1, std::ratio<15>> Avogadro(1);
+			constexpr Type<MESI_LITERAL_TYPE, 2, -2, 1, 0, -1, -1>::Scale<std::ratio<831446261815324>, 1, std::ratio<-14>> MolarGas(1);
+			constexpr Type<MESI_LITERAL_TYPE, 0, 1, 0, 1, 0, -1>::Scale<std::ratio<964853321233100184>, 1, std::ratio<-13>> Faraday(1);
+			constexpr Pascals::Scale<std::ratio<101325>, 1, std::ratio<0>> StandardAtmosphere(1);
+		}
+
+		constexpr Type<MESI_LITERAL_TYPE, 1, -2, 0> StandardGravity(9.80665);
+		constexpr Type<MESI_LITERAL_TYPE, 1, -1, 0> SpeedOfLight(299792458.0);
+		constexpr Type<MESI_LITERAL_TYPE, 2, -1, 1> Planck(6.62607015e-34);
+		constexpr Type<MESI_LITERAL_TYPE, 2, -1, 1> ReducedPlanck(1.054571817646156e-34);
+		constexpr Type<MESI_LITERAL_TYPE, 0, 1, 0, 1> ElementaryCharge(1.602176634e-19);
+		constexpr Type<MESI_LITERAL_TYPE, 2, -2, 1, 0, -1> Boltzmann(1.380649e-23);
+		constexpr Type<MESI_LITERAL_TYPE, 0, 0, 0, 0, 0, -1> Avogadro(6.02214076e23);
+		constexpr Type<MESI_LITERAL_TYPE, 2, -2, 1, 0, -1, -1> MolarGas(8.31446261815324);
+		constexpr Type<MESI_LITERAL_TYPE, 0, 1, 0, 1, 0, -1> Faraday(96485.3321233100184);
+		constexpr Pascals StandardAtmosphere(101325.0);
+		constexpr Type<MESI_LITERAL_TYPE, 0, -3, 1, 0, -4> StefanBoltzmann(5.670374419e-8);
+		constexpr Type<MESI_LITERAL_TYPE, 3, -2, -1> Gravitational(6.67430e-11);
+		constexpr Type<MESI_LITERAL_TYPE, -3, 4, -1, 2> VacuumPermittivity(8.8541878128e-12);
+		constexpr Type<MESI_LITERAL_TYPE, 1, -2, 1, -2> VacuumPermeability(1.25663706212e-6);
+		constexpr Kilograms ElectronMass(9.1093837015e-31);
+		constexpr Kilograms ProtonMass(1.67262192369e-27);
+	}
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	namespace _internal {
+		template<typename T, typename C>
+		T roundTo(C v, std::true_type)
+		{
+			return T(std::llround(v));
+		}
+
+		template<typename T, typename C>
+		T roundTo(C v, std::false_type)
+		{
+			return T(v);
+		}
+
+		/**
+		 * Converts the time q to t_time with a scale factor fixed at compile
+		 * time. Integral times are scaled as integers, which requires q not
+		 * to be finer than t_time; floating point times are scaled in at
+		 * least double precision and rounded if t_time is integral.
+		 */
+		template<typename t_time, typename Q>
+		t_time toTime(Q q)
+		{
+			static_assert(std::ratio_equal<typename Q::SecondExponent, std::ratio<1>>::value
+				&& std::ratio_equal<typename Q::MeterExponent, std::ratio<0>>::value
+				&& std::ratio_equal<typename Q::KilogramExponent, std::ratio<0>>::value
+				&& std::ratio_equal<typename Q::AmpereExponent, std::ratio<0>>::value
+				&& std::ratio_equal<typename Q::KelvinExponent, std::ratio<0>>::value
+				&& std::ratio_equal<typename Q::MoleExponent, std::ratio<0>>::value
+				&& std::ratio_equal<typename Q::CandelaExponent, std::ratio<0>>::value,
+				"Event times must be durations");
+			using T = typename t_time::BaseType;
+			using QT = typename Q::BaseType;
+			using Factor = typename ScaleMultiply<typename Q::ScaleInfo, typename t_time::ScaleInfo::Inverse>::Scale;
+			static_assert(!std::is_integral<QT>::value || !std::is_integral<T>::value
+				|| (Factor::exponent_denominator == 1 && Factor::ratio::den == 1 && Factor::power_of_ten::den == 1 && Factor::power_of_ten::num >= 0),
+				"Integral times converted to an integral time base must not be finer than it");
+			using C = typename std::conditional<std::is_integral<QT>::value, T, typename std::common_type<QT, double>::type>::type;
+#ifdef MESI_STRICT_CONSTEXPR_SCALES
+			static_assert(StrictScaleCheck<Q, t_time, Factor>::value, "Strict scale check");
+#endif
+			C const v = C(q.val) * ScaleFactor<Factor, C>::value();
+			return t_time(roundTo<T>(v, std::integral_constant<bool, std::is_integral<T>::value && !std::is_integral<C>::value>()));
+		}
+
+		template<typename T>
+		std::int64_t floorDivide(T a, T b, std::true_type)
+		{
+			return std::int64_t(a / b - (a % b != 0 && (a < 0) != (b < 0)));
+		}
+
+		template<typename T>
+		std::int64_t floorDivide(T a, T b, std::false_type)
+		{
+			return std::int64_t(std::floor(a / b));
+		}
+	}
+
+	/**
+	 * @brief Priority queue of events ordered by time, as a calendar queue
+	 *
+	 * @param t_payload data carried by each event
+	 * @param t_time type in which times are stored, e.g. Seconds with double
+	 *        storage, or Nano<Seconds> with integral storage
+	 *
+	 * Events are hashed by time into buckets of a fixed width, with the
+	 * bucket array wrapping around like the days of a calendar year. Pushing
+	 * and popping are O(1) amortised as long as a bucket holds a few events
+	 * of the current year, which the queue maintains by doubling or halving
+	 * the number of buckets and re-estimating the width from the spacing of
+	 * the earliest events.
+	 *
+	 * Times may be given in any unit of time; they are converted to t_time
+	 * with a factor known at compile time. Events with equal times are
+	 * popped in the order they were pushed.
+	 */
+	template<typename t_payload, typename t_time = Seconds>
+	class EventQueue
+	{
+		using T = typename t_time::BaseType;
+	public:
+		using Time = t_time;
+		using Payload = t_payload;
+
+		struct Event
+		{
+			t_time time;
+			t_payload payload;
+		};
+
+		explicit EventQueue(t_time bucketWidth = t_time(T(1)), std::size_t buckets = 16)
+			: m_width(bucketWidth.val)
+			, m_buckets(std::max<std::size_t>(buckets, 2))
+		{
+			if(!(m_width > T(0)))
+			{
+				throw std::invalid_argument("The bucket width must be positive");
+			}
+			setCurrent(0);
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		std::size_t buckets() const
+		{
+			return m_buckets.size();
+		}
+
+		t_time bucketWidth() const
+		{
+			return t_time(m_width);
+		}
+
+		/**
+		 * Schedules payload at time, given in any unit of time
+		 */
+		template<typename Q>
+		void push(Q time, t_payload payload)
+		{
+			T const t = _internal::toTime<t_time>(time).val;
+			std::int64_t const n = bucketNumber(t);
+			if(m_size == 0 || n < m_currentNumber)
+			{
+				setCurrent(n);
+			}
+			bucketFor(n).push_back(Entry{ t, n, m_sequence++, std::move(payload) });
+			m_size++;
+			if(m_size > 2 * m_buckets.size())
+			{
+				resize(2 * m_buckets.size());
+			}
+		}
+
+		/**
+		 * Time of the earliest event. The queue must not be empty.
+		 */
+		t_time nextTime()
+		{
+			return t_time(m_buckets[findNext()][m_nextIndex].time);
+		}
+
+		/**
+		 * Removes and returns the earliest event. The queue must not be
+		 * empty.
+		 */
+		Event pop()
+		{
+			auto& bucket = m_buckets[findNext()];
+			Entry e = std::move(bucket[m_nextIndex]);
+			bucket[m_nextIndex] = std::move(bucket.back());
+			bucket.pop_back();
+			m_size--;
+			shrink();
+			return Event{ t_time(e.time), std::move(e.payload) };
+		}
+
+		/**
+		 * Removes all events before end and appends them to out in time
+		 * order. Returns the number of events appended.
+		 */
+		template<typename Q>
+		std::size_t popUntil(Q end, std::vector<Event>& out)
+		{
+			T const limit = _internal::toTime<t_time>(end).val;
+			std::int64_t const last = bucketNumber(limit);
+			std::size_t const before = out.size();
+			while(m_size > 0)
+			{
+				// Jump over empty stretches straight to the next event
+				findNext();
+				if(m_currentNumber > last)
+				{
+					break;
+				}
+				auto& bucket = m_buckets[m_current];
+				m_staged.clear();
+				for(std::size_t i = 0; i < bucket.size();)
+				{
+					if(bucket[i].bucket <= m_currentNumber && bucket[i].time < limit)
+					{
+						m_staged.push_back(std::move(bucket[i]));
+						bucket[i] = std::move(bucket.back());
+						bucket.pop_back();
+					}
+					else
+					{
+						i++;
+					}
+				}
+				std::sort(m_staged.begin(), m_staged.end());
+				for(auto& e : m_staged)
+				{
+					out.push_back(Event{ t_time(e.time), std::move(e.payload) });
+				}
+				m_size -= m_staged.size();
+				if(m_currentNumber == last)
+				{
+					break;
+				}
+				advance();
+			}
+			shrink();
+			return out.size() - before;
+		}
+
+	private:
+		struct Entry
+		{
+			T time;
+			std::int64_t bucket;
+			std::uint64_t sequence;
+			t_payload payload;
+
+			bool operator<(Entry const& other) const
+			{
+				return time < other.time || (time == other.time && sequence < other.sequence);
+			}
+		};
+
+		std::int64_t bucketNumber(T t) const
+		{
+			return _internal::floorDivide(t, m_width, std::is_integral<T>());
+		}
+
+		std::vector<Entry>& bucketFor(std::int64_t n)
+		{
+			std::int64_t const count = std::int64_t(m_buckets.size());
+			return m_buckets[std::size_t(((n % count) + count) % count)];
+		}
+
+		void setCurrent(std::int64_t n)
+		{
+			std::int64_t const count = std::int64_t(m_buckets.size());
+			m_currentNumber = n;
+			m_current = std::size_t(((n % count) + count) % count);
+		}
+
+		void advance()
+		{
+			m_currentNumber++;
+			m_current = m_current + 1 == m_buckets.size() ? 0 : m_current + 1;
+		}
+
+		/**
+		 * Moves the scan position to the bucket holding the earliest event
+		 * and returns it, leaving the event's position in m_nextIndex.
+		 * After a whole year of empty buckets, searches all buckets instead.
+		 */
+		std::size_t findNext()
+		{
+			for(std::size_t scanned = 0; scanned < m_buckets.size(); scanned++)
+			{
+				if(findInCurrent())
+				{
+					return m_current;
+				}
+				advance();
+			}
+			Entry const* min = nullptr;
+			for(auto const& bucket : m_buckets)
+			{
+				for(auto const& e : bucket)
+				{
+					if(!min || e < *min)
+					{
+						min = &e;
+					}
+				}
+			}
+			setCurrent(min->bucket);
+			findInCurrent();
+			return m_current;
+		}
+
+		/**
+		 * Finds the earliest event of the current bucket that falls into
+		 * the current year
+		 */
+		bool findInCurrent()
+		{
+			auto const& bucket = m_buckets[m_current];
+			bool found = false;
+			for(std::size_t i = 0; i < bucket.size(); i++)
+			{
+				if(bucket[i].bucket <= m_currentNumber && (!found || bucket[i] < bucket[m_nextIndex]))
+				{
+					m_nextIndex = i;
+					found = true;
+				}
+			}
+			return found;
+		}
+
+		void shrink()
+		{
+			if(m_buckets.size() > 2 * s_minBuckets && m_size < m_buckets.size() / 2)
+			{
+				resize(m_buckets.size() / 2);
+			}
+		}
+
+		/**
+		 * Rehashes all events into count buckets, with the width set to three
+		 * times the average spacing of the earliest events
+		 */
+		void resize(std::size_t count)
+		{
+			std::vector<Entry> all;
+			all.reserve(m_size);
+			for(auto& bucket : m_buckets)
+			{
+				for(auto& e : bucket)
+				{
+					all.push_back(std::move(e));
+				}
+			}
+
+			std::size_t const sample = std::min<std::size_t>(all.size(), 25);
+			std::partial_sort(all.begin(), all.begin() + sample, all.end());
+			if(sample > 1)
+			{
+				T const spread = all[sample - 1].time - all[0].time;
+				T const width = T(3) * spread / T(sample - 1);
+				if(width > T(0))
+				{
+					m_width = width;
+				}
+			}
+
+			// all[0] is the earliest event after the partial sort
+			m_buckets.assign(count, std::vector<Entry>());
+			setCurrent(all.empty() ? 0 : bucketNumber(all[0].time));
+			for(auto& e : all)
+			{
+				e.bucket = bucketNumber(e.time);
+				bucketFor(e.bucket).push_back(std::move(e));
+			}
+		}
+
+		static constexpr std::size_t s_minBuckets = 8;
+
+		T m_width;
+		std::vector<std::vector<Entry>> m_buckets;
+		std::size_t m_size = 0;
+		std::uint64_t m_sequence = 0;
+		std::size_t m_current = 0;
+		std::int64_t m_currentNumber = 0;
+		std::size_t m_nextIndex = 0;
+		std::vector<Entry> m_staged;
+	};
+}
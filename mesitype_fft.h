@@ -0,0 +1,464 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	/**
+	 * Complex spectrum of a series of Q sampled over t_time. Each bin
+	 * approximates the continuous Fourier transform, so it carries the
+	 * units of Q * t_time.
+	 */
+	template<typename Q, typename t_time = Seconds>
+	using Spectrum = typename decltype(Q{} * t_time{})::template WithBaseType<std::complex<typename Q::BaseType>>;
+
+	/**
+	 * Power spectral density of a series of Q, i.e. Q^2 / Hertz
+	 */
+	template<typename Q, typename t_time = Seconds>
+	using PowerSpectrum = decltype(Q{} * Q{} * t_time{});
+
+	namespace _internal {
+		/**
+		 * The plan of type t_plan for size n, built on first use and kept
+		 * per thread, so finding it takes no lock
+		 */
+		template<typename t_plan>
+		t_plan& cachedPlan(std::size_t n)
+		{
+			static thread_local std::map<std::size_t, std::unique_ptr<t_plan>> s_plans;
+			auto& plan = s_plans[n];
+			if(!plan)
+			{
+				plan.reset(new t_plan(n));
+			}
+			return *plan;
+		}
+	}
+
+	/**
+	 * Mixed-radix plan for complex transforms of one size, holding the
+	 * factorisation, the twiddle factors and the scratch space of the
+	 * transform, so forward() neither allocates nor looks anything up.
+	 * Callers that transform many series of one size should build a plan
+	 * once and pass it to fft() and ifft(). A plan must not be used by two
+	 * threads at once.
+	 */
+	template<typename T>
+	class FftPlan
+	{
+		static_assert(std::is_floating_point<T>::value, "FFTs need a floating point storage type");
+	public:
+		using Complex = std::complex<T>;
+
+		explicit FftPlan(std::size_t n)
+			: m_n(n)
+		{
+			m_twiddles.resize(n);
+			for(std::size_t k = 0; k < n; k++)
+			{
+				T const phase = T(-2 * 3.14159265358979323846) * T(k) / T(n);
+				m_twiddles[k] = Complex(std::cos(phase), std::sin(phase));
+			}
+
+			// Prefer radix 4, then 2, then odd factors in increasing order
+			std::size_t rest = n;
+			std::size_t p = 4;
+			std::size_t fstride = 1;
+			while(rest > 1)
+			{
+				while(rest % p != 0)
+				{
+					p = p == 4 ? 2 : p == 2 ? 3 : p + 2;
+					if(p * p > rest)
+					{
+						p = rest;
+					}
+				}
+				rest /= p;
+
+				Stage s;
+				s.p = p;
+				s.m = rest;
+				s.fstride = fstride;
+				if(p == 2 || p == 4)
+				{
+					// Contiguous per-stage twiddles so the butterflies vectorise
+					s.twiddles.resize((p - 1) * rest);
+					for(std::size_t q = 1; q < p; q++)
+					{
+						for(std::size_t u = 0; u < rest; u++)
+						{
+							s.twiddles[(q - 1) * rest + u] = m_twiddles[(q * u * fstride) % n];
+						}
+					}
+				}
+				else
+				{
+					m_scratch.resize(std::max(m_scratch.size(), p));
+				}
+				m_stages.push_back(std::move(s));
+				fstride *= p;
+			}
+		}
+
+		/**
+		 * This thread's plan for transforms of size n, built on first use.
+		 * The returned reference stays valid for the lifetime of the
+		 * thread.
+		 */
+		static FftPlan& get(std::size_t n)
+		{
+			return _internal::cachedPlan<FftPlan>(n);
+		}
+
+		std::size_t size() const
+		{
+			return m_n;
+		}
+
+		/**
+		 * exp(-2 pi i k / n)
+		 */
+		Complex twiddle(std::size_t k) const
+		{
+			return m_twiddles[k];
+		}
+
+		/**
+		 * Forward transform without normalisation. in and out must not
+		 * overlap, and in is read with the given stride.
+		 */
+		void forward(Complex const* in, Complex* out, std::size_t in_stride = 1)
+		{
+			if(m_stages.empty())
+			{
+				if(m_n == 1)
+				{
+					out[0] = in[0];
+				}
+				return;
+			}
+			work(out, in, in_stride, 0, m_scratch.data());
+		}
+
+	private:
+		struct Stage
+		{
+			std::size_t p;
+			std::size_t m;
+			std::size_t fstride;
+			std::vector<Complex> twiddles;
+		};
+
+		static Complex mul(Complex a, Complex b)
+		{
+			// Plain arithmetic rather than operator*, which has to handle
+			// infinities and does not vectorise
+			return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+		}
+
+		void work(Complex* out, Complex const* in, std::size_t in_stride, std::size_t stage, Complex* scratch) const
+		{
+			Stage const& s = m_stages[stage];
+			std::size_t const step = s.fstride * in_stride;
+			if(s.m == 1)
+			{
+				for(std::size_t j = 0; j < s.p; j++)
+				{
+					out[j] = in[j * step];
+				}
+			}
+			else
+			{
+				for(std::size_t q = 0; q < s.p; q++)
+				{
+					work(out + q * s.m, in + q * step, in_stride, stage + 1, scratch);
+				}
+			}
+
+			switch(s.p)
+			{
+			case 2:
+				butterfly2(out, s);
+				break;
+			case 4:
+				butterfly4(out, s);
+				break;
+			default:
+				butterflyGeneric(out, s, scratch);
+				break;
+			}
+		}
+
+		static void butterfly2(Complex* out, Stage const& s)
+		{
+			Complex* out2 = out + s.m;
+			Complex const* tw = s.twiddles.data();
+			for(std::size_t u = 0; u < s.m; u++)
+			{
+				Complex const t = mul(out2[u], tw[u]);
+				out2[u] = out[u] - t;
+				out[u] += t;
+			}
+		}
+
+		static void butterfly4(Complex* out, Stage const& s)
+		{
+			std::size_t const m = s.m;
+			Complex const* tw1 = s.twiddles.data();
+			Complex const* tw2 = tw1 + m;
+			Complex const* tw3 = tw2 + m;
+			for(std::size_t u = 0; u < m; u++)
+			{
+				Complex const s0 = mul(out[u + m], tw1[u]);
+				Complex const s1 = mul(out[u + 2 * m], tw2[u]);
+				Complex const s2 = mul(out[u + 3 * m], tw3[u]);
+				Complex const s5 = out[u] - s1;
+				Complex const a = out[u] + s1;
+				Complex const s3 = s0 + s2;
+				Complex const s4 = s0 - s2;
+				out[u + 2 * m] = a - s3;
+				out[u] = a + s3;
+				out[u + m] = Complex(s5.real() + s4.imag(), s5.imag() - s4.real());
+				out[u + 3 * m] = Complex(s5.real() - s4.imag(), s5.imag() + s4.real());
+			}
+		}
+
+		void butterflyGeneric(Complex* out, Stage const& s, Complex* scratch) const
+		{
+			for(std::size_t u = 0; u < s.m; u++)
+			{
+				for(std::size_t q = 0; q < s.p; q++)
+				{
+					scratch[q] = out[u + q * s.m];
+				}
+				for(std::size_t q1 = 0; q1 < s.p; q1++)
+				{
+					std::size_t const k = u + q1 * s.m;
+					std::size_t idx = 0;
+					Complex sum = scratch[0];
+					for(std::size_t q = 1; q < s.p; q++)
+					{
+						idx = (idx + s.fstride * k) % m_n;
+						sum += mul(scratch[q], m_twiddles[idx]);
+					}
+					out[k] = sum;
+				}
+			}
+		}
+
+		std::size_t m_n;
+		std::vector<Complex> m_twiddles;
+		std::vector<Stage> m_stages;
+		/** Room for the inputs of one butterfly of the generic radix */
+		std::vector<Complex> m_scratch;
+	};
+
+	/**
+	 * Plan for transforms of n real samples. Even sizes are transformed
+	 * as a complex series of half the length and then split, odd ones as
+	 * a complex series with zero imaginary parts.
+	 */
+	template<typename T>
+	class RealFftPlan
+	{
+	public:
+		using Complex = std::complex<T>;
+
+		explicit RealFftPlan(std::size_t n)
+			: m_n(n)
+			, m_plan(n % 2 == 0 ? n / 2 : n)
+			, m_twiddles(n % 2 == 0 ? n / 4 + 1 : 0)
+			, m_scratch(n % 2 == 0 ? 0 : 2 * n)
+		{
+			for(std::size_t k = 0; k < m_twiddles.size(); k++)
+			{
+				T const phase = T(-2 * 3.14159265358979323846) * T(k) / T(n);
+				m_twiddles[k] = Complex(std::cos(phase), std::sin(phase));
+			}
+		}
+
+		/**
+		 * This thread's plan for real transforms of size n
+		 */
+		static RealFftPlan& get(std::size_t n)
+		{
+			return _internal::cachedPlan<RealFftPlan>(n);
+		}
+
+		std::size_t size() const
+		{
+			return m_n;
+		}
+
+		/**
+		 * Writes the n / 2 + 1 non-negative frequency bins of the n samples
+		 * in, without normalisation
+		 */
+		void forward(T const* in, Complex* out)
+		{
+			std::size_t const n = m_n;
+			if(n % 2 != 0)
+			{
+				for(std::size_t k = 0; k < n; k++)
+				{
+					m_scratch[k] = Complex(in[k]);
+				}
+				m_plan.forward(m_scratch.data(), m_scratch.data() + n);
+				std::copy(m_scratch.data() + n, m_scratch.data() + n + n / 2 + 1, out);
+				return;
+			}
+
+			std::size_t const h = n / 2;
+			if(h == 0)
+			{
+				return;
+			}
+			// std::complex<T> is layout-compatible with T[2], so the even and
+			// odd samples form the real and imaginary parts of a half-length series
+			m_plan.forward(reinterpret_cast<Complex const*>(in), out);
+
+			Complex const z0 = out[0];
+			out[0] = Complex(z0.real() + z0.imag());
+			out[h] = Complex(z0.real() - z0.imag());
+			for(std::size_t k = 1; k <= h / 2; k++)
+			{
+				Complex const zk = out[k];
+				Complex const zh = std::conj(out[h - k]);
+				Complex const e = (zk + zh) * T(0.5);
+				Complex const d = (zk - zh) * T(0.5);
+				Complex const od(d.imag(), -d.real());
+				Complex const w = m_twiddles[k] * od;
+				out[k] = e + w;
+				out[h - k] = std::conj(e - w);
+			}
+		}
+
+	private:
+		std::size_t m_n;
+		FftPlan<T> m_plan;
+		/** exp(-2 pi i k / n) for the bins the split needs */
+		std::vector<Complex> m_twiddles;
+		std::vector<Complex> m_scratch;
+	};
+
+	/**
+	 * Frequency of bin k of an n-point transform with sample interval dt
+	 */
+	template<typename t_time>
+	auto frequency(std::size_t k, std::size_t n, t_time dt)
+	{
+		using T = typename t_time::BaseType;
+		return typename t_time::ScalarType(T(k) / T(n)) / dt;
+	}
+
+	/**
+	 * Complex FFT of plan.size() samples of a complex-valued series. out[k]
+	 * approximates the Fourier transform at frequency(k, n, dt).
+	 */
+	template<typename Q, typename t_time>
+	void fft(FftPlan<typename Q::BaseType::value_type>& plan, Q const* in, t_time dt, decltype(Q{} * t_time{})* out)
+	{
+		using T = typename Q::BaseType::value_type;
+		auto* o = _internal::raw(out);
+		plan.forward(_internal::raw(in), o);
+		T const scale = T(dt.val);
+		for(std::size_t k = 0; k < plan.size(); k++)
+		{
+			o[k] *= scale;
+		}
+	}
+
+	/**
+	 * Complex FFT of n samples, with this thread's plan for size n
+	 */
+	template<typename Q, typename t_time>
+	void fft(Q const* in, std::size_t n, t_time dt, decltype(Q{} * t_time{})* out)
+	{
+		fft(FftPlan<typename Q::BaseType::value_type>::get(n), in, dt, out);
+	}
+
+	/**
+	 * Inverse of fft(): reconstructs plan.size() complex samples from their
+	 * spectrum. in and out must not overlap.
+	 */
+	template<typename Q, typename t_time>
+	void ifft(FftPlan<typename Q::BaseType::value_type>& plan, Q const* in, t_time dt, decltype(Q{} / t_time{})* out)
+	{
+		using T = typename Q::BaseType::value_type;
+		std::size_t const n = plan.size();
+		auto* o = _internal::raw(out);
+		plan.forward(_internal::raw(in), o);
+		// The inverse transform is the forward one with the bins k and
+		// n - k swapped
+		std::reverse(o + std::min<std::size_t>(n, 1), o + n);
+		T const scale = T(1) / (T(n) * T(dt.val));
+		for(std::size_t k = 0; k < n; k++)
+		{
+			o[k] *= scale;
+		}
+	}
+
+	/**
+	 * Inverse of fft() for n bins, with this thread's plan for size n
+	 */
+	template<typename Q, typename t_time>
+	void ifft(Q const* in, std::size_t n, t_time dt, decltype(Q{} / t_time{})* out)
+	{
+		ifft(FftPlan<typename Q::BaseType::value_type>::get(n), in, dt, out);
+	}
+
+	/**
+	 * FFT of plan.size() samples of a real-valued series, writing the
+	 * n / 2 + 1 non-negative frequency bins
+	 */
+	template<typename Q, typename t_time>
+	void rfft(RealFftPlan<typename Q::BaseType>& plan, Q const* in, t_time dt, Spectrum<Q, t_time>* out)
+	{
+		using T = typename Q::BaseType;
+		auto* o = _internal::raw(out);
+		plan.forward(_internal::raw(in), o);
+		T const scale = T(dt.val);
+		std::size_t const bins = plan.size() == 0 ? 0 : plan.size() / 2 + 1;
+		for(std::size_t k = 0; k < bins; k++)
+		{
+			o[k] *= scale;
+		}
+	}
+
+	/**
+	 * FFT of n real samples, with this thread's plan for size n
+	 */
+	template<typename Q, typename t_time>
+	void rfft(Q const* in, std::size_t n, t_time dt, Spectrum<Q, t_time>* out)
+	{
+		rfft(RealFftPlan<typename Q::BaseType>::get(n), in, dt, out);
+	}
+
+	/**
+	 * Power spectral density |X_k|^2 / (n * dt) of the given spectrum bins,
+	 * where n is the length of the transformed series. This is the
+	 * two-sided density; double the bins other than DC and Nyquist of an
+	 * rfft() for the one-sided one.
+	 */
+	template<typename Q, typename t_time>
+	void powerSpectrum(Q const* spectrum, std::size_t bins, std::size_t n, t_time dt, typename decltype(Q{} * Q{} / t_time{})::template WithBaseType<typename Q::BaseType::value_type>* out)
+	{
+		using T = typename Q::BaseType::value_type;
+		auto const* x = _internal::raw(spectrum);
+		T const scale = T(1) / (T(n) * T(dt.val));
+		for(std::size_t k = 0; k < bins; k++)
+		{
+			out[k].val = (x[k].real() * x[k].real() + x[k].imag() * x[k].imag()) * scale;
+		}
+	}
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	namespace _internal {
+		/**
+		 * The number of coefficients of a FIR filter, which must not be 0
+		 */
+		template<typename C>
+		std::size_t firTaps(std::vector<C> const& coefficients)
+		{
+			if(coefficients.empty())
+			{
+				throw std::invalid_argument("A FIR filter needs at least one coefficient");
+			}
+			return coefficients.size();
+		}
+
+		inline std::size_t decimationFactor(std::size_t factor)
+		{
+			if(factor == 0)
+			{
+				throw std::invalid_argument("The decimation factor must not be 0");
+			}
+			return factor;
+		}
+
+		/**
+		 * The number of frames in a block of interleaved input, which must
+		 * be whole frames and fit the output
+		 */
+		inline std::size_t blockFrames(std::size_t in, std::size_t out, std::size_t channels)
+		{
+			if(in != out)
+			{
+				throw std::invalid_argument("The input and output of a filter must have the same size");
+			}
+			if(in % channels != 0)
+			{
+				throw std::invalid_argument("A filter block must hold whole frames");
+			}
+			return in / channels;
+		}
+	}
+
+	/**
+	 * @brief Block-based FIR filter over interleaved channels of Q
+	 *
+	 * The coefficients are dimensionless, so the output has the type of the
+	 * input. All channels share the coefficients and each keeps its own
+	 * delay line of the last taps - 1 samples, stored as Q.
+	 *
+	 * Samples are interleaved frame by frame, i.e. sample i of channel c is
+	 * at index i * channels + c. The inner loop runs over consecutive
+	 * samples of the block, so it vectorises both across channels and
+	 * along a single long channel.
+	 *
+	 * Throws std::invalid_argument if there are no coefficients.
+	 */
+	template<typename Q>
+	class FirFilter
+	{
+	public:
+		using Value = Q;
+		using Coefficient = typename Q::ScalarType;
+
+		FirFilter(std::vector<Coefficient> const& coefficients, std::size_t channels = 1)
+			: m_channels(channels)
+			, m_history((_internal::firTaps(coefficients) - 1) * channels, Q(T(0)))
+		{
+			// Reversed, so each output is a forward dot product over the buffer
+			for(auto it = coefficients.rbegin(); it != coefficients.rend(); ++it)
+			{
+				m_taps.push_back(it->val);
+			}
+		}
+
+		std::size_t channels() const
+		{
+			return m_channels;
+		}
+
+		std::size_t taps() const
+		{
+			return m_taps.size();
+		}
+
+		/**
+		 * The last taps - 1 frames of input, oldest first
+		 */
+		std::vector<Q> const& history() const
+		{
+			return m_history;
+		}
+
+		void reset()
+		{
+			std::fill(m_history.begin(), m_history.end(), Q(T(0)));
+		}
+
+		/**
+		 * Filters frames frames of interleaved input. in and out may be the
+		 * same array.
+		 */
+		void process(Q const* in, Q* out, std::size_t frames)
+		{
+			std::size_t const h = m_history.size();
+			std::size_t const n = frames * m_channels;
+			m_buffer.resize(h + n);
+			T const* x = _internal::raw(in);
+			std::copy(_internal::raw(m_history.data()), _internal::raw(m_history.data()) + h, m_buffer.begin());
+			std::copy(x, x + n, m_buffer.begin() + h);
+
+			T* y = _internal::raw(out);
+			T const* b = m_buffer.data();
+			std::fill(y, y + n, T(0));
+			for(std::size_t j = 0; j < m_taps.size(); j++)
+			{
+				T const c = m_taps[j];
+				T const* bj = b + j * m_channels;
+				for(std::size_t i = 0; i < n; i++)
+				{
+					y[i] += c * bj[i];
+				}
+			}
+
+			std::copy(m_buffer.end() - h, m_buffer.end(), _internal::raw(m_history.data()));
+		}
+
+		/**
+		 * Filters the whole interleaved block in, which must hold whole
+		 * frames. Throws std::invalid_argument unless out has the size of in.
+		 */
+		void process(Span<Q const> in, Span<Q> out)
+		{
+			process(in.data(), out.data(), _internal::blockFrames(in.size(), out.size(), m_channels));
+		}
+
+	private:
+		using T = typename Q::BaseType;
+
+		std::size_t m_channels;
+		std::vector<T> m_taps;
+		std::vector<Q> m_history;
+		std::vector<T> m_buffer;
+	};
+
+	/**
+	 * @brief FIR filter that keeps every factor-th output of a single channel
+	 *
+	 * The coefficients are split into factor phases and the input into
+	 * factor interleaved sub-streams, so every output is the sum of factor
+	 * short FIRs over contiguous arrays, and the skipped outputs are never
+	 * computed.
+	 *
+	 * Of the outputs y[0], y[1], ... that a FirFilter with the same
+	 * coefficients would give, the decimator keeps y[f - 1], y[2f - 1], ...,
+	 * i.e. the output for the last input of each group of factor inputs.
+	 *
+	 * Throws std::invalid_argument if there are no coefficients or factor
+	 * is 0.
+	 */
+	template<typename Q>
+	class FirDecimator
+	{
+	public:
+		using Value = Q;
+		using Coefficient = typename Q::ScalarType;
+
+		FirDecimator(std::vector<Coefficient> const& coefficients, std::size_t factor)
+			: m_factor(_internal::decimationFactor(factor))
+			, m_phaseTaps((_internal::firTaps(coefficients) + factor - 1) / factor)
+			, m_taps(m_phaseTaps * factor, T(0))
+			, m_buffer((m_phaseTaps - 1) * factor, Q(T(0)))
+		{
+			// Reversed coefficients, front-padded with zeros to a whole
+			// number of frames; phase p holds entries p, p + factor, ...
+			std::size_t const pad = m_taps.size() - coefficients.size();
+			for(std::size_t j = 0; j < coefficients.size(); j++)
+			{
+				std::size_t const r = pad + j;
+				m_taps[(r % factor) * m_phaseTaps + r / factor] = coefficients[coefficients.size() - 1 - j].val;
+			}
+		}
+
+		std::size_t factor() const
+		{
+			return m_factor;
+		}
+
+		void reset()
+		{
+			m_buffer.assign((m_phaseTaps - 1) * m_factor, Q(T(0)));
+		}
+
+		/**
+		 * Consumes count input samples and writes one output for every
+		 * factor inputs, returning the number of outputs written. Inputs that
+		 * do not complete an output are kept for the next call.
+		 */
+		std::size_t process(Q const* in, Q* out, std::size_t count)
+		{
+			std::size_t const f = m_factor;
+			std::size_t const context = (m_phaseTaps - 1) * f;
+			m_buffer.insert(m_buffer.end(), in, in + count);
+			std::size_t const outputs = (m_buffer.size() - context) / f;
+			std::size_t const len = m_phaseTaps - 1 + outputs;
+
+			m_phases.resize(f * len);
+			for(std::size_t r = 0; r < len; r++)
+			{
+				for(std::size_t p = 0; p < f; p++)
+				{
+					m_phases[p * len + r] = m_buffer[r * f + p].val;
+				}
+			}
+
+			T* y = _internal::raw(out);
+			std::fill(y, y + outputs, T(0));
+			for(std::size_t p = 0; p < f; p++)
+			{
+				T const* taps = m_taps.data() + p * m_phaseTaps;
+				T const* phase = m_phases.data() + p * len;
+				for(std::size_t q = 0; q < m_phaseTaps; q++)
+				{
+					T const c = taps[q];
+					T const* xq = phase + q;
+					for(std::size_t m = 0; m < outputs; m++)
+					{
+						y[m] += c * xq[m];
+					}
+				}
+			}
+
+			m_buffer.erase(m_buffer.begin(), m_buffer.begin() + outputs * f);
+			return outputs;
+		}
+
+		/**
+		 * Consumes all of in, like the pointer form. Throws
+		 * std::invalid_argument if out is too short for the outputs.
+		 */
+		std::size_t process(Span<Q const> in, Span<Q> out)
+		{
+			std::size_t const outputs = (m_buffer.size() + in.size() - (m_phaseTaps - 1) * m_factor) / m_factor;
+			if(out.size() < outputs)
+			{
+				throw std::invalid_argument("The output of a decimator is too short for its input");
+			}
+			return process(in.data(), out.data(), in.size());
+		}
+
+	private:
+		using T = typename Q::BaseType;
+
+		std::size_t m_factor;
+		std::size_t m_phaseTaps;
+		std::vector<T> m_taps;
+		std::vector<Q> m_buffer;
+		std::vector<T> m_phases;
+	};
+
+	/**
+	 * @brief Second order IIR section over interleaved channels of Q
+	 *
+	 * Transposed direct form II, with the two state variables of every
+	 * channel stored as Q. Time runs in the outer loop and channels in the
+	 * inner one, so many channels are filtered side by side.
+	 */
+	template<typename Q>
+	class Biquad
+	{
+	public:
+		using Value = Q;
+		using Coefficient = typename Q::ScalarType;
+
+		/**
+		 * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+		 */
+		Biquad(Coefficient b0, Coefficient b1, Coefficient b2, Coefficient a1, Coefficient a2, std::size_t channels = 1)
+			: m_b0(b0.val), m_b1(b1.val), m_b2(b2.val), m_a1(a1.val), m_a2(a2.val)
+			, m_channels(channels)
+			, m_s1(channels, Q(T(0)))
+			, m_s2(channels, Q(T(0)))
+		{}
+
+		/**
+		 * Second order Butterworth-style low pass (RBJ cookbook), with the
+		 * cutoff given as a fraction of the sample rate by the unit types
+		 */
+		template<typename t_frequency>
+		static Biquad lowPass(t_frequency cutoff, t_frequency sampleRate, Coefficient quality = Coefficient(T(0.70710678118654752)), std::size_t channels = 1)
+		{
+			T const w = T(2 * 3.14159265358979323846) * T((cutoff / sampleRate).val);
+			T const alpha = std::sin(w) / (T(2) * quality.val);
+			T const c = std::cos(w);
+			T const a0 = T(1) + alpha;
+			return Biquad(Coefficient((T(1) - c) / 2 / a0), Coefficient((T(1) - c) / a0), Coefficient((T(1) - c) / 2 / a0),
+				Coefficient(T(-2) * c / a0), Coefficient((T(1) - alpha) / a0), channels);
+		}
+
+		std::size_t channels() const
+		{
+			return m_channels;
+		}
+
+		void reset()
+		{
+			std::fill(m_s1.begin(), m_s1.end(), Q(T(0)));
+			std::fill(m_s2.begin(), m_s2.end(), Q(T(0)));
+		}
+
+		/**
+		 * Filters frames frames of interleaved input. in and out may be the
+		 * same array.
+		 */
+		void process(Q const* in, Q* out, std::size_t frames)
+		{
+			std::size_t const c = m_channels;
+			T const* x = _internal::raw(in);
+			T* y = _internal::raw(out);
+			T* s1 = _internal::raw(m_s1.data());
+			T* s2 = _internal::raw(m_s2.data());
+			for(std::size_t i = 0; i < frames; i++)
+			{
+				for(std::size_t ch = 0; ch < c; ch++)
+				{
+					T const xi = x[i * c + ch];
+					T const yi = m_b0 * xi + s1[ch];
+					s1[ch] = m_b1 * xi - m_a1 * yi + s2[ch];
+					s2[ch] = m_b2 * xi - m_a2 * yi;
+					y[i * c + ch] = yi;
+				}
+			}
+		}
+
+		/**
+		 * Filters the whole interleaved block in, which must hold whole
+		 * frames. Throws std::invalid_argument unless out has the size of in.
+		 */
+		void process(Span<Q const> in, Span<Q> out)
+		{
+			process(in.data(), out.data(), _internal::blockFrames(in.size(), out.size(), m_channels));
+		}
+
+	private:
+		using T = typename Q::BaseType;
+
+		T m_b0, m_b1, m_b2, m_a1, m_a2;
+		std::size_t m_channels;
+		std::vector<Q> m_s1;
+		std::vector<Q> m_s2;
+	};
+
+	/**
+	 * Several Biquad sections applied one after another
+	 */
+	template<typename Q>
+	class BiquadCascade
+	{
+	public:
+		using Value = Q;
+
+		explicit BiquadCascade(std::vector<Biquad<Q>> sections)
+			: m_sections(std::move(sections))
+		{}
+
+		void reset()
+		{
+			for(auto& s : m_sections)
+			{
+				s.reset();
+			}
+		}
+
+		void process(Q const* in, Q* out, std::size_t frames)
+		{
+			for(auto& s : m_sections)
+			{
+				s.process(in, out, frames);
+				in = out;
+			}
+		}
+
+		void process(Span<Q const> in, Span<Q> out)
+		{
+			for(auto& s : m_sections)
+			{
+				s.process(in, out);
+				in = out;
+			}
+		}
+
+	private:
+		std::vector<Biquad<Q>> m_sections;
+	};
+}
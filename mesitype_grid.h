@@ -0,0 +1,356 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_parallel.h"
+
+namespace Mesi {
+	/**
+	 * @brief Structured grid of Mesi values with uniform spacing
+	 *
+	 * @param Q type of the field values, e.g. Kelvin or Pascals
+	 * @param t_dim number of dimensions
+	 * @param t_length type of the grid spacing
+	 *
+	 * Cells are stored in row-major order, the last index being contiguous,
+	 * surrounded by a halo of Halo cells on every side. Halo cells can be
+	 * addressed with indices -1 and extent(d), and are only written by the
+	 * boundary condition helpers, never by the stencils.
+	 *
+	 * The stencils below process the interior tile by tile, each tile
+	 * small enough to stay in cache, optionally spreading the tiles over a
+	 * ThreadPool.
+	 */
+	template<typename Q, std::size_t t_dim, typename t_length = Meters>
+	class Grid
+	{
+		static_assert(t_dim > 0, "A grid needs at least one dimension");
+	public:
+		using Value = Q;
+		using Length = t_length;
+		using Index = std::array<std::ptrdiff_t, t_dim>;
+		using Extent = std::array<std::size_t, t_dim>;
+
+		static constexpr std::size_t Dim = t_dim;
+		static constexpr std::ptrdiff_t Halo = 1;
+
+		/**
+		 * Throws std::invalid_argument if any extent is 0
+		 */
+		Grid(Extent const& extent, Length spacing, Q fill = Q(typename Q::BaseType(0)))
+			: m_extent(extent)
+			, m_spacing(spacing)
+		{
+			for(std::size_t const e : extent)
+			{
+				if(e == 0)
+				{
+					throw std::invalid_argument("A grid needs at least one cell along every dimension");
+				}
+			}
+			std::size_t size = 1;
+			for(std::size_t d = t_dim; d-- > 0;)
+			{
+				m_stride[d] = std::ptrdiff_t(size);
+				size *= extent[d] + 2 * Halo;
+			}
+			m_offset = 0;
+			for(std::size_t d = 0; d < t_dim; d++)
+			{
+				m_offset += Halo * m_stride[d];
+				m_tile[d] = d + 1 == t_dim ? std::min<std::size_t>(extent[d], 1024) : std::min<std::size_t>(extent[d], 16);
+			}
+			m_cells.assign(size, fill);
+		}
+
+		Extent const& extent() const
+		{
+			return m_extent;
+		}
+
+		Length spacing() const
+		{
+			return m_spacing;
+		}
+
+		/**
+		 * Distance between neighbouring cells along dimension d, in cells
+		 */
+		std::ptrdiff_t stride(std::size_t d) const
+		{
+			return m_stride[d];
+		}
+
+		Q& operator[](Index const& i)
+		{
+			return m_cells[offset(i)];
+		}
+
+		Q const& operator[](Index const& i) const
+		{
+			return m_cells[offset(i)];
+		}
+
+		/**
+		 * Pointer to the interior cell with all indices 0
+		 */
+		Q* origin()
+		{
+			return m_cells.data() + m_offset;
+		}
+
+		Q const* origin() const
+		{
+			return m_cells.data() + m_offset;
+		}
+
+		/**
+		 * Number of cells per tile along each dimension
+		 */
+		Extent const& tileExtent() const
+		{
+			return m_tile;
+		}
+
+		void setTileExtent(Extent const& tile)
+		{
+			for(std::size_t d = 0; d < t_dim; d++)
+			{
+				m_tile[d] = std::max<std::size_t>(1, std::min(tile[d], m_extent[d]));
+			}
+		}
+
+		std::size_t tileCount() const
+		{
+			std::size_t n = 1;
+			for(std::size_t d = 0; d < t_dim; d++)
+			{
+				n *= (m_extent[d] + m_tile[d] - 1) / m_tile[d];
+			}
+			return n;
+		}
+
+		/**
+		 * Bounds [begin, end) of the tile with the given number
+		 */
+		void tile(std::size_t n, Index& begin, Index& end) const
+		{
+			for(std::size_t d = t_dim; d-- > 0;)
+			{
+				std::size_t const tiles = (m_extent[d] + m_tile[d] - 1) / m_tile[d];
+				begin[d] = std::ptrdiff_t((n % tiles) * m_tile[d]);
+				end[d] = std::ptrdiff_t(std::min(m_extent[d], (n % tiles + 1) * m_tile[d]));
+				n /= tiles;
+			}
+		}
+
+		/**
+		 * Dirichlet boundary: sets every halo cell to v
+		 */
+		void fillHalo(Q const& v)
+		{
+			forEachHaloCell([&](Index const& i, Index const&) { (*this)[i] = v; });
+		}
+
+		/**
+		 * Zero-gradient (Neumann) boundary: copies the nearest interior cell
+		 * into every halo cell
+		 */
+		void clampHalo()
+		{
+			forEachHaloCell([&](Index const& i, Index const& clamped) { (*this)[i] = (*this)[clamped]; });
+		}
+
+		/**
+		 * Periodic boundary: copies the interior cells from the opposite
+		 * side into every halo cell
+		 */
+		void wrapHalo()
+		{
+			forEachHaloCell([&](Index const& i, Index const&) {
+				Index w = i;
+				for(std::size_t d = 0; d < t_dim; d++)
+				{
+					std::ptrdiff_t const n = std::ptrdiff_t(m_extent[d]);
+					w[d] = (i[d] % n + n) % n;
+				}
+				(*this)[i] = (*this)[w];
+			});
+		}
+
+	private:
+		std::size_t offset(Index const& i) const
+		{
+			std::ptrdiff_t o = m_offset;
+			for(std::size_t d = 0; d < t_dim; d++)
+			{
+				o += i[d] * m_stride[d];
+			}
+			return std::size_t(o);
+		}
+
+		template<typename F>
+		void forEachHaloCell(F&& f)
+		{
+			Index i;
+			i.fill(-Halo);
+			for(;;)
+			{
+				Index clamped;
+				bool halo = false;
+				for(std::size_t d = 0; d < t_dim; d++)
+				{
+					clamped[d] = std::min<std::ptrdiff_t>(std::max<std::ptrdiff_t>(i[d], 0), std::ptrdiff_t(m_extent[d]) - 1);
+					halo = halo || clamped[d] != i[d];
+				}
+				if(halo)
+				{
+					f(i, clamped);
+				}
+
+				std::size_t d = t_dim;
+				while(d-- > 0)
+				{
+					if(++i[d] < std::ptrdiff_t(m_extent[d]) + Halo)
+					{
+						break;
+					}
+					i[d] = -Halo;
+				}
+				if(d == std::size_t(-1))
+				{
+					return;
+				}
+			}
+		}
+
+		Extent m_extent;
+		Length m_spacing;
+		Index m_stride;
+		std::ptrdiff_t m_offset;
+		Extent m_tile;
+		std::vector<Q> m_cells;
+	};
+
+	namespace _internal {
+		/**
+		 * Calls f(in, out, n) for every row of the tile [begin, end), with
+		 * in and out pointing at the first cell of the row and n cells in
+		 * the row along the contiguous dimension
+		 */
+		template<typename t_in, typename t_out, typename F>
+		void forEachTileRow(t_in const& in, t_out& out, typename t_in::Index const& begin, typename t_in::Index const& end, F& f)
+		{
+			constexpr std::size_t dim = t_in::Dim;
+			auto i = begin;
+			std::size_t const n = std::size_t(end[dim - 1] - begin[dim - 1]);
+			for(;;)
+			{
+				f(&in[i], &out[i], n);
+
+				std::size_t d = dim - 1;
+				while(d-- > 0)
+				{
+					if(++i[d] < end[d])
+					{
+						break;
+					}
+					i[d] = begin[d];
+				}
+				if(d == std::size_t(-1))
+				{
+					return;
+				}
+			}
+		}
+
+		template<typename t_in, typename t_out, typename F>
+		void sweepTiles(t_in const& in, t_out& out, ThreadPool* pool, F f)
+		{
+			if(in.extent() != out.extent())
+			{
+				throw std::invalid_argument("The output grid must have the extent of the input grid");
+			}
+			auto tile = [&](std::size_t n) {
+				typename t_in::Index begin, end;
+				in.tile(n, begin, end);
+				forEachTileRow(in, out, begin, end, f);
+			};
+			if(pool)
+			{
+				pool->run(in.tileCount(), tile);
+			}
+			else
+			{
+				for(std::size_t n = 0; n < in.tileCount(); n++)
+				{
+					tile(n);
+				}
+			}
+		}
+	}
+
+	template<typename Q, std::size_t t_dim, typename t_length = Meters>
+	using GradientGrid = Grid<decltype(Q{} / t_length{}), t_dim, t_length>;
+
+	template<typename Q, std::size_t t_dim, typename t_length = Meters>
+	using LaplacianGrid = Grid<decltype(Q{} / (t_length{} * t_length{})), t_dim, t_length>;
+
+	/**
+	 * Central difference along dimension axis. Reads the halo, so the
+	 * boundary condition must be applied beforehand. Throws
+	 * std::invalid_argument unless out has the same extent as in and axis
+	 * is less than t_dim.
+	 */
+	template<typename Q, std::size_t t_dim, typename t_length>
+	void gradient(Grid<Q, t_dim, t_length> const& in, std::size_t axis, GradientGrid<Q, t_dim, t_length>& out, ThreadPool* pool = nullptr)
+	{
+		if(axis >= t_dim)
+		{
+			throw std::invalid_argument("The axis must be less than the dimension of the grid");
+		}
+		using T = typename Q::BaseType;
+		std::ptrdiff_t const s = in.stride(axis);
+		T const inv2h = T(1) / (T(2) * T(in.spacing().val));
+		_internal::sweepTiles(in, out, pool, [=](Q const* u, typename GradientGrid<Q, t_dim, t_length>::Value* g, std::size_t n) {
+			for(std::size_t i = 0; i < n; i++)
+			{
+				g[i].val = (u[i + s].val - u[i - s].val) * inv2h;
+			}
+		});
+	}
+
+	/**
+	 * Standard (2 * t_dim + 1)-point Laplacian. Reads the halo, so the
+	 * boundary condition must be applied beforehand. Throws
+	 * std::invalid_argument unless out has the same extent as in.
+	 */
+	template<typename Q, std::size_t t_dim, typename t_length>
+	void laplacian(Grid<Q, t_dim, t_length> const& in, LaplacianGrid<Q, t_dim, t_length>& out, ThreadPool* pool = nullptr)
+	{
+		using T = typename Q::BaseType;
+		std::array<std::ptrdiff_t, t_dim> strides;
+		for(std::size_t d = 0; d < t_dim; d++)
+		{
+			strides[d] = in.stride(d);
+		}
+		T const invh2 = T(1) / (T(in.spacing().val) * T(in.spacing().val));
+		_internal::sweepTiles(in, out, pool, [=](Q const* u, typename LaplacianGrid<Q, t_dim, t_length>::Value* l, std::size_t n) {
+			for(std::size_t i = 0; i < n; i++)
+			{
+				T sum = T(-2 * int(t_dim)) * u[i].val;
+				for(std::size_t d = 0; d < t_dim; d++)
+				{
+					sum += u[i + strides[d]].val + u[i - strides[d]].val;
+				}
+				l[i].val = sum * invh2;
+			}
+		});
+	}
+}
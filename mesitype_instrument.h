@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Counters for the operations on Mesi types that do more than arithmetic
+ * on their values: conversions between scales, Mesi::pow, and scale factors
+ * that have to be computed at run time because they involve roots.
+ *
+ * The operations only report themselves if MESI_INSTRUMENT is defined
+ * before mesitype.h is included, and it must then be defined in every
+ * translation unit of the program. Each report goes to a hook that is set
+ * per thread; the default hook counts it per type and call site in tables
+ * private to the thread, which dump() and counts() add up.
+ *
+ * Call sites are return addresses, which addr2line or a debugger turn into
+ * source lines; for position independent executables, subtract the address
+ * the executable was loaded at first. They are places in the machine code,
+ * not in the source:
+ *
+ * - Where the operation is not inlined, as in unoptimised builds without
+ *   MESI_DEBUG_INLINE, the site lies in the operation itself, so all uses
+ *   of one conversion, pow or run-time scale factor count as one site.
+ * - Where it is inlined, the site lies in the caller, but the optimiser
+ *   may copy the call, e.g. when it unrolls a loop or inlines the caller
+ *   in several places, and then one source line counts as several sites.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define MESI_INSTRUMENT_NOINLINE __attribute__((noinline))
+#	define MESI_RETURN_ADDRESS() __builtin_return_address(0)
+#elif defined(_MSC_VER)
+#	include <intrin.h>
+#	define MESI_INSTRUMENT_NOINLINE __declspec(noinline)
+#	define MESI_RETURN_ADDRESS() _ReturnAddress()
+#else
+#	define MESI_INSTRUMENT_NOINLINE
+#	define MESI_RETURN_ADDRESS() nullptr
+#endif
+
+namespace Mesi {
+	namespace Instrument {
+		enum class Event
+		{
+			/** Conversion between two scales of the same unit */
+			Conversion,
+			/** Mesi::pow */
+			Pow,
+			/** A fractional power of ten computed at run time */
+			RuntimePowerOfTen,
+			/** A root of a scale ratio computed at run time */
+			RuntimeRatioRoot,
+		};
+
+		inline char const* eventName(Event e)
+		{
+			switch(e)
+			{
+			case Event::Conversion: return "conversion";
+			case Event::Pow: return "pow";
+			case Event::RuntimePowerOfTen: return "runtime 10^x";
+			case Event::RuntimeRatioRoot: return "runtime root";
+			}
+			return "";
+		}
+
+		/**
+		 * Identifies a type by its getUnit function, which also yields its
+		 * unit string when the counts are reported
+		 */
+		using UnitName = std::string (*)();
+
+		using Hook = void (*)(Event event, UnitName from, UnitName to, void const* site);
+
+		/**
+		 * Count of one kind of event between two types
+		 */
+		struct Count
+		{
+			Event event;
+			std::string from;
+			std::string to;
+			std::uint64_t count;
+			/** The call site with the highest count, and the number of sites */
+			void const* hottestSite;
+			std::size_t sites;
+		};
+	}
+
+	namespace _internal {
+		struct InstrumentKey
+		{
+			Instrument::Event event;
+			Instrument::UnitName from;
+			Instrument::UnitName to;
+			void const* site;
+
+			bool operator==(InstrumentKey const& other) const
+			{
+				return event == other.event && from == other.from && to == other.to && site == other.site;
+			}
+		};
+
+		struct InstrumentKeyHash
+		{
+			std::size_t operator()(InstrumentKey const& k) const
+			{
+				std::size_t h = std::hash<void const*>()(k.site);
+				h = h * 31 + std::hash<void const*>()(reinterpret_cast<void const*>(k.from));
+				h = h * 31 + std::hash<void const*>()(reinterpret_cast<void const*>(k.to));
+				return h * 31 + std::size_t(k.event);
+			}
+		};
+
+		using InstrumentTable = std::unordered_map<InstrumentKey, std::uint64_t, InstrumentKeyHash>;
+
+		/**
+		 * The counts of one thread. The mutex is only ever contended while
+		 * the counts are being read.
+		 */
+		struct InstrumentThread
+		{
+			std::mutex mutex;
+			InstrumentTable table;
+		};
+
+		/**
+		 * All live threads' counts, and the counts of threads that have
+		 * exited
+		 */
+		struct InstrumentRegistry
+		{
+			std::mutex mutex;
+			std::vector<InstrumentThread*> threads;
+			InstrumentTable retired;
+		};
+
+		inline InstrumentRegistry& instrumentRegistry()
+		{
+			static InstrumentRegistry s_registry;
+			return s_registry;
+		}
+
+		struct InstrumentSlot
+		{
+			InstrumentSlot()
+			{
+				auto& r = instrumentRegistry();
+				std::lock_guard<std::mutex> lock(r.mutex);
+				r.threads.push_back(&thread);
+			}
+
+			~InstrumentSlot()
+			{
+				auto& r = instrumentRegistry();
+				std::lock_guard<std::mutex> lock(r.mutex);
+				for(auto const& e : thread.table)
+				{
+					r.retired[e.first] += e.second;
+				}
+				r.threads.erase(std::find(r.threads.begin(), r.threads.end(), &thread));
+			}
+
+			InstrumentThread thread;
+		};
+
+		inline InstrumentThread& instrumentThread()
+		{
+			static thread_local InstrumentSlot s_slot;
+			return s_slot.thread;
+		}
+	}
+
+	namespace Instrument {
+		/**
+		 * The default hook, which counts the event for the calling thread
+		 */
+		inline void count(Event event, UnitName from, UnitName to, void const* site)
+		{
+			auto& t = _internal::instrumentThread();
+			std::lock_guard<std::mutex> lock(t.mutex);
+			t.table[_internal::InstrumentKey{ event, from, to, site }]++;
+		}
+
+		inline Hook& hookSlot()
+		{
+			static thread_local Hook s_hook = &count;
+			return s_hook;
+		}
+
+		/**
+		 * Sets the hook of the calling thread and returns the previous one.
+		 * A null hook ignores all events.
+		 */
+		inline Hook setHook(Hook hook)
+		{
+			Hook const previous = hookSlot();
+			hookSlot() = hook;
+			return previous;
+		}
+
+		/**
+		 * Clears the counts of all threads
+		 */
+		inline void reset()
+		{
+			auto& r = _internal::instrumentRegistry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			r.retired.clear();
+			for(auto* t : r.threads)
+			{
+				std::lock_guard<std::mutex> threadLock(t->mutex);
+				t->table.clear();
+			}
+		}
+
+		/**
+		 * The counts of all threads, summed per event and pair of types,
+		 * hottest first
+		 */
+		inline std::vector<Count> counts()
+		{
+			_internal::InstrumentTable all;
+			{
+				auto& r = _internal::instrumentRegistry();
+				std::lock_guard<std::mutex> lock(r.mutex);
+				all = r.retired;
+				for(auto* t : r.threads)
+				{
+					std::lock_guard<std::mutex> threadLock(t->mutex);
+					for(auto const& e : t->table)
+					{
+						all[e.first] += e.second;
+					}
+				}
+			}
+
+			// Merge the call sites of each event and pair of types
+			struct Group
+			{
+				std::uint64_t count;
+				std::uint64_t hottestCount;
+				void const* hottestSite;
+				std::size_t sites;
+			};
+			std::unordered_map<_internal::InstrumentKey, Group, _internal::InstrumentKeyHash> groups(all.size());
+			for(auto const& e : all)
+			{
+				_internal::InstrumentKey key = e.first;
+				key.site = nullptr;
+				auto& g = groups[key];
+				g.count += e.second;
+				g.sites++;
+				if(e.second > g.hottestCount)
+				{
+					g.hottestCount = e.second;
+					g.hottestSite = e.first.site;
+				}
+			}
+
+			std::vector<Count> ret;
+			for(auto const& g : groups)
+			{
+				ret.push_back(Count{ g.first.event, g.first.from(), g.first.to(), g.second.count, g.second.hottestSite, g.second.sites });
+			}
+			std::sort(ret.begin(), ret.end(), [](Count const& a, Count const& b) {
+				return a.count > b.count;
+			});
+			return ret;
+		}
+
+		/**
+		 * Writes the limit hottest counts to out, one per line
+		 */
+		inline void dump(std::ostream& out, std::size_t limit = 20)
+		{
+			auto const all = counts();
+			out << std::setw(12) << "count" << "  " << std::left << std::setw(14) << "event" << std::right << "units" << std::endl;
+			for(std::size_t i = 0; i < all.size() && i < limit; i++)
+			{
+				auto const& c = all[i];
+				auto const unit = [](std::string const& s) {
+					auto const begin = s.find_first_not_of(' ');
+					return begin == std::string::npos ? std::string("1") : s.substr(begin);
+				};
+				out << std::setw(12) << c.count << "  " << std::left << std::setw(14) << eventName(c.event) << std::right
+					<< "[" << unit(c.from) << "]";
+				if(c.event == Event::Conversion || c.event == Event::Pow)
+				{
+					out << " -> [" << unit(c.to) << "]";
+				}
+				out << " at " << c.hottestSite;
+				if(c.sites > 1)
+				{
+					out << " and " << c.sites - 1 << " more";
+				}
+				out << std::endl;
+			}
+		}
+	}
+
+	namespace _internal {
+		/**
+		 * Passes an event to the hook of the calling thread, with the
+		 * caller's return address as the call site
+		 */
+		MESI_INSTRUMENT_NOINLINE inline void instrumentEvent(Instrument::Event event, Instrument::UnitName from, Instrument::UnitName to)
+		{
+			void const* const site = MESI_RETURN_ADDRESS();
+			if(Instrument::Hook const hook = Instrument::hookSlot())
+			{
+				hook(event, from, to, site);
+			}
+		}
+	}
+}
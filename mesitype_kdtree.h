@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_parallel.h"
+
+namespace Mesi {
+	/**
+	 * @brief Static k-d tree over 3D points with coordinates of type t_length
+	 *
+	 * @param t_length type of the coordinates, e.g. Meters
+	 * @param t_leaf_size maximum number of points in a leaf
+	 *
+	 * The tree is implicit: every node splits its points in half, so the
+	 * range of points below a node follows from its position and no child
+	 * pointers are stored. Internal nodes are kept in heap order and hold
+	 * only their split axis and value. The points themselves are stored in
+	 * tree order as three coordinate arrays, so a leaf is a contiguous run
+	 * of each, and leaf scans compute squared distances for the whole leaf
+	 * in one vectorisable loop.
+	 *
+	 * Distances are compared as squares, of type Area, so no query takes a
+	 * square root. Queries report points by their index in the array the
+	 * tree was built from.
+	 */
+	template<typename t_length = Meters, std::size_t t_leaf_size = 16>
+	class KdTree
+	{
+		static_assert(t_leaf_size > 0, "Leaves must hold at least one point");
+		using T = typename t_length::BaseType;
+	public:
+		using Length = t_length;
+		using Area = decltype(t_length{} * t_length{});
+		using Point = std::array<t_length, 3>;
+
+		struct Neighbour
+		{
+			std::size_t index;
+			Area distanceSq;
+		};
+
+		static constexpr std::size_t LeafSize = t_leaf_size;
+
+		KdTree() = default;
+
+		/**
+		 * Builds the tree over n points. With a pool, the subtrees below
+		 * the first few levels are built in parallel.
+		 */
+		KdTree(Point const* points, std::size_t n, ThreadPool* pool = nullptr)
+		{
+			build(points, n, pool);
+		}
+
+		explicit KdTree(std::vector<Point> const& points, ThreadPool* pool = nullptr)
+			: KdTree(points.data(), points.size(), pool)
+		{}
+
+		std::size_t size() const
+		{
+			return m_index.size();
+		}
+
+		/**
+		 * Appends to out the indices of all points within radius of center,
+		 * in no particular order
+		 */
+		void radius(Point const& center, t_length radius, std::vector<std::size_t>& out) const
+		{
+			Query q{ { center[0].val, center[1].val, center[2].val }, T(radius.val) * T(radius.val) };
+			radiusNode(q, 0, 0, size(), 0, out);
+		}
+
+		/**
+		 * The k points nearest to query, closest first. Fewer are returned
+		 * if the tree holds fewer than k points.
+		 */
+		void nearest(Point const& query, std::size_t k, std::vector<Neighbour>& out) const
+		{
+			out.clear();
+			if(k == 0)
+			{
+				return;
+			}
+			Query q{ { query[0].val, query[1].val, query[2].val }, T(0) };
+			std::vector<Candidate> heap;
+			heap.reserve(k);
+			nearestNode(q, k, 0, 0, size(), 0, heap);
+			std::sort_heap(heap.begin(), heap.end());
+			for(auto const& c : heap)
+			{
+				out.push_back(Neighbour{ m_index[c.position], Area(c.distanceSq) });
+			}
+		}
+
+	private:
+		struct Query
+		{
+			T p[3];
+			T radiusSq;
+		};
+
+		struct Candidate
+		{
+			T distanceSq;
+			std::size_t position;
+
+			bool operator<(Candidate const& other) const
+			{
+				return distanceSq < other.distanceSq;
+			}
+		};
+
+		struct Task
+		{
+			std::size_t node;
+			std::size_t begin;
+			std::size_t end;
+			std::size_t level;
+		};
+
+		void build(Point const* points, std::size_t n, ThreadPool* pool)
+		{
+			m_levels = 0;
+			while((n >> m_levels) + ((n & ((std::size_t(1) << m_levels) - 1)) != 0) > t_leaf_size)
+			{
+				m_levels++;
+			}
+			std::size_t const internal = (std::size_t(1) << m_levels) - 1;
+			m_axis.assign(internal, 0);
+			m_split.assign(internal, T(0));
+
+			m_index.resize(n);
+			for(std::size_t i = 0; i < n; i++)
+			{
+				m_index[i] = i;
+			}
+
+			// Split sequentially until there is enough independent work
+			// for every thread, then build the subtrees in parallel
+			std::size_t const threads = pool ? pool->threads() : 1;
+			std::size_t parallelLevel = 0;
+			while(parallelLevel < m_levels && (std::size_t(1) << parallelLevel) < 4 * threads)
+			{
+				parallelLevel++;
+			}
+			if(threads == 1)
+			{
+				parallelLevel = m_levels;
+			}
+			std::vector<Task> tasks;
+			buildNode(points, Task{ 0, 0, n, 0 }, parallelLevel, tasks);
+			if(!tasks.empty())
+			{
+				pool->run(tasks.size(), [&](std::size_t i) {
+					buildNode(points, tasks[i], m_levels, tasks);
+				});
+			}
+
+			for(std::size_t d = 0; d < 3; d++)
+			{
+				m_coord[d].resize(n);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					m_coord[d][i] = points[m_index[i]][d].val;
+				}
+			}
+		}
+
+		/**
+		 * Partitions the points below a node, stopping at stopLevel and
+		 * recording the unfinished subtrees in tasks
+		 */
+		void buildNode(Point const* points, Task t, std::size_t stopLevel, std::vector<Task>& tasks)
+		{
+			if(t.level == m_levels)
+			{
+				return;
+			}
+			if(t.level == stopLevel)
+			{
+				tasks.push_back(t);
+				return;
+			}
+
+			// Split along the axis with the largest spread
+			T lo[3], hi[3];
+			for(std::size_t d = 0; d < 3; d++)
+			{
+				lo[d] = hi[d] = t.begin < t.end ? points[m_index[t.begin]][d].val : T(0);
+			}
+			for(std::size_t i = t.begin; i < t.end; i++)
+			{
+				for(std::size_t d = 0; d < 3; d++)
+				{
+					T const v = points[m_index[i]][d].val;
+					lo[d] = std::min(lo[d], v);
+					hi[d] = std::max(hi[d], v);
+				}
+			}
+			std::size_t axis = 0;
+			for(std::size_t d = 1; d < 3; d++)
+			{
+				if(hi[d] - lo[d] > hi[axis] - lo[axis])
+				{
+					axis = d;
+				}
+			}
+
+			std::size_t const mid = t.begin + (t.end - t.begin) / 2;
+			auto const first = m_index.begin();
+			std::nth_element(first + t.begin, first + mid, first + t.end, [&](std::size_t a, std::size_t b) {
+				return points[a][axis] < points[b][axis];
+			});
+			m_axis[t.node] = static_cast<unsigned char>(axis);
+			m_split[t.node] = mid < t.end ? points[m_index[mid]][axis].val : T(0);
+
+			buildNode(points, Task{ 2 * t.node + 1, t.begin, mid, t.level + 1 }, stopLevel, tasks);
+			buildNode(points, Task{ 2 * t.node + 2, mid, t.end, t.level + 1 }, stopLevel, tasks);
+		}
+
+		/**
+		 * Squared distances from q to the points of the leaf [begin, end)
+		 */
+		void leafDistances(Query const& q, std::size_t begin, std::size_t end, T* d2) const
+		{
+			T const* x = m_coord[0].data() + begin;
+			T const* y = m_coord[1].data() + begin;
+			T const* z = m_coord[2].data() + begin;
+			for(std::size_t i = 0; i < end - begin; i++)
+			{
+				T const dx = x[i] - q.p[0];
+				T const dy = y[i] - q.p[1];
+				T const dz = z[i] - q.p[2];
+				d2[i] = dx * dx + dy * dy + dz * dz;
+			}
+		}
+
+		void radiusNode(Query const& q, std::size_t node, std::size_t begin, std::size_t end, std::size_t level, std::vector<std::size_t>& out) const
+		{
+			if(level == m_levels)
+			{
+				T d2[t_leaf_size];
+				leafDistances(q, begin, end, d2);
+				for(std::size_t i = 0; i < end - begin; i++)
+				{
+					if(d2[i] <= q.radiusSq)
+					{
+						out.push_back(m_index[begin + i]);
+					}
+				}
+				return;
+			}
+			std::size_t const mid = begin + (end - begin) / 2;
+			T const diff = q.p[m_axis[node]] - m_split[node];
+			if(diff < T(0))
+			{
+				radiusNode(q, 2 * node + 1, begin, mid, level + 1, out);
+				if(diff * diff <= q.radiusSq)
+				{
+					radiusNode(q, 2 * node + 2, mid, end, level + 1, out);
+				}
+			}
+			else
+			{
+				radiusNode(q, 2 * node + 2, mid, end, level + 1, out);
+				if(diff * diff <= q.radiusSq)
+				{
+					radiusNode(q, 2 * node + 1, begin, mid, level + 1, out);
+				}
+			}
+		}
+
+		/**
+		 * Keeps the k closest points seen so far in a max-heap on distance
+		 */
+		void nearestNode(Query const& q, std::size_t k, std::size_t node, std::size_t begin, std::size_t end, std::size_t level, std::vector<Candidate>& heap) const
+		{
+			if(level == m_levels)
+			{
+				T d2[t_leaf_size];
+				leafDistances(q, begin, end, d2);
+				for(std::size_t i = 0; i < end - begin; i++)
+				{
+					if(heap.size() < k)
+					{
+						heap.push_back(Candidate{ d2[i], begin + i });
+						std::push_heap(heap.begin(), heap.end());
+					}
+					else if(d2[i] < heap.front().distanceSq)
+					{
+						std::pop_heap(heap.begin(), heap.end());
+						heap.back() = Candidate{ d2[i], begin + i };
+						std::push_heap(heap.begin(), heap.end());
+					}
+				}
+				return;
+			}
+			std::size_t const mid = begin + (end - begin) / 2;
+			T const diff = q.p[m_axis[node]] - m_split[node];
+			bool const left = diff < T(0);
+			if(left)
+			{
+				nearestNode(q, k, 2 * node + 1, begin, mid, level + 1, heap);
+			}
+			else
+			{
+				nearestNode(q, k, 2 * node + 2, mid, end, level + 1, heap);
+			}
+			if(heap.size() < k || diff * diff < heap.front().distanceSq)
+			{
+				if(left)
+				{
+					nearestNode(q, k, 2 * node + 2, mid, end, level + 1, heap);
+				}
+				else
+				{
+					nearestNode(q, k, 2 * node + 1, begin, mid, level + 1, heap);
+				}
+			}
+		}
+
+		std::size_t m_levels = 0;
+		std::vector<unsigned char> m_axis;
+		std::vector<T> m_split;
+		std::vector<std::size_t> m_index;
+		std::array<std::vector<T>, 3> m_coord;
+	};
+}
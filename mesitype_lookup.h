@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	enum class Interpolation
+	{
+		Linear,
+		Cubic
+	};
+
+	/**
+	 * @brief Interpolating lookup table from X to Y
+	 *
+	 * @param X type of the breakpoints, e.g. Kelvin
+	 * @param Y type of the tabulated values, e.g. Ohms
+	 * @param N number of breakpoints, at least 2
+	 * @param t_interpolation Linear, or Cubic for a cubic Hermite curve whose
+	 *        slopes are taken from the parabola through each point and its
+	 *        neighbours
+	 *
+	 * Breakpoints are either evenly spaced, in which case the interval is
+	 * found with a multiplication, or arbitrary but increasing, in which
+	 * case it is found by binary search. Inputs outside the breakpoints are
+	 * clamped to the first or last value.
+	 *
+	 * Construction and evaluation are constexpr, so a table built from
+	 * constant data or a constexpr generator can be evaluated at compile
+	 * time. Values are stored untyped, and every public function takes and
+	 * returns X and Y.
+	 */
+	template<typename X, typename Y, std::size_t N, Interpolation t_interpolation = Interpolation::Linear>
+	class LookupTable
+	{
+		static_assert(N >= 2, "A lookup table needs at least two breakpoints");
+		using TX = typename X::BaseType;
+		using T = typename Y::BaseType;
+	public:
+		using Input = X;
+		using Output = Y;
+		using Slope = decltype(Y{} / X{});
+
+		static constexpr std::size_t Size = N;
+
+		/**
+		 * Table with N evenly spaced breakpoints from first to last
+		 */
+		static constexpr LookupTable uniform(X first, X last, Y const (&values)[N])
+		{
+			LookupTable ret;
+			ret.m_uniform = true;
+			for(std::size_t i = 0; i < N; i++)
+			{
+				ret.m_x[i] = first.val + (last.val - first.val) * TX(i) / TX(N - 1);
+				ret.m_y[i] = values[i].val;
+			}
+			ret.init();
+			return ret;
+		}
+
+		/**
+		 * Table with N evenly spaced breakpoints from first to last, with
+		 * values f(x). f may be a constexpr function or function object, in
+		 * which case the whole table can be built at compile time.
+		 */
+		template<typename F>
+		static constexpr LookupTable generate(X first, X last, F f)
+		{
+			LookupTable ret;
+			ret.m_uniform = true;
+			for(std::size_t i = 0; i < N; i++)
+			{
+				ret.m_x[i] = first.val + (last.val - first.val) * TX(i) / TX(N - 1);
+				ret.m_y[i] = Y(f(X(ret.m_x[i]))).val;
+			}
+			ret.init();
+			return ret;
+		}
+
+		/**
+		 * Table with arbitrary, strictly increasing breakpoints
+		 */
+		static constexpr LookupTable nonUniform(X const (&breakpoints)[N], Y const (&values)[N])
+		{
+			LookupTable ret;
+			ret.m_uniform = false;
+			for(std::size_t i = 0; i < N; i++)
+			{
+				ret.m_x[i] = breakpoints[i].val;
+				ret.m_y[i] = values[i].val;
+			}
+			ret.init();
+			return ret;
+		}
+
+		constexpr X breakpoint(std::size_t i) const
+		{
+			return X(m_x[i]);
+		}
+
+		constexpr Y value(std::size_t i) const
+		{
+			return Y(m_y[i]);
+		}
+
+		/**
+		 * Slope of the curve at breakpoint i. Only used by cubic tables.
+		 */
+		constexpr Slope slope(std::size_t i) const
+		{
+			return Slope(m_slope[i]);
+		}
+
+		constexpr Y operator()(X x) const
+		{
+			return Y(evalRaw(x.val));
+		}
+
+		/**
+		 * Evaluates the table for n inputs. For evenly spaced tables this
+		 * runs in blocks without branches, so it vectorises into gathered
+		 * loads; results go through a local block, which the compiler knows
+		 * cannot alias the table.
+		 */
+		void eval(X const* in, Y* out, std::size_t n) const
+		{
+			constexpr std::size_t block = 64;
+			TX const* x = _internal::raw(in);
+			T* y = _internal::raw(out);
+			if(!m_uniform)
+			{
+				for(std::size_t i = 0; i < n; i++)
+				{
+					y[i] = searchEval(x[i]);
+				}
+				return;
+			}
+			TX pos[block];
+			T tmp[block];
+			for(std::size_t begin = 0; begin < n; begin += block)
+			{
+				std::size_t const count = n - begin < block ? n - begin : block;
+				for(std::size_t i = 0; i < count; i++)
+				{
+					pos[i] = position(x[begin + i]);
+				}
+				for(std::size_t i = 0; i < count; i++)
+				{
+					tmp[i] = atPosition(pos[i]);
+				}
+				std::copy(tmp, tmp + count, y + begin);
+			}
+		}
+
+		/**
+		 * Evaluates the table for every input in in. Throws
+		 * std::invalid_argument unless out has the size of in.
+		 */
+		void eval(Span<X const> in, Span<Y> out) const
+		{
+			if(in.size() != out.size())
+			{
+				throw std::invalid_argument("The input and output of a table lookup must have the same size");
+			}
+			eval(in.data(), out.data(), in.size());
+		}
+
+	private:
+		constexpr LookupTable()
+			: m_x{}, m_y{}, m_slope{}, m_invStep(0), m_uniform(false)
+		{}
+
+		constexpr void init()
+		{
+			m_invStep = TX(N - 1) / (m_x[N - 1] - m_x[0]);
+			if(t_interpolation != Interpolation::Cubic)
+			{
+				return;
+			}
+			if(N == 2)
+			{
+				m_slope[0] = m_slope[1] = secant(0);
+				return;
+			}
+			// Derivative of the parabola through each point and its
+			// neighbours, one-sided at the ends
+			for(std::size_t i = 1; i + 1 < N; i++)
+			{
+				T const h0 = T(m_x[i] - m_x[i - 1]);
+				T const h1 = T(m_x[i + 1] - m_x[i]);
+				m_slope[i] = (secant(i - 1) * h1 + secant(i) * h0) / (h0 + h1);
+			}
+			{
+				T const h0 = T(m_x[1] - m_x[0]);
+				T const h1 = T(m_x[2] - m_x[1]);
+				m_slope[0] = ((T(2) * h0 + h1) * secant(0) - h0 * secant(1)) / (h0 + h1);
+			}
+			{
+				T const h0 = T(m_x[N - 2] - m_x[N - 3]);
+				T const h1 = T(m_x[N - 1] - m_x[N - 2]);
+				m_slope[N - 1] = ((T(2) * h1 + h0) * secant(N - 2) - h1 * secant(N - 3)) / (h0 + h1);
+			}
+		}
+
+		constexpr T secant(std::size_t i) const
+		{
+			return (m_y[i + 1] - m_y[i]) / T(m_x[i + 1] - m_x[i]);
+		}
+
+		/**
+		 * Position of x in units of the breakpoint spacing, clamped to the
+		 * table
+		 */
+		constexpr TX position(TX x) const
+		{
+			TX const t = (x - m_x[0]) * m_invStep;
+			return t < TX(0) ? TX(0) : t > TX(N - 1) ? TX(N - 1) : t;
+		}
+
+		/**
+		 * Value at a position returned by position(). Kept apart from the
+		 * clamping, because a conversion to int behind a branch stops GCC
+		 * from vectorising the loop.
+		 */
+		constexpr T atPosition(TX t) const
+		{
+			int const i = int(t) < int(N - 2) ? int(t) : int(N - 2);
+			return interpolate(std::size_t(i), T(t - TX(i)));
+		}
+
+		constexpr T uniformEval(TX x) const
+		{
+			return atPosition(position(x));
+		}
+
+		/**
+		 * Binary search for the interval [i, i + 1] of arbitrary breakpoints
+		 * containing x
+		 */
+		constexpr T searchEval(TX x) const
+		{
+			std::size_t lo = 0;
+			std::size_t hi = N - 1;
+			while(hi - lo > 1)
+			{
+				std::size_t const mid = (lo + hi) / 2;
+				if(m_x[mid] <= x)
+				{
+					lo = mid;
+				}
+				else
+				{
+					hi = mid;
+				}
+			}
+			T t = T(x - m_x[lo]) / T(m_x[lo + 1] - m_x[lo]);
+			t = t < T(0) ? T(0) : t;
+			t = t > T(1) ? T(1) : t;
+			return interpolate(lo, t);
+		}
+
+		/**
+		 * Value at fraction t of the interval [i, i + 1]
+		 */
+		constexpr T interpolate(std::size_t i, T t) const
+		{
+			if(t_interpolation == Interpolation::Linear)
+			{
+				return m_y[i] + (m_y[i + 1] - m_y[i]) * t;
+			}
+			T const h = T(m_x[i + 1] - m_x[i]);
+			T const t2 = t * t;
+			T const t3 = t2 * t;
+			return (T(2) * t3 - T(3) * t2 + T(1)) * m_y[i]
+				+ (t3 - T(2) * t2 + t) * h * m_slope[i]
+				+ (T(3) * t2 - T(2) * t3) * m_y[i + 1]
+				+ (t3 - t2) * h * m_slope[i + 1];
+		}
+
+		constexpr T evalRaw(TX x) const
+		{
+			return m_uniform ? uniformEval(x) : searchEval(x);
+		}
+
+		TX m_x[N];
+		T m_y[N];
+		T m_slope[N];
+		TX m_invStep;
+		bool m_uniform;
+	};
+
+	namespace _internal {
+		template<typename F, std::size_t... t_i>
+		constexpr auto makeTable(F const& f, std::index_sequence<t_i...>)
+			-> std::array<std::decay_t<decltype(f(std::size_t(0)))>, sizeof...(t_i)>
+		{
+			return {{ f(t_i)... }};
+		}
+
+		template<std::size_t t_row, typename F, std::size_t... t_j>
+		constexpr auto makeTableRow(F const& f, std::index_sequence<t_j...>)
+			-> std::array<std::decay_t<decltype(f(std::size_t(0), std::size_t(0)))>, sizeof...(t_j)>
+		{
+			return {{ f(t_row, t_j)... }};
+		}
+
+		template<std::size_t t_columns, typename F, std::size_t... t_i>
+		constexpr auto makeTable2(F const& f, std::index_sequence<t_i...>)
+			-> std::array<std::array<std::decay_t<decltype(f(std::size_t(0), std::size_t(0)))>, t_columns>, sizeof...(t_i)>
+		{
+			return {{ makeTableRow<t_i>(f, std::make_index_sequence<t_columns>())... }};
+		}
+	}
+
+	/**
+	 * The array of f(0), ..., f(N - 1), with the type f returns, e.g.
+	 *
+	 *     struct Celsius
+	 *     {
+	 *         constexpr Kelvin operator()(std::size_t i) const { return Kelvin(273.15f + i); }
+	 *     };
+	 *     constexpr auto freezing = make_table<100>(Celsius());
+	 *
+	 * If f is a constexpr function or function object, the table can be
+	 * a constant, which is stored in the program instead of being filled
+	 * in at startup.
+	 */
+	template<std::size_t N, typename F>
+	constexpr auto make_table(F const& f)
+	{
+		return _internal::makeTable(f, std::make_index_sequence<N>());
+	}
+
+	/**
+	 * The N by M array of arrays of f(i, j), e.g. for the factors between
+	 * prefixes
+	 */
+	template<std::size_t N, std::size_t M, typename F>
+	constexpr auto make_table(F const& f)
+	{
+		return _internal::makeTable2<M>(f, std::make_index_sequence<N>());
+	}
+}
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	/**
+	 * Compile-time list of Mesi types, used to describe the units of the
+	 * rows and columns of a Matrix.
+	 */
+	template<typename... t_types>
+	struct UnitList
+	{
+		static constexpr std::size_t size = sizeof...(t_types);
+
+		template<std::size_t i>
+		using At = typename std::tuple_element<i, std::tuple<t_types...>>::type;
+	};
+
+	namespace _internal {
+		/**
+		 * Calls f(i) for every i in [t_begin, t_end), expanded at compile
+		 * time rather than as a loop
+		 */
+		template<std::size_t t_begin, std::size_t t_end>
+		struct Unroll
+		{
+			template<typename F>
+			static void apply(F&& f)
+			{
+				f(t_begin);
+				Unroll<t_begin + 1, t_end>::apply(f);
+			}
+		};
+
+		template<std::size_t t_end>
+		struct Unroll<t_end, t_end>
+		{
+			template<typename F>
+			static void apply(F&&)
+			{}
+		};
+
+		/**
+		 * UnitList with every entry replaced by its reciprocal
+		 */
+		template<typename t_list>
+		struct InvertUnits;
+
+		template<typename... t_types>
+		struct InvertUnits<UnitList<t_types...>>
+		{
+			using List = UnitList<decltype(typename t_types::ScalarType{} / t_types{})...>;
+		};
+
+		/**
+		 * UnitList holding the dimensionless type of each entry
+		 */
+		template<typename t_list>
+		struct ScalarUnits;
+
+		template<typename... t_types>
+		struct ScalarUnits<UnitList<t_types...>>
+		{
+			using List = UnitList<typename t_types::ScalarType...>;
+		};
+
+		/**
+		 * Checks that all entries of a UnitList share the same storage type
+		 */
+		template<typename T, typename... t_types>
+		struct SameBaseType : std::true_type {};
+
+		template<typename T, typename t_first, typename... t_rest>
+		struct SameBaseType<T, t_first, t_rest...>
+			: std::integral_constant<bool, std::is_same<T, typename t_first::BaseType>::value && SameBaseType<T, t_rest...>::value> {};
+
+		template<typename t_list>
+		struct ListBaseType;
+
+		template<typename t_first, typename... t_rest>
+		struct ListBaseType<UnitList<t_first, t_rest...>>
+		{
+			using Type = typename t_first::BaseType;
+			static constexpr bool consistent = SameBaseType<Type, t_rest...>::value;
+		};
+
+		/**
+		 * Number of elements of type T needed to pad n elements to a
+		 * multiple of MESI_SIMD_ALIGNMENT bytes
+		 */
+		template<typename T, std::size_t n>
+		struct PaddedSize
+		{
+		private:
+			static constexpr std::size_t lanes = (MESI_SIMD_ALIGNMENT % sizeof(T) == 0 && MESI_SIMD_ALIGNMENT >= sizeof(T)) ? MESI_SIMD_ALIGNMENT / sizeof(T) : 1;
+		public:
+			static constexpr std::size_t value = (n + lanes - 1) / lanes * lanes;
+		};
+	}
+
+	/**
+	 * @brief Fixed-size matrix with per-row and per-column units
+	 *
+	 * @param t_rows UnitList of the row units
+	 * @param t_cols UnitList of the column units
+	 *
+	 * Entry (i,j) has the type Row_i / Col_j, so a Matrix<R, C> maps a column
+	 * vector with units C to one with units R. A covariance matrix of a state
+	 * x is Matrix<X, InvertUnits<X>>, and a column vector is a Matrix with a
+	 * single dimensionless column.
+	 *
+	 * Values are stored untyped in row-major order, with each row padded to
+	 * a multiple of MESI_SIMD_ALIGNMENT bytes. Since all scaling factors
+	 * cancel out along the inner dimension of a product, every kernel below
+	 * works on the stored values directly and the units are only checked at
+	 * compile time.
+	 */
+	template<typename t_rows, typename t_cols>
+	struct Matrix
+	{
+		using Rows = t_rows;
+		using Cols = t_cols;
+		using BaseType = typename _internal::ListBaseType<Rows>::Type;
+
+		static_assert(_internal::ListBaseType<Rows>::consistent && _internal::ListBaseType<Cols>::consistent
+			&& std::is_same<BaseType, typename _internal::ListBaseType<Cols>::Type>::value,
+			"All row and column units must use the same storage type");
+
+		static constexpr std::size_t RowCount = Rows::size;
+		static constexpr std::size_t ColCount = Cols::size;
+		static constexpr std::size_t Stride = _internal::PaddedSize<BaseType, ColCount>::value;
+
+		template<std::size_t i, std::size_t j>
+		using Element = decltype(typename Rows::template At<i>{} / typename Cols::template At<j>{});
+
+		using Transposed = Matrix<typename _internal::InvertUnits<Cols>::List, typename _internal::InvertUnits<Rows>::List>;
+		using Inverse = Matrix<Cols, Rows>;
+		using CholeskyFactor = Matrix<Rows, typename _internal::ScalarUnits<Rows>::List>;
+
+		alignas(MESI_SIMD_ALIGNMENT) BaseType data[RowCount][Stride];
+
+		/**
+		 * Creates a matrix with all entries, including the padding, set to zero
+		 */
+		Matrix()
+		{
+			for(std::size_t i = 0; i < RowCount; i++)
+			{
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					data[i][j] = BaseType(0);
+				}
+			}
+		}
+
+		/**
+		 * Identity matrix. Only exists if all diagonal entries are
+		 * dimensionless and unscaled.
+		 */
+		static Matrix Identity()
+		{
+			static_assert(RowCount == ColCount, "Only square matrices have an identity");
+			Matrix ret;
+			_internal::Unroll<0, RowCount>::apply([&](std::size_t i) {
+				ret.data[i][i] = BaseType(1);
+			});
+			ret.checkDimensionlessDiagonal(std::integral_constant<std::size_t, 0>{});
+			return ret;
+		}
+
+		template<std::size_t i, std::size_t j>
+		Element<i, j> get() const
+		{
+			static_assert(i < RowCount && j < ColCount, "Index out of range");
+			return Element<i, j>(data[i][j]);
+		}
+
+		template<std::size_t i, std::size_t j>
+		void set(Element<i, j> const& v)
+		{
+			static_assert(i < RowCount && j < ColCount, "Index out of range");
+			data[i][j] = v.val;
+		}
+
+		/**
+		 * Unchecked access to the stored value, in the units of Element<i,j>
+		 */
+		BaseType& raw(std::size_t i, std::size_t j)
+		{
+			return data[i][j];
+		}
+
+		BaseType const& raw(std::size_t i, std::size_t j) const
+		{
+			return data[i][j];
+		}
+
+		Transposed transpose() const
+		{
+			Transposed ret;
+			_internal::Unroll<0, RowCount>::apply([&](std::size_t i) {
+				_internal::Unroll<0, ColCount>::apply([&](std::size_t j) {
+					ret.data[j][i] = data[i][j];
+				});
+			});
+			return ret;
+		}
+
+		/**
+		 * Gauss-Jordan inversion with partial pivoting. A singular matrix
+		 * results in non-finite entries, just as dividing by zero would.
+		 */
+		Inverse inverse() const
+		{
+			static_assert(RowCount == ColCount, "Only square matrices can be inverted");
+			constexpr std::size_t n = RowCount;
+			BaseType a[n][Stride];
+			Inverse ret = Inverse::rawIdentity();
+
+			for(std::size_t i = 0; i < n; i++)
+			{
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					a[i][j] = data[i][j];
+				}
+			}
+
+			for(std::size_t col = 0; col < n; col++)
+			{
+				std::size_t pivot = col;
+				for(std::size_t i = col + 1; i < n; i++)
+				{
+					if(std::abs(a[i][col]) > std::abs(a[pivot][col]))
+					{
+						pivot = i;
+					}
+				}
+				if(pivot != col)
+				{
+					for(std::size_t j = 0; j < Stride; j++)
+					{
+						std::swap(a[pivot][j], a[col][j]);
+						std::swap(ret.data[pivot][j], ret.data[col][j]);
+					}
+				}
+
+				BaseType const inv = BaseType(1) / a[col][col];
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					a[col][j] *= inv;
+					ret.data[col][j] *= inv;
+				}
+
+				for(std::size_t i = 0; i < n; i++)
+				{
+					if(i == col)
+					{
+						continue;
+					}
+					BaseType const f = a[i][col];
+					for(std::size_t j = 0; j < Stride; j++)
+					{
+						a[i][j] -= f * a[col][j];
+						ret.data[i][j] -= f * ret.data[col][j];
+					}
+				}
+			}
+			return ret;
+		}
+
+		/**
+		 * Cholesky decomposition of a symmetric positive definite matrix,
+		 * returning the lower triangular L with L * L^T == *this.
+		 *
+		 * The matrix must have the units of a covariance, i.e. Col_j ==
+		 * 1/Row_j. The rows of L then carry the row units of this matrix and
+		 * its columns are dimensionless.
+		 */
+		CholeskyFactor cholesky() const
+		{
+			static_assert(RowCount == ColCount, "Only square matrices have a Cholesky decomposition");
+			static_assert(std::is_same<Cols, typename _internal::InvertUnits<Rows>::List>::value,
+				"Cholesky decomposition requires covariance units, i.e. Col_j == 1/Row_j");
+			constexpr std::size_t n = RowCount;
+			CholeskyFactor ret;
+
+			for(std::size_t j = 0; j < n; j++)
+			{
+				BaseType d = data[j][j];
+				for(std::size_t k = 0; k < j; k++)
+				{
+					d -= ret.data[j][k] * ret.data[j][k];
+				}
+				d = std::sqrt(d);
+				ret.data[j][j] = d;
+
+				BaseType const inv = BaseType(1) / d;
+				for(std::size_t i = j + 1; i < n; i++)
+				{
+					BaseType s = data[i][j];
+					for(std::size_t k = 0; k < j; k++)
+					{
+						s -= ret.data[i][k] * ret.data[j][k];
+					}
+					ret.data[i][j] = s * inv;
+				}
+			}
+			return ret;
+		}
+
+		Matrix& operator+=(Matrix const& rhs)
+		{
+			_internal::Unroll<0, RowCount>::apply([&](std::size_t i) {
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					data[i][j] += rhs.data[i][j];
+				}
+			});
+			return *this;
+		}
+
+		Matrix& operator-=(Matrix const& rhs)
+		{
+			_internal::Unroll<0, RowCount>::apply([&](std::size_t i) {
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					data[i][j] -= rhs.data[i][j];
+				}
+			});
+			return *this;
+		}
+
+		Matrix& operator*=(BaseType const& rhs)
+		{
+			_internal::Unroll<0, RowCount>::apply([&](std::size_t i) {
+				for(std::size_t j = 0; j < Stride; j++)
+				{
+					data[i][j] *= rhs;
+				}
+			});
+			return *this;
+		}
+
+	private:
+		template<typename, typename> friend struct Matrix;
+
+		/**
+		 * Identity on the stored values, without any unit checking. Used as
+		 * the starting point for inversion, where the scaling factors of
+		 * the result cancel out.
+		 */
+		static Matrix rawIdentity()
+		{
+			Matrix ret;
+			for(std::size_t i = 0; i < RowCount && i < ColCount; i++)
+			{
+				ret.data[i][i] = BaseType(1);
+			}
+			return ret;
+		}
+
+		void checkDimensionlessDiagonal(std::integral_constant<std::size_t, RowCount>) const
+		{}
+
+		template<std::size_t i>
+		void checkDimensionlessDiagonal(std::integral_constant<std::size_t, i>) const
+		{
+			static_assert(std::is_same<Element<i, i>, typename Element<i, i>::ScalarType>::value,
+				"Identity requires dimensionless, unscaled diagonal entries");
+			checkDimensionlessDiagonal(std::integral_constant<std::size_t, i + 1>{});
+		}
+	};
+
+	template<typename t_rows, typename t_cols>
+	Matrix<t_rows, t_cols> operator+(Matrix<t_rows, t_cols> left, Matrix<t_rows, t_cols> const& right)
+	{
+		return left += right;
+	}
+
+	template<typename t_rows, typename t_cols>
+	Matrix<t_rows, t_cols> operator-(Matrix<t_rows, t_cols> left, Matrix<t_rows, t_cols> const& right)
+	{
+		return left -= right;
+	}
+
+	template<typename t_rows, typename t_cols>
+	Matrix<t_rows, t_cols> operator*(Matrix<t_rows, t_cols> left, typename Matrix<t_rows, t_cols>::BaseType const& right)
+	{
+		return left *= right;
+	}
+
+	template<typename t_rows, typename t_cols>
+	Matrix<t_rows, t_cols> operator*(typename Matrix<t_rows, t_cols>::BaseType const& left, Matrix<t_rows, t_cols> right)
+	{
+		return right *= left;
+	}
+
+	/**
+	 * Matrix product. The column units of the left operand must match the
+	 * row units of the right one, so every term of a dot product has the
+	 * same type Row_i / Col_j.
+	 */
+	template<typename t_rows, typename t_inner, typename t_cols>
+	Matrix<t_rows, t_cols> operator*(Matrix<t_rows, t_inner> const& left, Matrix<t_inner, t_cols> const& right)
+	{
+		using Result = Matrix<t_rows, t_cols>;
+		using T = typename Result::BaseType;
+		Result ret;
+		_internal::Unroll<0, Result::RowCount>::apply([&](std::size_t i) {
+			_internal::Unroll<0, t_inner::size>::apply([&](std::size_t k) {
+				T const a = left.data[i][k];
+				for(std::size_t j = 0; j < Result::Stride; j++)
+				{
+					ret.data[i][j] += a * right.data[k][j];
+				}
+			});
+		});
+		return ret;
+	}
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	namespace _internal {
+		template<typename t_state, typename t_time>
+		struct OdeDerivative;
+
+		template<typename... t_components, typename t_time>
+		struct OdeDerivative<std::tuple<t_components...>, t_time>
+		{
+			using Type = std::tuple<decltype(t_components{} / t_time{})...>;
+		};
+
+		/**
+		 * Applies f to the i-th elements of all tuples, for every i, and
+		 * returns the results as a tuple
+		 */
+		template<std::size_t i, typename F, typename... t_tuples>
+		auto zipAt(F& f, t_tuples const&... ts)
+		{
+			return f(std::get<i>(ts)...);
+		}
+
+		template<typename F, std::size_t... is, typename... t_tuples>
+		auto zipTuples(F&& f, std::index_sequence<is...>, t_tuples const&... ts)
+		{
+			return std::make_tuple(zipAt<is>(f, ts...)...);
+		}
+
+		template<typename F, typename t_tuple, typename... t_tuples>
+		auto zipTuples(F&& f, t_tuple const& t, t_tuples const&... ts)
+		{
+			return zipTuples(f, std::make_index_sequence<std::tuple_size<t_tuple>::value>{}, t, ts...);
+		}
+
+		/**
+		 * The largest element of t, or NaN if any element is NaN
+		 */
+		template<typename t_tuple, std::size_t... is>
+		auto tupleMax(t_tuple const& t, std::index_sequence<is...>)
+		{
+			auto ret = std::get<0>(t);
+			int expand[] = {(ret = ret < std::get<is>(t) || std::get<is>(t) != std::get<is>(t) ? std::get<is>(t) : ret, 0)...};
+			(void)expand;
+			return ret;
+		}
+
+		template<typename t_time>
+		t_time scaleTime(t_time const& dt, double c)
+		{
+			return dt * typename t_time::BaseType(c);
+		}
+
+		template<typename F, typename t_state, typename t_time>
+		struct OdeCheck
+		{
+			using Derivative = typename OdeDerivative<t_state, t_time>::Type;
+			static_assert(std::is_same<typename std::decay<decltype(std::declval<F&>()(std::declval<t_time>(), std::declval<t_state const&>()))>::type, Derivative>::value,
+				"The derivative function must return a tuple of state / time");
+		};
+	}
+
+	/**
+	 * The type of the time derivative of a state tuple, i.e. every
+	 * component divided by t_time
+	 */
+	template<typename t_state, typename t_time = Seconds>
+	using Derivative = typename _internal::OdeDerivative<t_state, t_time>::Type;
+
+	/**
+	 * One step of the classical fourth order Runge-Kutta method.
+	 *
+	 * @param f derivative function, called as f(t, state) and returning a
+	 *        Derivative<t_state, t_time>
+	 * @param t time at the start of the step
+	 * @param y state tuple at the start of the step
+	 * @param dt step size
+	 */
+	template<typename F, typename t_state, typename t_time>
+	t_state rk4Step(F&& f, t_time t, t_state const& y, t_time dt)
+	{
+		(void)_internal::OdeCheck<F, t_state, t_time>{};
+		auto const half = _internal::scaleTime(dt, 0.5);
+		auto const sixth = _internal::scaleTime(dt, 1./6);
+		auto step = [](t_time h) {
+			return [h](auto const& y_i, auto const& k_i) { return y_i + k_i * h; };
+		};
+
+		auto const k1 = f(t, y);
+		auto const k2 = f(t + half, t_state(_internal::zipTuples(step(half), y, k1)));
+		auto const k3 = f(t + half, t_state(_internal::zipTuples(step(half), y, k2)));
+		auto const k4 = f(t + dt, t_state(_internal::zipTuples(step(dt), y, k3)));
+
+		return t_state(_internal::zipTuples([sixth](auto const& y_i, auto const& a, auto const& b, auto const& c, auto const& d) {
+			return y_i + (a + b + b + c + c + d) * sixth;
+		}, y, k1, k2, k3, k4));
+	}
+
+	/**
+	 * Result of an adaptive step: the new state if the step was accepted,
+	 * and the step size to try next in either case.
+	 */
+	template<typename t_state, typename t_time>
+	struct AdaptiveStep
+	{
+		t_state state;
+		t_time dt;
+		bool accepted;
+	};
+
+	/**
+	 * One step of the Dormand-Prince 5(4) method with error control.
+	 *
+	 * The local error of each component is compared against
+	 * atol + rtol * |y|, with atol given in the units of the state. The
+	 * returned step is only accepted if all components are within their
+	 * tolerance; otherwise state holds the unchanged y and dt a smaller
+	 * step to retry with. Throws std::domain_error if the error estimate
+	 * is not finite, e.g. because f returned NaN, as no step size would
+	 * make it acceptable.
+	 */
+	template<typename F, typename t_state, typename t_time>
+	AdaptiveStep<t_state, t_time> rk45Step(F&& f, t_time t, t_state const& y, t_time dt, t_state const& atol, typename t_time::BaseType rtol)
+	{
+		(void)_internal::OdeCheck<F, t_state, t_time>{};
+		using T = typename t_time::BaseType;
+		using _internal::scaleTime;
+		using _internal::zipTuples;
+
+		auto const k1 = f(t, y);
+		auto const k2 = f(t + scaleTime(dt, 1./5), t_state(zipTuples([&](auto const& y_i, auto const& a) {
+			return y_i + a * scaleTime(dt, 1./5);
+		}, y, k1)));
+		auto const k3 = f(t + scaleTime(dt, 3./10), t_state(zipTuples([&](auto const& y_i, auto const& a, auto const& b) {
+			return y_i + a * scaleTime(dt, 3./40) + b * scaleTime(dt, 9./40);
+		}, y, k1, k2)));
+		auto const k4 = f(t + scaleTime(dt, 4./5), t_state(zipTuples([&](auto const& y_i, auto const& a, auto const& b, auto const& c) {
+			return y_i + a * scaleTime(dt, 44./45) + b * scaleTime(dt, -56./15) + c * scaleTime(dt, 32./9);
+		}, y, k1, k2, k3)));
+		auto const k5 = f(t + scaleTime(dt, 8./9), t_state(zipTuples([&](auto const& y_i, auto const& a, auto const& b, auto const& c, auto const& d) {
+			return y_i + a * scaleTime(dt, 19372./6561) + b * scaleTime(dt, -25360./2187) + c * scaleTime(dt, 64448./6561) + d * scaleTime(dt, -212./729);
+		}, y, k1, k2, k3, k4)));
+		auto const k6 = f(t + dt, t_state(zipTuples([&](auto const& y_i, auto const& a, auto const& b, auto const& c, auto const& d, auto const& e) {
+			return y_i + a * scaleTime(dt, 9017./3168) + b * scaleTime(dt, -355./33) + c * scaleTime(dt, 46732./5247) + d * scaleTime(dt, 49./176) + e * scaleTime(dt, -5103./18656);
+		}, y, k1, k2, k3, k4, k5)));
+		auto const y5 = t_state(zipTuples([&](auto const& y_i, auto const& a, auto const& c, auto const& d, auto const& e, auto const& g) {
+			return y_i + a * scaleTime(dt, 35./384) + c * scaleTime(dt, 500./1113) + d * scaleTime(dt, 125./192) + e * scaleTime(dt, -2187./6784) + g * scaleTime(dt, 11./84);
+		}, y, k1, k3, k4, k5, k6));
+		auto const k7 = f(t + dt, y5);
+
+		// Difference between the fifth and the embedded fourth order solution,
+		// relative to the tolerance of each component
+		auto const ratios = zipTuples([&](auto const& y_i, auto const& y5_i, auto const& atol_i, auto const& a, auto const& c, auto const& d, auto const& e, auto const& g, auto const& h) {
+			using Q = typename std::decay<decltype(atol_i)>::type;
+			auto const err = a * scaleTime(dt, 71./57600) + c * scaleTime(dt, -71./16695) + d * scaleTime(dt, 71./1920)
+				+ e * scaleTime(dt, -17253./339200) + g * scaleTime(dt, 22./525) + h * scaleTime(dt, -1./40);
+			Q const tol = atol_i + Q(T(std::max(std::abs(y_i.val), std::abs(y5_i.val)) * rtol));
+			return T(std::abs((err / tol).val));
+		}, y, y5, atol, k1, k3, k4, k5, k6, k7);
+		T const errNorm = _internal::tupleMax(ratios, std::make_index_sequence<std::tuple_size<t_state>::value>{});
+		if(!std::isfinite(errNorm))
+		{
+			throw std::domain_error("The error estimate of the step is not finite");
+		}
+
+		T const safety = T(0.9);
+		T factor = errNorm > T(0) ? safety * T(std::pow(errNorm, T(-0.2))) : T(5);
+		factor = std::min(T(5), std::max(T(0.2), factor));
+
+		if(errNorm <= T(1))
+		{
+			return AdaptiveStep<t_state, t_time>{y5, dt * factor, true};
+		}
+		return AdaptiveStep<t_state, t_time>{y, dt * factor, false};
+	}
+
+	/**
+	 * Integrates from t0 to t1 with adaptive Dormand-Prince steps, starting
+	 * with the step size dt. dt is updated to the last suggested step size,
+	 * so it can be passed on to the next call.
+	 *
+	 * Throws std::underflow_error if the step size the tolerances call for
+	 * is too small to advance t, i.e. t + dt == t in the storage type of
+	 * t_time, and std::domain_error as rk45Step does.
+	 */
+	template<typename F, typename t_state, typename t_time>
+	t_state rk45Integrate(F&& f, t_time t0, t_time t1, t_state y, t_time& dt, t_state const& atol, typename t_time::BaseType rtol)
+	{
+		t_time t = t0;
+		while(t < t1)
+		{
+			t_time const h = t + dt > t1 ? t1 - t : dt;
+			if(!(t + h > t))
+			{
+				throw std::underflow_error("The step size is below the resolution of the time");
+			}
+			auto const step = rk45Step(f, t, y, h, atol, rtol);
+			if(step.accepted)
+			{
+				t += h;
+				y = step.state;
+			}
+			dt = step.dt;
+		}
+		return y;
+	}
+
+	/**
+	 * One step of the semi-implicit (symplectic) Euler method: the velocity
+	 * is updated first, and the position is then advanced with the new
+	 * velocity.
+	 *
+	 * @param accel called as accel(t, x, v), returning Derivative<t_vel, t_time>
+	 * @param x position tuple, updated in place
+	 * @param v velocity tuple, updated in place. Must be Derivative<t_pos, t_time>.
+	 */
+	template<typename F, typename t_pos, typename t_vel, typename t_time>
+	void semiImplicitEulerStep(F&& accel, t_time t, t_pos& x, t_vel& v, t_time dt)
+	{
+		static_assert(std::is_same<t_vel, Derivative<t_pos, t_time>>::value, "The velocity must be position / time");
+		static_assert(std::is_same<typename std::decay<decltype(std::declval<F&>()(std::declval<t_time>(), std::declval<t_pos const&>(), std::declval<t_vel const&>()))>::type, Derivative<t_vel, t_time>>::value,
+			"The acceleration function must return a tuple of velocity / time");
+
+		auto const a = accel(t, static_cast<t_pos const&>(x), static_cast<t_vel const&>(v));
+		v = t_vel(_internal::zipTuples([dt](auto const& v_i, auto const& a_i) { return v_i + a_i * dt; }, v, a));
+		x = t_pos(_internal::zipTuples([dt](auto const& x_i, auto const& v_i) { return x_i + v_i * dt; }, x, v));
+	}
+
+	/**
+	 * Many independent states of the same type, stored as one contiguous
+	 * array per state component (structure of arrays).
+	 *
+	 * The batched steppers walk all lanes in a single loop, so as long as
+	 * the derivative function can be inlined the compiler is free to
+	 * vectorise across systems.
+	 */
+	template<typename t_state>
+	class StateBatch;
+
+	template<typename... t_components>
+	class StateBatch<std::tuple<t_components...>>
+	{
+	public:
+		using State = std::tuple<t_components...>;
+
+		explicit StateBatch(std::size_t size)
+			: m_size(size)
+			, m_lanes(std::vector<t_components>(size, t_components(typename t_components::BaseType(0)))...)
+		{}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		/**
+		 * Contiguous array holding component i of every state
+		 */
+		template<std::size_t i>
+		auto lane()
+		{
+			return std::get<i>(m_lanes).data();
+		}
+
+		template<std::size_t i>
+		auto lane() const
+		{
+			return std::get<i>(m_lanes).data();
+		}
+
+		State get(std::size_t lane) const
+		{
+			return get(lane, std::index_sequence_for<t_components...>{});
+		}
+
+		void set(std::size_t lane, State const& s)
+		{
+			set(lane, s, std::index_sequence_for<t_components...>{});
+		}
+
+	private:
+		template<std::size_t... is>
+		State get(std::size_t lane, std::index_sequence<is...>) const
+		{
+			return State(std::get<is>(m_lanes)[lane]...);
+		}
+
+		template<std::size_t... is>
+		void set(std::size_t lane, State const& s, std::index_sequence<is...>)
+		{
+			int expand[] = {(std::get<is>(m_lanes)[lane] = std::get<is>(s), 0)...};
+			(void)expand;
+		}
+
+		std::size_t m_size;
+		std::tuple<std::vector<t_components>...> m_lanes;
+	};
+
+	/**
+	 * Advances every state in the batch by one fourth order Runge-Kutta step
+	 */
+	template<typename F, typename t_state, typename t_time>
+	void rk4Step(F&& f, t_time t, StateBatch<t_state>& batch, t_time dt)
+	{
+		std::size_t const n = batch.size();
+		for(std::size_t i = 0; i < n; i++)
+		{
+			batch.set(i, rk4Step(f, t, batch.get(i), dt));
+		}
+	}
+
+	/**
+	 * Advances every pair of position and velocity states in the batches by
+	 * one semi-implicit Euler step. Throws std::invalid_argument unless
+	 * both batches hold the same number of states.
+	 */
+	template<typename F, typename t_pos, typename t_vel, typename t_time>
+	void semiImplicitEulerStep(F&& accel, t_time t, StateBatch<t_pos>& x, StateBatch<t_vel>& v, t_time dt)
+	{
+		if(x.size() != v.size())
+		{
+			throw std::invalid_argument("The position and velocity batches must have the same size");
+		}
+		std::size_t const n = x.size();
+		for(std::size_t i = 0; i < n; i++)
+		{
+			t_pos xi = x.get(i);
+			t_vel vi = v.get(i);
+			semiImplicitEulerStep(accel, t, xi, vi, dt);
+			x.set(i, xi);
+			v.set(i, vi);
+		}
+	}
+}
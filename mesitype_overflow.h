@@ -0,0 +1,497 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	namespace _internal {
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef __int128 Int128;
+		__extension__ typedef unsigned __int128 UInt128;
+#endif
+
+		/**
+		 * An integer type that holds the product of two values of type I
+		 */
+		template<typename I, bool t_signed = std::is_signed<I>::value, std::size_t t_size = sizeof(I)>
+		struct WideInteger
+		{
+			using Type = void;
+		};
+
+		template<typename I, std::size_t t_size>
+		struct WideInteger<I, true, t_size>
+		{
+			using Type = std::conditional_t<(t_size <= 4), std::int64_t, void>;
+		};
+
+		template<typename I, std::size_t t_size>
+		struct WideInteger<I, false, t_size>
+		{
+			using Type = std::conditional_t<(t_size <= 4), std::uint64_t, void>;
+		};
+
+#if defined(__SIZEOF_INT128__)
+		template<typename I>
+		struct WideInteger<I, true, 8>
+		{
+			using Type = Int128;
+		};
+
+		template<typename I>
+		struct WideInteger<I, false, 8>
+		{
+			using Type = UInt128;
+		};
+#endif
+
+		template<typename W>
+		struct WideTag {};
+
+		/**
+		 * The result of an integer operation, wrapped around as the
+		 * hardware does, whether it overflowed, and the value it saturates
+		 * to if it did
+		 */
+		template<typename I>
+		struct IntegerResult
+		{
+			I wrapped;
+			bool overflow;
+			I saturated;
+
+			constexpr I saturate() const
+			{
+				return overflow ? saturated : wrapped;
+			}
+		};
+
+		/**
+		 * Integer arithmetic that reports overflow without branches. The
+		 * operations are done on the unsigned type, which wraps instead of
+		 * being undefined, and overflow is read from the signs, so loops
+		 * of them vectorise.
+		 */
+		template<typename I, bool t_signed = std::is_signed<I>::value>
+		struct IntegerArithmetic
+		{
+			static_assert(std::is_integral<I>::value, "Overflow checks need integral storage");
+			using U = std::make_unsigned_t<I>;
+			using Limits = std::numeric_limits<I>;
+
+			/**
+			 * The maximum if a is not negative, the minimum otherwise
+			 */
+			static constexpr I limitFor(I a)
+			{
+				return I(U(Limits::max()) + (U(a) >> (Limits::digits)));
+			}
+
+			static constexpr IntegerResult<I> add(I a, I b)
+			{
+				I const r = I(U(U(a) + U(b)));
+				return { r, ((a ^ r) & (b ^ r)) < 0, limitFor(a) };
+			}
+
+			static constexpr IntegerResult<I> subtract(I a, I b)
+			{
+				I const r = I(U(U(a) - U(b)));
+				return { r, ((a ^ b) & (a ^ r)) < 0, limitFor(a) };
+			}
+
+			static constexpr IntegerResult<I> multiply(I a, I b)
+			{
+				return multiply(a, b, WideTag<typename WideInteger<I>::Type>());
+			}
+
+			template<typename W>
+			static constexpr IntegerResult<I> multiply(I a, I b, WideTag<W>)
+			{
+				W const w = W(a) * W(b);
+				return { I(U(w)), w > W(Limits::max()) || w < W(Limits::min()), limitFor(I(a ^ b)) };
+			}
+
+			static constexpr IntegerResult<I> multiply(I a, I b, WideTag<void>)
+			{
+				// Without a wider type, check by division
+				I const r = I(U(U(a) * U(b)));
+				bool const overflow = a != 0 && ((a == -1 && b == Limits::min()) || (b == -1 && a == Limits::min()) || r / a != b);
+				return { r, overflow, limitFor(I(a ^ b)) };
+			}
+
+			static constexpr IntegerResult<I> divide(I a, I b)
+			{
+				bool const overflow = a == Limits::min() && b == -1;
+				return { overflow ? a : I(a / b), overflow, Limits::max() };
+			}
+
+			static constexpr IntegerResult<I> negate(I a)
+			{
+				return { I(U(U(0) - U(a))), a == Limits::min(), Limits::max() };
+			}
+
+			/**
+			 * The value of the integer v as an I
+			 */
+			template<typename J>
+			static constexpr IntegerResult<I> convert(J v)
+			{
+				return { I(v), !fits(v), v < J(0) ? Limits::min() : Limits::max() };
+			}
+
+			template<typename J>
+			static constexpr bool fits(J v)
+			{
+				return std::is_signed<J>::value
+					? (v >= J(0) ? std::uintmax_t(v) <= std::uintmax_t(Limits::max()) : std::intmax_t(v) >= std::intmax_t(Limits::min()))
+					: std::uintmax_t(v) <= std::uintmax_t(Limits::max());
+			}
+		};
+
+		template<typename I>
+		struct IntegerArithmetic<I, false>
+		{
+			static_assert(std::is_integral<I>::value, "Overflow checks need integral storage");
+			using Limits = std::numeric_limits<I>;
+
+			static constexpr IntegerResult<I> add(I a, I b)
+			{
+				I const r = I(a + b);
+				return { r, r < a, Limits::max() };
+			}
+
+			static constexpr IntegerResult<I> subtract(I a, I b)
+			{
+				return { I(a - b), a < b, I(0) };
+			}
+
+			static constexpr IntegerResult<I> multiply(I a, I b)
+			{
+				return multiply(a, b, WideTag<typename WideInteger<I>::Type>());
+			}
+
+			template<typename W>
+			static constexpr IntegerResult<I> multiply(I a, I b, WideTag<W>)
+			{
+				W const w = W(a) * W(b);
+				return { I(w), w > W(Limits::max()), Limits::max() };
+			}
+
+			static constexpr IntegerResult<I> multiply(I a, I b, WideTag<void>)
+			{
+				I const r = I(a * b);
+				return { r, a != 0 && r / a != b, Limits::max() };
+			}
+
+			static constexpr IntegerResult<I> divide(I a, I b)
+			{
+				return { I(a / b), false, I(0) };
+			}
+
+			static constexpr IntegerResult<I> negate(I a)
+			{
+				return { I(I(0) - a), a != 0, I(0) };
+			}
+
+			template<typename J>
+			static constexpr IntegerResult<I> convert(J v)
+			{
+				return { I(v), !fits(v), v < J(0) ? I(0) : Limits::max() };
+			}
+
+			template<typename J>
+			static constexpr bool fits(J v)
+			{
+				return v >= J(0) && std::uintmax_t(v) <= std::uintmax_t(Limits::max());
+			}
+		};
+	}
+
+	/**
+	 * @brief Integer storage whose arithmetic saturates instead of wrapping
+	 *
+	 * A sum, difference or product that does not fit into I becomes its
+	 * largest or smallest value, like the adds/subs instructions of SIMD
+	 * instruction sets, and so does the conversion of an integer that does
+	 * not fit. This is computed without branches, so loops over arrays of
+	 * them vectorise. Division by zero is undefined, as it is for I.
+	 *
+	 * It can be used as the storage type of any Mesi type, e.g.
+	 *
+	 *     using Millivolts = Milli<Volts>::WithBaseType<Saturating<std::int32_t>>;
+	 *
+	 * and conversions between scales saturate as well.
+	 */
+	template<typename I>
+	class Saturating
+	{
+		using Arithmetic = _internal::IntegerArithmetic<I>;
+	public:
+		using Value = I;
+
+		constexpr Saturating()
+			:m_value(0)
+		{}
+
+		template<typename J, typename = std::enable_if_t<std::is_integral<J>::value>>
+		constexpr Saturating(J v)
+			:m_value(Arithmetic::convert(v).saturate())
+		{}
+
+		constexpr I value() const
+		{
+			return m_value;
+		}
+
+		constexpr explicit operator I() const
+		{
+			return m_value;
+		}
+
+		friend constexpr Saturating operator+(Saturating a, Saturating b)
+		{
+			return fromRaw(Arithmetic::add(a.m_value, b.m_value).saturate());
+		}
+
+		friend constexpr Saturating operator-(Saturating a, Saturating b)
+		{
+			return fromRaw(Arithmetic::subtract(a.m_value, b.m_value).saturate());
+		}
+
+		friend constexpr Saturating operator*(Saturating a, Saturating b)
+		{
+			return fromRaw(Arithmetic::multiply(a.m_value, b.m_value).saturate());
+		}
+
+		friend constexpr Saturating operator/(Saturating a, Saturating b)
+		{
+			return fromRaw(Arithmetic::divide(a.m_value, b.m_value).saturate());
+		}
+
+		friend constexpr Saturating operator-(Saturating a)
+		{
+			return fromRaw(Arithmetic::negate(a.m_value).saturate());
+		}
+
+		friend constexpr Saturating operator+(Saturating a)
+		{
+			return a;
+		}
+
+		constexpr Saturating& operator+=(Saturating b) { return *this = *this + b; }
+		constexpr Saturating& operator-=(Saturating b) { return *this = *this - b; }
+		constexpr Saturating& operator*=(Saturating b) { return *this = *this * b; }
+		constexpr Saturating& operator/=(Saturating b) { return *this = *this / b; }
+
+		friend constexpr bool operator==(Saturating a, Saturating b) { return a.m_value == b.m_value; }
+		friend constexpr bool operator!=(Saturating a, Saturating b) { return a.m_value != b.m_value; }
+		friend constexpr bool operator<(Saturating a, Saturating b) { return a.m_value < b.m_value; }
+		friend constexpr bool operator<=(Saturating a, Saturating b) { return a.m_value <= b.m_value; }
+		friend constexpr bool operator>(Saturating a, Saturating b) { return a.m_value > b.m_value; }
+		friend constexpr bool operator>=(Saturating a, Saturating b) { return a.m_value >= b.m_value; }
+
+	private:
+		static constexpr Saturating fromRaw(I v)
+		{
+			Saturating ret;
+			ret.m_value = v;
+			return ret;
+		}
+
+		I m_value;
+	};
+
+	/**
+	 * @brief Integer storage that records overflow in a sticky flag
+	 *
+	 * Arithmetic wraps around as it does for I, but a result that did not
+	 * fit, or that was computed from a value that had overflowed before,
+	 * has its flag set, so a whole computation can be checked once at the
+	 * end rather than after every step. Like a NaN, the flag is carried by
+	 * the value, so this works in vectorised loops and across threads. The
+	 * conversion of an integer that does not fit into I is flagged too.
+	 * Division by zero is undefined, as it is for I.
+	 *
+	 *     auto const e = (m * v * v).val;
+	 *     if(e.overflowed()) ...
+	 */
+	template<typename I>
+	class Checked
+	{
+		using Arithmetic = _internal::IntegerArithmetic<I>;
+	public:
+		using Value = I;
+
+		constexpr Checked()
+			:m_value(0), m_overflow(0)
+		{}
+
+		template<typename J, typename = std::enable_if_t<std::is_integral<J>::value>>
+		constexpr Checked(J v)
+			:m_value(Arithmetic::convert(v).wrapped), m_overflow(I(Arithmetic::convert(v).overflow))
+		{}
+
+		/**
+		 * The value, which has wrapped around if overflowed() is set
+		 */
+		constexpr I value() const
+		{
+			return m_value;
+		}
+
+		/**
+		 * Whether this or any value it was computed from overflowed
+		 */
+		constexpr bool overflowed() const
+		{
+			return m_overflow != 0;
+		}
+
+		constexpr explicit operator I() const
+		{
+			return m_value;
+		}
+
+		friend constexpr Checked operator+(Checked a, Checked b)
+		{
+			return from(Arithmetic::add(a.m_value, b.m_value), a, b);
+		}
+
+		friend constexpr Checked operator-(Checked a, Checked b)
+		{
+			return from(Arithmetic::subtract(a.m_value, b.m_value), a, b);
+		}
+
+		friend constexpr Checked operator*(Checked a, Checked b)
+		{
+			return from(Arithmetic::multiply(a.m_value, b.m_value), a, b);
+		}
+
+		friend constexpr Checked operator/(Checked a, Checked b)
+		{
+			return from(Arithmetic::divide(a.m_value, b.m_value), a, b);
+		}
+
+		friend constexpr Checked operator-(Checked a)
+		{
+			return from(Arithmetic::negate(a.m_value), a, a);
+		}
+
+		friend constexpr Checked operator+(Checked a)
+		{
+			return a;
+		}
+
+		constexpr Checked& operator+=(Checked b) { return *this = *this + b; }
+		constexpr Checked& operator-=(Checked b) { return *this = *this - b; }
+		constexpr Checked& operator*=(Checked b) { return *this = *this * b; }
+		constexpr Checked& operator/=(Checked b) { return *this = *this / b; }
+
+		/*
+		 * Comparisons only look at the values
+		 */
+		friend constexpr bool operator==(Checked a, Checked b) { return a.m_value == b.m_value; }
+		friend constexpr bool operator!=(Checked a, Checked b) { return a.m_value != b.m_value; }
+		friend constexpr bool operator<(Checked a, Checked b) { return a.m_value < b.m_value; }
+		friend constexpr bool operator<=(Checked a, Checked b) { return a.m_value <= b.m_value; }
+		friend constexpr bool operator>(Checked a, Checked b) { return a.m_value > b.m_value; }
+		friend constexpr bool operator>=(Checked a, Checked b) { return a.m_value >= b.m_value; }
+
+	private:
+		static constexpr Checked from(_internal::IntegerResult<I> r, Checked a, Checked b)
+		{
+			Checked ret;
+			ret.m_value = r.wrapped;
+			ret.m_overflow = I(I(r.overflow) | a.m_overflow | b.m_overflow);
+			return ret;
+		}
+
+		I m_value;
+		/** 0 or 1, as an I so that arrays of these vectorise */
+		I m_overflow;
+	};
+
+	/**
+	 * Whether the value of q overflowed, for quantities with Checked
+	 * storage
+	 */
+	template<typename I, typename t_m, typename t_s, typename t_kg, typename t_A, typename t_K, typename t_mol, typename t_cd, typename t_scale>
+	constexpr bool overflowed(RationalTypeReduced<Checked<I>, t_m, t_s, t_kg, t_A, t_K, t_mol, t_cd, t_scale> const& q)
+	{
+		return q.val.overflowed();
+	}
+
+	namespace _internal {
+		/**
+		 * Result types of operations on integer adaptors, which stay the
+		 * adaptor. They combine with the same adaptor of the same integer
+		 * type, or with plain integers.
+		 */
+		template<typename A, typename B>
+		struct IntegerAdaptorOperations
+		{
+			static_assert(std::is_same<A, B>::value, "Integer adaptors only combine with the same adaptor of the same integer type, or with plain integers");
+			using MultiplyResult = A;
+			using DivideResult = A;
+			using AddResult = A;
+			using SubtractResult = A;
+		};
+	}
+
+	template<typename I>
+	struct TypeOperations<Saturating<I>, Saturating<I>> : _internal::IntegerAdaptorOperations<Saturating<I>, Saturating<I>> {};
+
+	template<typename I, typename S>
+	struct TypeOperations<Saturating<I>, S> : _internal::IntegerAdaptorOperations<Saturating<I>, std::conditional_t<std::is_integral<S>::value, Saturating<I>, S>> {};
+
+	template<typename S, typename I>
+	struct TypeOperations<S, Saturating<I>> : _internal::IntegerAdaptorOperations<Saturating<I>, std::conditional_t<std::is_integral<S>::value, Saturating<I>, S>> {};
+
+	template<typename I, typename J>
+	struct TypeOperations<Saturating<I>, Saturating<J>> : _internal::IntegerAdaptorOperations<Saturating<I>, Saturating<J>> {};
+
+	template<typename I, typename J>
+	struct TypeOperations<Saturating<I>, Checked<J>> : _internal::IntegerAdaptorOperations<Saturating<I>, Checked<J>> {};
+
+	template<typename I, typename J>
+	struct TypeOperations<Checked<I>, Saturating<J>> : _internal::IntegerAdaptorOperations<Checked<I>, Saturating<J>> {};
+
+	template<typename I, typename J>
+	struct TypeOperations<Checked<I>, Checked<J>> : _internal::IntegerAdaptorOperations<Checked<I>, Checked<J>> {};
+
+	template<typename I>
+	struct TypeOperations<Checked<I>, Checked<I>> : _internal::IntegerAdaptorOperations<Checked<I>, Checked<I>> {};
+
+	template<typename I, typename S>
+	struct TypeOperations<Checked<I>, S> : _internal::IntegerAdaptorOperations<Checked<I>, std::conditional_t<std::is_integral<S>::value, Checked<I>, S>> {};
+
+	template<typename S, typename I>
+	struct TypeOperations<S, Checked<I>> : _internal::IntegerAdaptorOperations<Checked<I>, std::conditional_t<std::is_integral<S>::value, Checked<I>, S>> {};
+}
+
+namespace std {
+	/*
+	 * The adaptors have the limits of their integer type, which is what
+	 * scale factors are computed with
+	 */
+	template<typename I>
+	class numeric_limits<Mesi::Saturating<I>> : public numeric_limits<I>
+	{
+	public:
+		static constexpr Mesi::Saturating<I> min() noexcept { return numeric_limits<I>::min(); }
+		static constexpr Mesi::Saturating<I> max() noexcept { return numeric_limits<I>::max(); }
+		static constexpr Mesi::Saturating<I> lowest() noexcept { return numeric_limits<I>::lowest(); }
+	};
+
+	template<typename I>
+	class numeric_limits<Mesi::Checked<I>> : public numeric_limits<I>
+	{
+	public:
+		static constexpr Mesi::Checked<I> min() noexcept { return numeric_limits<I>::min(); }
+		static constexpr Mesi::Checked<I> max() noexcept { return numeric_limits<I>::max(); }
+		static constexpr Mesi::Checked<I> lowest() noexcept { return numeric_limits<I>::lowest(); }
+	};
+}
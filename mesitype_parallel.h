@@ -0,0 +1,480 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+/*
+ * Bytes of the largest array a parallel loop accesses that go into one
+ * chunk of work. The chunks of all arrays should fit in the L1 cache
+ * together.
+ */
+#ifndef MESI_PARALLEL_CHUNK_BYTES
+#	define MESI_PARALLEL_CHUNK_BYTES 16384
+#endif
+
+namespace Mesi {
+	/**
+	 * @brief Persistent threads that share out numbered pieces of work by
+	 * work stealing
+	 *
+	 * run() gives each thread an equal, contiguous share of the pieces.
+	 * A thread takes pieces from the front of its own share, and once that
+	 * is empty, steals the back half of the largest share left among the
+	 * others, so threads that finish early help those that are slowed
+	 * down, while neighbouring pieces mostly stay on one thread.
+	 */
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+			: m_shares(std::max<std::size_t>(threads, 1))
+		{
+			for(std::size_t i = 1; i < m_shares.size(); i++)
+			{
+				m_workers.emplace_back([this, i] { work(i); });
+			}
+		}
+
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool& operator=(ThreadPool const&) = delete;
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for(auto& t : m_workers)
+			{
+				t.join();
+			}
+		}
+
+		/**
+		 * The pool used by the parallel algorithms when none is given,
+		 * with a thread per hardware thread, created on first use
+		 */
+		static ThreadPool& shared()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+		std::size_t threads() const
+		{
+			return m_shares.size();
+		}
+
+		/**
+		 * Calls f(i) for every i in [0, count), spread over all threads,
+		 * and returns once all calls have finished. If a call throws, the
+		 * pieces not yet started are skipped and the first exception is
+		 * rethrown here. Calls from several threads take turns. A call
+		 * made from inside f, or from any thread that is running work of
+		 * this pool, runs all of its pieces inline on the calling thread,
+		 * since the pool's threads are busy with the outer call.
+		 */
+		template<typename F>
+		void run(std::size_t count, F&& f)
+		{
+			if(count == 0)
+			{
+				return;
+			}
+			if(runningHere())
+			{
+				for(std::size_t i = 0; i < count; i++)
+				{
+					f(i);
+				}
+				return;
+			}
+			std::lock_guard<std::mutex> turn(m_run);
+			Running const running(this);
+			if(count == 1 || m_workers.empty())
+			{
+				for(std::size_t i = 0; i < count; i++)
+				{
+					f(i);
+				}
+				return;
+			}
+			std::size_t const n = m_shares.size();
+			for(std::size_t t = 0; t < n; t++)
+			{
+				std::lock_guard<std::mutex> lock(m_shares[t].mutex);
+				m_shares[t].begin = count * t / n;
+				m_shares[t].end = count * (t + 1) / n;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_call = [](void* ctx, std::size_t i) { (*static_cast<typename std::remove_reference<F>::type*>(ctx))(i); };
+				m_context = const_cast<void*>(static_cast<void const*>(&f));
+				m_caller = &running;
+				m_exception = nullptr;
+				m_failed = false;
+				m_active = m_workers.size();
+				m_generation++;
+			}
+			m_wake.notify_all();
+			drain(0);
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this] { return m_active == 0; });
+			if(m_exception)
+			{
+				std::rethrow_exception(m_exception);
+			}
+		}
+
+	private:
+		/**
+		 * Marks the current thread as running work of a pool while it
+		 * lives. The marks of a thread form a stack, innermost first; a
+		 * worker's mark continues the stack of the thread that called
+		 * run(), so calls that come back through other pools are seen.
+		 */
+		struct Running
+		{
+			explicit Running(ThreadPool const* p, Running const* o = innermost())
+				: pool(p)
+				, outer(o)
+			{
+				innermost() = this;
+			}
+
+			~Running()
+			{
+				innermost() = outer;
+			}
+
+			Running(Running const&) = delete;
+			Running& operator=(Running const&) = delete;
+
+			ThreadPool const* pool;
+			Running const* outer;
+		};
+
+		static Running const*& innermost()
+		{
+			static thread_local Running const* top = nullptr;
+			return top;
+		}
+
+		bool runningHere() const
+		{
+			for(Running const* r = innermost(); r; r = r->outer)
+			{
+				if(r->pool == this)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * The pieces [begin, end) a thread has yet to take, padded so that
+		 * the shares of two threads do not share a cache line
+		 */
+		struct Share
+		{
+			std::mutex mutex;
+			std::size_t begin = 0;
+			std::size_t end = 0;
+			char padding[64];
+		};
+
+		bool take(std::size_t t, std::size_t& i)
+		{
+			std::lock_guard<std::mutex> lock(m_shares[t].mutex);
+			if(m_shares[t].begin == m_shares[t].end)
+			{
+				return false;
+			}
+			i = m_shares[t].begin++;
+			return true;
+		}
+
+		/**
+		 * Moves the back half of the largest other share to thread t's
+		 */
+		bool steal(std::size_t t)
+		{
+			std::size_t const n = m_shares.size();
+			std::size_t victim = t;
+			std::size_t most = 0;
+			for(std::size_t k = 1; k < n; k++)
+			{
+				std::size_t const v = (t + k) % n;
+				std::lock_guard<std::mutex> lock(m_shares[v].mutex);
+				if(m_shares[v].end - m_shares[v].begin > most)
+				{
+					most = m_shares[v].end - m_shares[v].begin;
+					victim = v;
+				}
+			}
+			if(most == 0)
+			{
+				return false;
+			}
+			std::size_t begin;
+			std::size_t end;
+			{
+				std::lock_guard<std::mutex> lock(m_shares[victim].mutex);
+				Share& s = m_shares[victim];
+				if(s.begin == s.end)
+				{
+					// Taken in the meantime; look again
+					return true;
+				}
+				end = s.end;
+				begin = s.begin + (s.end - s.begin) / 2;
+				s.end = begin;
+			}
+			std::lock_guard<std::mutex> lock(m_shares[t].mutex);
+			m_shares[t].begin = begin;
+			m_shares[t].end = end;
+			return true;
+		}
+
+		void drain(std::size_t t)
+		{
+			for(;;)
+			{
+				std::size_t i;
+				while(!m_failed.load(std::memory_order_relaxed) && take(t, i))
+				{
+					try
+					{
+						m_call(m_context, i);
+					}
+					catch(...)
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						if(!m_exception)
+						{
+							m_exception = std::current_exception();
+						}
+						m_failed = true;
+					}
+				}
+				if(m_failed.load(std::memory_order_relaxed) || !steal(t))
+				{
+					return;
+				}
+			}
+		}
+
+		void work(std::size_t t)
+		{
+			std::size_t seen = 0;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for(;;)
+			{
+				m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+				if(m_stop)
+				{
+					return;
+				}
+				seen = m_generation;
+				Running const* const caller = m_caller;
+				lock.unlock();
+				{
+					Running const running(this, caller);
+					drain(t);
+				}
+				lock.lock();
+				if(--m_active == 0)
+				{
+					m_done.notify_all();
+				}
+			}
+		}
+
+		std::vector<std::thread> m_workers;
+		std::vector<Share> m_shares;
+		std::mutex m_run;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		void (*m_call)(void*, std::size_t) = nullptr;
+		void* m_context = nullptr;
+		Running const* m_caller = nullptr;
+		std::exception_ptr m_exception;
+		std::atomic<bool> m_failed{false};
+		std::size_t m_active = 0;
+		std::size_t m_generation = 0;
+		bool m_stop = false;
+	};
+
+	namespace _internal {
+		/**
+		 * Splits n elements of an array at address into chunks of about
+		 * MESI_PARALLEL_CHUNK_BYTES / t_size elements. All chunks but the
+		 * first start on a boundary of a cache line and of
+		 * MESI_SIMD_ALIGNMENT bytes, if the elements fit those evenly, so
+		 * vector loops over a chunk run aligned and no two threads write
+		 * to the same cache line.
+		 */
+		template<std::size_t t_size>
+		class Chunks
+		{
+		public:
+			Chunks(void const* address, std::size_t n)
+				: m_n(n)
+			{
+				constexpr std::size_t boundary = MESI_SIMD_ALIGNMENT > 64 ? MESI_SIMD_ALIGNMENT : 64;
+				constexpr std::size_t perBoundary = boundary % t_size == 0 ? boundary / t_size : 1;
+				constexpr std::size_t wanted = MESI_PARALLEL_CHUNK_BYTES / t_size;
+				m_chunk = wanted < perBoundary ? perBoundary : wanted - wanted % perBoundary;
+				std::uintptr_t const a = reinterpret_cast<std::uintptr_t>(address);
+				std::size_t const head = perBoundary > 1 && a % t_size == 0 ? (boundary - a % boundary) % boundary / t_size : 0;
+				m_first = head == 0 ? m_chunk : head;
+			}
+
+			std::size_t count() const
+			{
+				return m_n <= m_first ? 1 : 1 + (m_n - m_first + m_chunk - 1) / m_chunk;
+			}
+
+			std::size_t begin(std::size_t i) const
+			{
+				return i == 0 ? 0 : m_first + (i - 1) * m_chunk;
+			}
+
+			std::size_t end(std::size_t i) const
+			{
+				return std::min(m_n, m_first + i * m_chunk);
+			}
+
+		private:
+			std::size_t m_n;
+			std::size_t m_chunk;
+			std::size_t m_first;
+		};
+
+		template<typename... T>
+		struct LargestSize;
+
+		template<typename T>
+		struct LargestSize<T> : std::integral_constant<std::size_t, sizeof(T)> {};
+
+		template<typename T, typename... t_rest>
+		struct LargestSize<T, t_rest...> : std::integral_constant<std::size_t,
+			(sizeof(T) > LargestSize<t_rest...>::value ? sizeof(T) : LargestSize<t_rest...>::value)> {};
+
+		template<typename F, typename... A>
+		using TransformResult = std::decay_t<decltype(std::declval<F&>()(std::declval<A&>()...))>;
+
+		inline void checkSizes(std::size_t a, std::size_t b)
+		{
+			if(a != b)
+			{
+				throw std::invalid_argument("The ranges of a parallel transform must have the same size");
+			}
+		}
+	}
+
+	/**
+	 * Calls f on every element of data, e.g.
+	 *
+	 *     parallel_for(Span<Kelvin>(t.data(), t.size()), [](Kelvin& k) { k += Kelvin(1); });
+	 *
+	 * spread over the threads of pool in cache-sized chunks. Each chunk is
+	 * a plain loop over its elements, which the compiler can vectorise.
+	 */
+	template<typename Q, typename F>
+	void parallel_for(Span<Q> data, F f, ThreadPool& pool = ThreadPool::shared())
+	{
+		Q* const p = data.data();
+		_internal::Chunks<sizeof(Q)> const chunks(p, data.size());
+		pool.run(chunks.count(), [&](std::size_t c) {
+			std::size_t const end = chunks.end(c);
+			for(std::size_t i = chunks.begin(c); i < end; i++)
+			{
+				f(p[i]);
+			}
+		});
+	}
+
+	/**
+	 * Writes f(in[i]) to out[i] for every element of in, in parallel.
+	 * f must return a type that converts to R implicitly, so results of
+	 * another unit or scale do not compile.
+	 */
+	template<typename A, typename R, typename F>
+	void parallel_transform(Span<A> in, R* out, F f, ThreadPool& pool = ThreadPool::shared())
+	{
+		static_assert(std::is_convertible<_internal::TransformResult<F, A>, R>::value, "The callable's result must convert to the output type");
+		A* const a = in.data();
+		_internal::Chunks<_internal::LargestSize<A, R>::value> const chunks(out, in.size());
+		pool.run(chunks.count(), [&](std::size_t c) {
+			std::size_t const end = chunks.end(c);
+			for(std::size_t i = chunks.begin(c); i < end; i++)
+			{
+				out[i] = f(a[i]);
+			}
+		});
+	}
+
+	/**
+	 * Writes f(in1[i], in2[i]) to out[i] for every element of the inputs,
+	 * which must have the same size, in parallel, e.g. Newtons from
+	 * Kilograms and accelerations
+	 */
+	template<typename A, typename B, typename R, typename F>
+	void parallel_transform(Span<A> in1, Span<B> in2, R* out, F f, ThreadPool& pool = ThreadPool::shared())
+	{
+		static_assert(std::is_convertible<_internal::TransformResult<F, A, B>, R>::value, "The callable's result must convert to the output type");
+		_internal::checkSizes(in1.size(), in2.size());
+		A* const a = in1.data();
+		B* const b = in2.data();
+		_internal::Chunks<_internal::LargestSize<A, B, R>::value> const chunks(out, in1.size());
+		pool.run(chunks.count(), [&](std::size_t c) {
+			std::size_t const end = chunks.end(c);
+			for(std::size_t i = chunks.begin(c); i < end; i++)
+			{
+				out[i] = f(a[i], b[i]);
+			}
+		});
+	}
+
+	/**
+	 * Returns f(in[i]) for every element of in, computed in parallel, in a
+	 * vector of the type f returns
+	 */
+	template<typename A, typename F>
+	std::vector<_internal::TransformResult<F, A>> parallel_transform(Span<A> in, F f, ThreadPool& pool = ThreadPool::shared())
+	{
+		std::vector<_internal::TransformResult<F, A>> ret(in.size());
+		parallel_transform(in, ret.data(), f, pool);
+		return ret;
+	}
+
+	/**
+	 * Returns f(in1[i], in2[i]) for every element of the inputs, computed
+	 * in parallel, in a vector of the type f returns
+	 */
+	template<typename A, typename B, typename F>
+	std::vector<_internal::TransformResult<F, A, B>> parallel_transform(Span<A> in1, Span<B> in2, F f, ThreadPool& pool = ThreadPool::shared())
+	{
+		std::vector<_internal::TransformResult<F, A, B>> ret(in1.size());
+		parallel_transform(in1, in2, ret.data(), f, pool);
+		return ret;
+	}
+}
@@ -0,0 +1,503 @@
+#pragma once
+
+/*
+ * Pipelines of coroutines that pass batches of quantities between stages,
+ * all run by a single thread. This needs C++20 coroutines and POSIX
+ * poll(); without them, the header defines nothing.
+ */
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>) && __has_include(<poll.h>)
+
+#include <algorithm>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+#define MESI_PIPELINE 1
+
+namespace Mesi {
+	namespace Pipeline {
+		class Loop;
+
+		/**
+		 * A coroutine run by a Loop. It starts when it is spawned and may
+		 * wait for file descriptors and channels, but not for other tasks.
+		 */
+		class Task
+		{
+		public:
+			struct promise_type
+			{
+				std::exception_ptr exception;
+
+				Task get_return_object()
+				{
+					return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+
+				std::suspend_always initial_suspend() noexcept
+				{
+					return {};
+				}
+
+				std::suspend_always final_suspend() noexcept
+				{
+					return {};
+				}
+
+				void return_void()
+				{}
+
+				void unhandled_exception()
+				{
+					exception = std::current_exception();
+				}
+			};
+
+			Task(Task&& other) noexcept
+				: m_handle(std::exchange(other.m_handle, nullptr))
+			{}
+
+			Task& operator=(Task&& other) noexcept
+			{
+				std::swap(m_handle, other.m_handle);
+				return *this;
+			}
+
+			~Task()
+			{
+				if(m_handle)
+				{
+					m_handle.destroy();
+				}
+			}
+
+		private:
+			friend class Loop;
+
+			explicit Task(std::coroutine_handle<promise_type> handle)
+				: m_handle(handle)
+			{}
+
+			std::coroutine_handle<promise_type> m_handle;
+		};
+
+		/**
+		 * Runs tasks on the calling thread, resuming each when what it
+		 * waits for is ready. Waits for file descriptors are multiplexed
+		 * with a single poll(), so one loop can serve thousands of sources.
+		 */
+		class Loop
+		{
+		public:
+			Loop() = default;
+			Loop(Loop const&) = delete;
+			Loop& operator=(Loop const&) = delete;
+
+			void spawn(Task task)
+			{
+				schedule(task.m_handle);
+				m_tasks.push_back(std::move(task));
+			}
+
+			/**
+			 * Runs until all tasks have finished. An exception that escapes
+			 * a task is rethrown here, and the remaining tasks are left
+			 * suspended until the loop is destroyed or run again. Tasks
+			 * that all wait for each other through channels are a
+			 * deadlock, which throws std::logic_error.
+			 */
+			void run()
+			{
+				while(!m_tasks.empty())
+				{
+					if(m_ready.empty())
+					{
+						if(m_polls.empty())
+						{
+							throw std::logic_error("Every pipeline task is waiting on a channel");
+						}
+						wait();
+					}
+					while(!m_ready.empty())
+					{
+						std::coroutine_handle<> const h = m_ready.front();
+						m_ready.pop_front();
+						h.resume();
+						if(h.done())
+						{
+							finish(h);
+						}
+					}
+				}
+			}
+
+			/**
+			 * Resumes h the next time the loop runs ready tasks
+			 */
+			void schedule(std::coroutine_handle<> h)
+			{
+				m_ready.push_back(h);
+			}
+
+			/**
+			 * Waits until fd can be read without blocking, or has reached
+			 * its end or an error
+			 */
+			auto readable(int fd)
+			{
+				struct Awaiter
+				{
+					Loop& loop;
+					int fd;
+
+					bool await_ready() const noexcept
+					{
+						return false;
+					}
+
+					void await_suspend(std::coroutine_handle<> h)
+					{
+						loop.m_polls.push_back(pollfd{ fd, POLLIN, 0 });
+						loop.m_pollers.push_back(h);
+					}
+
+					void await_resume() const noexcept
+					{}
+				};
+				return Awaiter{ *this, fd };
+			}
+
+		private:
+			void wait()
+			{
+				int ret;
+				do
+				{
+					ret = ::poll(m_polls.data(), nfds_t(m_polls.size()), -1);
+				}
+				while(ret < 0 && errno == EINTR);
+				if(ret < 0)
+				{
+					throw std::system_error(errno, std::generic_category(), "poll");
+				}
+				for(std::size_t i = 0; i < m_polls.size();)
+				{
+					if(m_polls[i].revents)
+					{
+						schedule(m_pollers[i]);
+						m_polls[i] = m_polls.back();
+						m_polls.pop_back();
+						m_pollers[i] = m_pollers.back();
+						m_pollers.pop_back();
+					}
+					else
+					{
+						i++;
+					}
+				}
+			}
+
+			void finish(std::coroutine_handle<> h)
+			{
+				auto const it = std::find_if(m_tasks.begin(), m_tasks.end(), [h](Task const& t) {
+					return t.m_handle.address() == h.address();
+				});
+				std::exception_ptr const exception = it->m_handle.promise().exception;
+				*it = std::move(m_tasks.back());
+				m_tasks.pop_back();
+				if(exception)
+				{
+					std::rethrow_exception(exception);
+				}
+			}
+
+			std::vector<Task> m_tasks;
+			std::deque<std::coroutine_handle<>> m_ready;
+			std::vector<pollfd> m_polls;
+			std::vector<std::coroutine_handle<>> m_pollers;
+		};
+
+		/**
+		 * A bounded queue of values of type Q between pipeline stages.
+		 * Writers that find it full wait until the reader has made room,
+		 * which holds back fast sources instead of buffering without
+		 * limit. Any number of writers may share a channel, and their
+		 * batches are queued in the order they were written; it has a
+		 * single reader.
+		 *
+		 * The channel ends once each writer has called close() and the
+		 * reader has taken all values.
+		 */
+		template<typename Q>
+		class Channel
+		{
+		public:
+			using Value = Q;
+
+			Channel(Loop& loop, std::size_t capacity, std::size_t writers = 1)
+				: m_loop(loop)
+				, m_buffer(std::max<std::size_t>(capacity, 1))
+				, m_writers(writers)
+			{}
+
+			Channel(Channel const&) = delete;
+			Channel& operator=(Channel const&) = delete;
+
+			std::size_t size() const
+			{
+				return m_size;
+			}
+
+			std::size_t capacity() const
+			{
+				return m_buffer.size();
+			}
+
+			/**
+			 * Writes all of batch, waiting while the channel is full. The
+			 * values are copied, so the batch may be reused once the write
+			 * has completed.
+			 */
+			auto write(Span<Q const> batch)
+			{
+				struct Awaiter
+				{
+					Channel& channel;
+					Span<Q const> batch;
+
+					bool await_ready()
+					{
+						if(!channel.m_pending.empty())
+						{
+							return false;
+						}
+						std::size_t const n = channel.push(batch.data(), batch.size());
+						batch = Span<Q const>(batch.data() + n, batch.size() - n);
+						return batch.empty();
+					}
+
+					void await_suspend(std::coroutine_handle<> h)
+					{
+						channel.m_pending.push_back(Pending{ batch.data(), batch.size(), h });
+					}
+
+					void await_resume() const noexcept
+					{}
+				};
+				return Awaiter{ *this, batch };
+			}
+
+			/**
+			 * Marks the end of one writer's values
+			 */
+			void close()
+			{
+				if(m_writers > 0 && --m_writers == 0)
+				{
+					wakeReader();
+				}
+			}
+
+			/**
+			 * Reads up to out.size() values into out, waiting while the
+			 * channel is empty, and returns the number read. This is zero
+			 * only once the channel has ended, so out must not be empty,
+			 * or std::invalid_argument is thrown.
+			 */
+			auto read(Span<Q> out)
+			{
+				if(out.empty())
+				{
+					throw std::invalid_argument("Reading from a channel needs room for at least one value");
+				}
+				struct Awaiter
+				{
+					Channel& channel;
+					Span<Q> out;
+
+					bool await_ready() const noexcept
+					{
+						return channel.m_size > 0 || channel.m_writers == 0;
+					}
+
+					void await_suspend(std::coroutine_handle<> h)
+					{
+						channel.m_reader = h;
+					}
+
+					std::size_t await_resume()
+					{
+						return channel.pop(out.data(), out.size());
+					}
+				};
+				return Awaiter{ *this, out };
+			}
+
+		private:
+			struct Pending
+			{
+				Q const* data;
+				std::size_t size;
+				std::coroutine_handle<> writer;
+			};
+
+			std::size_t push(Q const* data, std::size_t n)
+			{
+				std::size_t const count = std::min(n, m_buffer.size() - m_size);
+				for(std::size_t i = 0; i < count; i++)
+				{
+					m_buffer[(m_head + m_size + i) % m_buffer.size()] = data[i];
+				}
+				m_size += count;
+				if(count > 0)
+				{
+					wakeReader();
+				}
+				return count;
+			}
+
+			std::size_t pop(Q* out, std::size_t n)
+			{
+				std::size_t const count = std::min(n, m_size);
+				for(std::size_t i = 0; i < count; i++)
+				{
+					out[i] = m_buffer[(m_head + i) % m_buffer.size()];
+				}
+				m_head = (m_head + count) % m_buffer.size();
+				m_size -= count;
+
+				// Move waiting writers' values into the room just made
+				while(!m_pending.empty() && m_size < m_buffer.size())
+				{
+					Pending& p = m_pending.front();
+					std::size_t const pushed = push(p.data, p.size);
+					p.data += pushed;
+					p.size -= pushed;
+					if(p.size > 0)
+					{
+						break;
+					}
+					m_loop.schedule(p.writer);
+					m_pending.pop_front();
+				}
+				return count;
+			}
+
+			void wakeReader()
+			{
+				if(m_reader)
+				{
+					m_loop.schedule(std::exchange(m_reader, nullptr));
+				}
+			}
+
+			Loop& m_loop;
+			std::vector<Q> m_buffer;
+			std::size_t m_head = 0;
+			std::size_t m_size = 0;
+			std::size_t m_writers;
+			std::deque<Pending> m_pending;
+			std::coroutine_handle<> m_reader;
+		};
+
+		/**
+		 * A source stage: reads raw samples of type t_raw, e.g. ADC counts
+		 * as std::int16_t, from the file descriptor fd, converts each with
+		 * convert into a Q and writes them to out in batches of up to
+		 * batchSize. It closes out at the end of fd. It throws
+		 * std::system_error if reading fails, std::runtime_error if fd ends
+		 * within a sample, and std::invalid_argument if batchSize is 0. The
+		 * descriptor should be non-blocking, so that a source that becomes
+		 * readable with fewer bytes than it wants does not hold up the loop,
+		 * and is not closed here.
+		 */
+		template<typename t_raw, typename Q, typename F>
+		Task source(Loop& loop, int fd, Channel<Q>& out, F convert, std::size_t batchSize = 256)
+		{
+			static_assert(std::is_trivially_copyable<t_raw>::value, "Raw samples are read as bytes");
+			static_assert(std::is_convertible<std::invoke_result_t<F&, t_raw>, Q>::value, "The conversion must yield the channel's type");
+			if(batchSize == 0)
+			{
+				throw std::invalid_argument("A source needs a batch size of at least one");
+			}
+			std::vector<unsigned char> bytes(batchSize * sizeof(t_raw));
+			std::vector<Q> values(batchSize);
+			std::size_t filled = 0;
+			for(;;)
+			{
+				co_await loop.readable(fd);
+				ssize_t const got = ::read(fd, bytes.data() + filled, bytes.size() - filled);
+				if(got < 0)
+				{
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+					{
+						continue;
+					}
+					throw std::system_error(errno, std::generic_category(), "read");
+				}
+				if(got == 0)
+				{
+					if(filled > 0)
+					{
+						throw std::runtime_error("The source ended within a sample");
+					}
+					break;
+				}
+				filled += std::size_t(got);
+				std::size_t const n = filled / sizeof(t_raw);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					t_raw raw;
+					std::memcpy(&raw, bytes.data() + i * sizeof(t_raw), sizeof(t_raw));
+					values[i] = convert(raw);
+				}
+				// Keep a partial sample for the next read
+				std::memmove(bytes.data(), bytes.data() + n * sizeof(t_raw), filled - n * sizeof(t_raw));
+				filled -= n * sizeof(t_raw);
+				co_await out.write(Span<Q const>(values.data(), n));
+			}
+			out.close();
+		}
+
+		/**
+		 * A stage that maps each value read from in to a value of t_out
+		 * with f, e.g. Volts to Watts, and writes the results to out in
+		 * batches of up to batchSize, closing out at the end of in. The
+		 * channels fix the stage's input and output types, and f must
+		 * yield values that convert to t_out implicitly, so stages with
+		 * mismatched units or scales do not compile.
+		 */
+		template<typename t_in, typename t_out, typename F>
+		Task transform(Channel<t_in>& in, Channel<t_out>& out, F f, std::size_t batchSize = 256)
+		{
+			static_assert(std::is_convertible<std::invoke_result_t<F&, t_in const&>, t_out>::value, "The stage must map the input channel's type to the output channel's type");
+			std::vector<t_in> input(batchSize);
+			std::vector<t_out> output(batchSize);
+			while(std::size_t const n = co_await in.read(Span<t_in>(input.data(), input.size())))
+			{
+				for(std::size_t i = 0; i < n; i++)
+				{
+					output[i] = f(input[i]);
+				}
+				co_await out.write(Span<t_out const>(output.data(), n));
+			}
+			out.close();
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "mesitype.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	namespace _internal {
+		/**
+		 * Type of the coefficient of x^k in a polynomial from X to Y, i.e.
+		 * Y / X^k
+		 */
+		template<typename X, typename Y, std::size_t k>
+		using PolynomialCoefficient = decltype(Y{} / typename X::template Pow<std::ratio<k, 1>>{});
+
+		/**
+		 * Whether std::fma is at least as fast as a multiplication and an
+		 * addition, as reported by <cmath>. Otherwise std::fma may be a
+		 * library call and is not used.
+		 */
+		template<typename T>
+		struct FastFma : std::false_type {};
+#ifdef FP_FAST_FMAF
+		template<>
+		struct FastFma<float> : std::true_type {};
+#endif
+#ifdef FP_FAST_FMA
+		template<>
+		struct FastFma<double> : std::true_type {};
+#endif
+#ifdef FP_FAST_FMAL
+		template<>
+		struct FastFma<long double> : std::true_type {};
+#endif
+
+		template<typename T>
+		T multiplyAdd(T a, T b, T c, std::true_type)
+		{
+			return std::fma(a, b, c);
+		}
+
+		template<typename T>
+		T multiplyAdd(T a, T b, T c, std::false_type)
+		{
+			return a * b + c;
+		}
+
+		/**
+		 * Horner evaluation of a_k + a_{k+1} x + ... over the last
+		 * t_remaining coefficients, unrolled at compile time
+		 */
+		template<std::size_t t_k, std::size_t t_remaining>
+		struct Horner
+		{
+			template<typename T>
+			static T apply(T const* a, T x)
+			{
+				return multiplyAdd(Horner<t_k + 1, t_remaining - 1>::apply(a, x), x, a[t_k], FastFma<T>());
+			}
+		};
+
+		template<std::size_t t_k>
+		struct Horner<t_k, 1>
+		{
+			template<typename T>
+			static T apply(T const* a, T)
+			{
+				return a[t_k];
+			}
+		};
+
+		template<typename X, typename Y, typename t_indices>
+		class PolynomialImpl;
+
+		template<typename X, typename Y, std::size_t... t_k>
+		class PolynomialImpl<X, Y, std::index_sequence<t_k...>>
+		{
+			using TX = typename X::BaseType;
+			using T = typename Y::BaseType;
+			static constexpr std::size_t Count = sizeof...(t_k);
+		public:
+			using Input = X;
+			using Output = Y;
+
+			template<std::size_t k>
+			using Coefficient = PolynomialCoefficient<X, Y, k>;
+
+			static constexpr std::size_t Degree = Count - 1;
+
+			/**
+			 * Takes the coefficients a_0 ... a_N in order of increasing
+			 * power, each of which must have the type Y / X^k
+			 */
+			constexpr PolynomialImpl(Coefficient<t_k> const&... coefficients)
+				: m_a{ T(coefficients.val)... }
+			{}
+
+			template<std::size_t k>
+			constexpr Coefficient<k> coefficient() const
+			{
+				static_assert(k < Count, "Coefficient index exceeds the degree");
+				return Coefficient<k>(m_a[k]);
+			}
+
+			/**
+			 * Horner evaluation. Being constexpr, this is written as a
+			 * multiplication and an addition, which the compiler contracts
+			 * into FMAs where it is allowed to.
+			 */
+			constexpr Y operator()(X x) const
+			{
+				T r = m_a[Count - 1];
+				for(std::size_t k = Count - 1; k > 0; k--)
+				{
+					r = r * T(x.val) + m_a[k - 1];
+				}
+				return Y(r);
+			}
+
+			/**
+			 * Evaluates the polynomial for n inputs, using std::fma where the
+			 * target has a fast one. The coefficients are copied first so
+			 * they cannot alias the output, and the loop over the inputs
+			 * vectorises.
+			 */
+			void eval(X const* in, Y* out, std::size_t n) const
+			{
+				T const a[Count] = { m_a[t_k]... };
+				TX const* x = _internal::raw(in);
+				T* y = _internal::raw(out);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					y[i] = Horner<0, Count>::apply(a, T(x[i]));
+				}
+			}
+
+			/**
+			 * Evaluates the polynomial for every input in in. Throws
+			 * std::invalid_argument unless out has the size of in.
+			 */
+			void eval(Span<X const> in, Span<Y> out) const
+			{
+				if(in.size() != out.size())
+				{
+					throw std::invalid_argument("The input and output of a polynomial must have the same size");
+				}
+				eval(in.data(), out.data(), in.size());
+			}
+
+		private:
+			T m_a[Count];
+		};
+	}
+
+	/**
+	 * @brief Polynomial of degree t_degree from X to Y
+	 *
+	 * a_0 + a_1 x + ... + a_N x^N, where the coefficient a_k has the type
+	 * Y / X^k, derived with Pow and operator/. For example the coefficients
+	 * of Polynomial<Kelvin, Pascals, 2> are Pascals, Pascals per Kelvin and
+	 * Pascals per square Kelvin, and passing them in the wrong order does
+	 * not compile.
+	 */
+	template<typename X, typename Y, std::size_t t_degree>
+	using Polynomial = _internal::PolynomialImpl<X, Y, std::make_index_sequence<t_degree + 1>>;
+}
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "mesitype.h"
+#include "mesitype_angle.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	namespace Random {
+		/**
+		 * Philox4x32-10, a counter-based random number generator: block i
+		 * of a stream is a keyed hash of i, so blocks can be computed in
+		 * any order and in parallel, and the generator vectorises.
+		 *
+		 * The key is the seed, and the counter holds the block index and
+		 * the stream number, so every (seed, stream) pair yields its own
+		 * sequence of 2^66 values. Threads that use the same seed and their
+		 * own stream numbers draw independent values, and reproduce them no
+		 * matter how the work is scheduled.
+		 *
+		 * This also meets the requirements of a uniform random bit
+		 * generator, so it works with the std distributions.
+		 */
+		class Philox
+		{
+		public:
+			using result_type = std::uint32_t;
+
+			explicit Philox(std::uint64_t seed = 0, std::uint64_t stream = 0)
+				:m_key{ std::uint32_t(seed), std::uint32_t(seed >> 32) }, m_stream(stream)
+			{}
+
+			static constexpr result_type min() { return 0; }
+			static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+			/**
+			 * A generator with the same seed and a different stream
+			 */
+			Philox stream(std::uint64_t stream) const
+			{
+				Philox ret(*this);
+				ret.m_stream = stream;
+				ret.seek(0);
+				return ret;
+			}
+
+			/**
+			 * Moves to the start of block block of the stream. Each block
+			 * holds four values.
+			 */
+			void seek(std::uint64_t block)
+			{
+				m_counter = block;
+				m_used = 4;
+			}
+
+			result_type operator()()
+			{
+				result_type ret;
+				fill(&ret, 1);
+				return ret;
+			}
+
+			/**
+			 * Writes the next n values of the stream to out. Splitting a
+			 * fill into several does not change the values.
+			 */
+			void fill(result_type* out, std::size_t n)
+			{
+				std::size_t i = 0;
+				while(i < n && m_used < 4)
+				{
+					out[i++] = m_buffer[m_used++];
+				}
+				std::size_t const blocks = (n - i) / 4;
+				generate(m_counter, blocks, out + i);
+				m_counter += blocks;
+				i += 4 * blocks;
+				if(i < n)
+				{
+					generate(m_counter, 1, m_buffer);
+					m_counter++;
+					m_used = 0;
+					while(i < n)
+					{
+						out[i++] = m_buffer[m_used++];
+					}
+				}
+			}
+
+			/**
+			 * Computes blocks [first, first + count) of the stream into out
+			 */
+			void generate(std::uint64_t first, std::size_t count, result_type* out) const
+			{
+				for(std::size_t b = 0; b < count; b++)
+				{
+					std::uint64_t const c = first + b;
+					std::uint32_t x0 = std::uint32_t(c);
+					std::uint32_t x1 = std::uint32_t(c >> 32);
+					std::uint32_t x2 = std::uint32_t(m_stream);
+					std::uint32_t x3 = std::uint32_t(m_stream >> 32);
+					std::uint32_t k0 = m_key[0];
+					std::uint32_t k1 = m_key[1];
+					for(int round = 0; round < 10; round++)
+					{
+						std::uint64_t const p0 = std::uint64_t(0xD2511F53u) * x0;
+						std::uint64_t const p1 = std::uint64_t(0xCD9E8D57u) * x2;
+						x0 = std::uint32_t(p1 >> 32) ^ x1 ^ k0;
+						x1 = std::uint32_t(p1);
+						x2 = std::uint32_t(p0 >> 32) ^ x3 ^ k1;
+						x3 = std::uint32_t(p0);
+						k0 += 0x9E3779B9u;
+						k1 += 0xBB67AE85u;
+					}
+					out[4 * b] = x0;
+					out[4 * b + 1] = x1;
+					out[4 * b + 2] = x2;
+					out[4 * b + 3] = x3;
+				}
+			}
+
+		private:
+			std::uint32_t m_key[2];
+			std::uint64_t m_stream;
+			std::uint64_t m_counter = 0;
+			std::uint32_t m_buffer[4];
+			std::size_t m_used = 4;
+		};
+	}
+
+	namespace _internal {
+		/**
+		 * Turns random bits into values of T in [0, 1), using words()
+		 * 32-bit values for each. Types other than float take a double
+		 * with 52 random mantissa bits, which is built from its bit pattern
+		 * as 64-bit integers do not convert to double in vector registers
+		 * before AVX-512.
+		 */
+		template<typename T>
+		struct UnitInterval
+		{
+			static_assert(std::is_floating_point<T>::value, "Random quantities need floating point storage");
+
+			static constexpr std::size_t words() { return 2; }
+
+			MESI_INLINE static T value(std::uint32_t const* w, std::size_t i)
+			{
+				std::uint64_t const bits = 0x3FF0000000000000u | (std::uint64_t(w[2 * i]) << 20) | (w[2 * i + 1] >> 12);
+				double d;
+				std::memcpy(&d, &bits, sizeof(d));
+				return T(d - 1.0);
+			}
+		};
+
+		template<>
+		struct UnitInterval<float>
+		{
+			static constexpr std::size_t words() { return 1; }
+
+			MESI_INLINE static float value(std::uint32_t const* w, std::size_t i)
+			{
+				return float(std::int32_t(w[i] >> 8)) * (1.0f / 16777216.0f);
+			}
+		};
+
+		/**
+		 * The size of the blocks bulk generation works in
+		 */
+		constexpr std::size_t s_randomBlock = 256;
+
+		/**
+		 * Fills out with n uniform values in [0, 1)
+		 */
+		template<typename T>
+		void uniform(Random::Philox& g, T* out, std::size_t n)
+		{
+			using U = UnitInterval<T>;
+			std::uint32_t bits[s_randomBlock * U::words()];
+			for(std::size_t begin = 0; begin < n; begin += s_randomBlock)
+			{
+				std::size_t const m = n - begin < s_randomBlock ? n - begin : s_randomBlock;
+				g.fill(bits, m * U::words());
+				for(std::size_t i = 0; i < m; i++)
+				{
+					out[begin + i] = U::value(bits, i);
+				}
+			}
+		}
+
+		/**
+		 * Fills out with n standard normal values, using the Box-Muller
+		 * transform on pairs of uniform values
+		 */
+		template<typename T>
+		void standardNormal(Random::Philox& g, T* out, std::size_t n)
+		{
+			using U = UnitInterval<T>;
+			constexpr std::size_t pairs = s_randomBlock / 2;
+			std::uint32_t bits[2 * pairs * U::words()];
+			T radius[pairs];
+			T angle[pairs];
+			T s[pairs];
+			T c[pairs];
+			for(std::size_t begin = 0; begin < n; begin += 2 * pairs)
+			{
+				std::size_t const m = n - begin < 2 * pairs ? n - begin : 2 * pairs;
+				std::size_t const p = (m + 1) / 2;
+				g.fill(bits, 2 * p * U::words());
+				for(std::size_t i = 0; i < p; i++)
+				{
+					// 1 - u is in (0, 1], so its logarithm is finite
+					radius[i] = T(1) - U::value(bits, 2 * i);
+					angle[i] = T(6.283185307179586476925286766559) * U::value(bits, 2 * i + 1);
+				}
+				for(std::size_t i = 0; i < p; i++)
+				{
+					radius[i] = std::sqrt(T(-2) * std::log(radius[i]));
+				}
+				BulkTrig<T>::template run<true, true>(angle, p, T(1), s, c);
+				for(std::size_t i = 0; i < m / 2; i++)
+				{
+					out[begin + 2 * i] = radius[i] * c[i];
+					out[begin + 2 * i + 1] = radius[i] * s[i];
+				}
+				if(m % 2)
+				{
+					out[begin + m - 1] = radius[p - 1] * c[p - 1];
+				}
+			}
+		}
+	}
+
+	namespace Random {
+		/*
+		 * Distributions of quantities of type Q, which must have floating
+		 * point storage. Their parameters are quantities as well, and they
+		 * work on the stored values, so Q may have any unit and scale.
+		 * fill() writes n values, or a whole Span such as a column of a
+		 * ComponentPool, in bulk, in loops that vectorise where the
+		 * standard library allows; operator() draws a single value.
+		 * Both take their random bits from a Philox generator, and the
+		 * values only depend on its seed, stream and position.
+		 */
+
+		/**
+		 * Uniform values in [low, high)
+		 */
+		template<typename Q>
+		class Uniform
+		{
+		public:
+			using T = typename Q::BaseType;
+
+			Uniform(Q low, Q high)
+				:m_low(low.val), m_width(high.val - low.val), m_last(std::nextafter(high.val, low.val))
+			{}
+
+			void fill(Philox& g, Q* out, std::size_t n) const
+			{
+				T* const v = _internal::raw(out);
+				_internal::uniform(g, v, n);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					// Values just below 1 may round up to high
+					v[i] = std::min(m_low + m_width * v[i], m_last);
+				}
+			}
+
+			void fill(Philox& g, Span<Q> out) const
+			{
+				fill(g, out.data(), out.size());
+			}
+
+			Q operator()(Philox& g) const
+			{
+				Q ret;
+				fill(g, &ret, 1);
+				return ret;
+			}
+
+		private:
+			T m_low;
+			T m_width;
+			T m_last;
+		};
+
+		/**
+		 * Normal values with the given mean and standard deviation
+		 */
+		template<typename Q>
+		class Normal
+		{
+		public:
+			using T = typename Q::BaseType;
+
+			Normal(Q mean, Q stddev)
+				:m_mean(mean.val), m_stddev(stddev.val)
+			{}
+
+			void fill(Philox& g, Q* out, std::size_t n) const
+			{
+				T* const v = _internal::raw(out);
+				_internal::standardNormal(g, v, n);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					v[i] = m_mean + m_stddev * v[i];
+				}
+			}
+
+			void fill(Philox& g, Span<Q> out) const
+			{
+				fill(g, out.data(), out.size());
+			}
+
+			Q operator()(Philox& g) const
+			{
+				Q ret;
+				fill(g, &ret, 1);
+				return ret;
+			}
+
+		private:
+			T m_mean;
+			T m_stddev;
+		};
+
+		/**
+		 * Exponential values with the given mean, e.g. waiting times
+		 * between events that happen at the rate 1/mean
+		 */
+		template<typename Q>
+		class Exponential
+		{
+		public:
+			using T = typename Q::BaseType;
+
+			explicit Exponential(Q mean)
+				:m_mean(mean.val)
+			{}
+
+			void fill(Philox& g, Q* out, std::size_t n) const
+			{
+				T* const v = _internal::raw(out);
+				_internal::uniform(g, v, n);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					v[i] = -m_mean * std::log(T(1) - v[i]);
+				}
+			}
+
+			void fill(Philox& g, Span<Q> out) const
+			{
+				fill(g, out.data(), out.size());
+			}
+
+			Q operator()(Philox& g) const
+			{
+				Q ret;
+				fill(g, &ret, 1);
+				return ret;
+			}
+
+		private:
+			T m_mean;
+		};
+
+		/**
+		 * Log-normal values median * exp(sigma * z) for standard normal
+		 * z. The median takes the place of exp(mu), which would need the
+		 * logarithm of a quantity, and sigma is dimensionless.
+		 */
+		template<typename Q>
+		class LogNormal
+		{
+		public:
+			using T = typename Q::BaseType;
+
+			LogNormal(Q median, typename Q::ScalarType sigma)
+				:m_median(median.val), m_sigma(sigma.val)
+			{}
+
+			void fill(Philox& g, Q* out, std::size_t n) const
+			{
+				T* const v = _internal::raw(out);
+				_internal::standardNormal(g, v, n);
+				for(std::size_t i = 0; i < n; i++)
+				{
+					v[i] = m_median * std::exp(m_sigma * v[i]);
+				}
+			}
+
+			void fill(Philox& g, Span<Q> out) const
+			{
+				fill(g, out.data(), out.size());
+			}
+
+			Q operator()(Philox& g) const
+			{
+				Q ret;
+				fill(g, &ret, 1);
+				return ret;
+			}
+
+		private:
+			T m_median;
+			T m_sigma;
+		};
+	}
+}
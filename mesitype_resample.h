@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesitype.h"
+
+namespace Mesi {
+	/*
+	 * Joining and resampling of time series given as an array of sample
+	 * times and an array of values. All times must be sorted in ascending
+	 * order and share one time type, which may have integral storage, e.g.
+	 * nanoseconds in a std::int64_t; times are only ever compared and
+	 * subtracted in that type. Every function makes a single pass over its
+	 * inputs.
+	 */
+
+	/**
+	 * Inner join on equal times: writes every time present in both series
+	 * together with the values of both, and returns the number written.
+	 * The outputs need room for min(na, nb) entries.
+	 */
+	template<typename t_time, typename A, typename B>
+	std::size_t mergeJoin(t_time const* ta, A const* a, std::size_t na, t_time const* tb, B const* b, std::size_t nb, t_time* t, A* outA, B* outB)
+	{
+		std::size_t i = 0;
+		std::size_t j = 0;
+		std::size_t n = 0;
+		while(i < na && j < nb)
+		{
+			if(ta[i] < tb[j])
+			{
+				i++;
+			}
+			else if(tb[j] < ta[i])
+			{
+				j++;
+			}
+			else
+			{
+				t[n] = ta[i];
+				outA[n] = a[i];
+				outB[n] = b[j];
+				n++;
+				i++;
+				j++;
+			}
+		}
+		return n;
+	}
+
+	/**
+	 * As-of join: out[i] is the last source value sampled at or before
+	 * target time i. Targets before the first source sample have no such
+	 * value; their outputs are left untouched and their count is returned.
+	 */
+	template<typename t_time, typename Q>
+	std::size_t asOfJoin(t_time const* ts, Q const* source, std::size_t ns, t_time const* tt, std::size_t nt, Q* out)
+	{
+		std::size_t i = 0;
+		while(i < nt && (ns == 0 || tt[i] < ts[0]))
+		{
+			i++;
+		}
+		std::size_t const skipped = i;
+		std::size_t j = 0;
+		for(; i < nt; i++)
+		{
+			while(j + 1 < ns && ts[j + 1] <= tt[i])
+			{
+				j++;
+			}
+			out[i] = source[j];
+		}
+		return skipped;
+	}
+
+	/**
+	 * Resamples onto the target times, taking the source sample nearest
+	 * in time, and the earlier one on ties. The source must not be empty.
+	 */
+	template<typename t_time, typename Q>
+	void resampleNearest(t_time const* ts, Q const* source, std::size_t ns, t_time const* tt, std::size_t nt, Q* out)
+	{
+		std::size_t j = 0;
+		for(std::size_t i = 0; i < nt; i++)
+		{
+			while(j + 1 < ns && ts[j + 1] <= tt[i])
+			{
+				j++;
+			}
+			bool const next = j + 1 < ns && tt[i] - ts[j] > ts[j + 1] - tt[i];
+			out[i] = source[next ? j + 1 : j];
+		}
+	}
+
+	/**
+	 * Resamples onto the target times by linear interpolation between the
+	 * neighbouring source samples, holding the first and last value
+	 * outside the source. The source must not be empty.
+	 *
+	 * Targets are processed in blocks: a merge pass finds the interval and
+	 * interpolation weight of each, and a second, branch-free pass blends
+	 * the values, which vectorises into gathered loads.
+	 */
+	template<typename t_time, typename Q>
+	void resampleLinear(t_time const* ts, Q const* source, std::size_t ns, t_time const* tt, std::size_t nt, Q* out)
+	{
+		using T = typename Q::BaseType;
+		constexpr std::size_t block = 64;
+		if(ns == 1)
+		{
+			std::fill(out, out + nt, source[0]);
+			return;
+		}
+		T const* v = _internal::raw(source);
+		std::uint32_t index[block];
+		T weight[block];
+		T tmp[block];
+		std::size_t j = 0;
+		std::size_t begin = 0;
+		while(begin < nt)
+		{
+			// Indices are stored relative to the first interval of the block
+			// so that they fit the narrow gathers. A block ends early in the
+			// unlikely case that its targets span 2^32 source samples.
+			std::size_t const limit = std::min(block, nt - begin);
+			std::size_t base = 0;
+			std::size_t count = 0;
+			for(; count < limit; count++)
+			{
+				t_time const t = tt[begin + count];
+				while(j + 2 < ns && ts[j + 1] <= t)
+				{
+					j++;
+				}
+				if(count == 0)
+				{
+					base = j;
+				}
+				else if(j - base > std::size_t(UINT32_MAX - 1))
+				{
+					break;
+				}
+				index[count] = std::uint32_t(j - base);
+				if(t <= ts[j])
+				{
+					weight[count] = T(0);
+				}
+				else if(ts[j + 1] <= t)
+				{
+					weight[count] = T(1);
+				}
+				else
+				{
+					weight[count] = T((t - ts[j]).val) / T((ts[j + 1] - ts[j]).val);
+				}
+			}
+			T const* vb = v + base;
+			for(std::size_t i = 0; i < count; i++)
+			{
+				T const a = vb[index[i]];
+				T const b = vb[index[i] + 1];
+				tmp[i] = a + (b - a) * weight[i];
+			}
+			std::copy(tmp, tmp + count, _internal::raw(out) + begin);
+			begin += count;
+		}
+	}
+}
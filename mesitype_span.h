@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace Mesi {
+	/**
+	 * A view of n contiguous values of type T
+	 */
+	template<typename T>
+	class Span
+	{
+	public:
+		Span(T* data, std::size_t size)
+			: m_data(data)
+			, m_size(size)
+		{}
+
+		template<std::size_t t_size>
+		Span(T (&data)[t_size])
+			: m_data(data)
+			, m_size(t_size)
+		{}
+
+		/**
+		 * A Span of const values from one of mutable values
+		 */
+		template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+		Span(Span<U> const& other)
+			: m_data(other.data())
+			, m_size(other.size())
+		{}
+
+		T* data() const
+		{
+			return m_data;
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		T& operator[](std::size_t i) const
+		{
+			return m_data[i];
+		}
+
+		T* begin() const
+		{
+			return m_data;
+		}
+
+		T* end() const
+		{
+			return m_data + m_size;
+		}
+
+	private:
+		T* m_data;
+		std::size_t m_size;
+	};
+}
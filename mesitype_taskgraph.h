@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mesitype.h"
+#include "mesitype_parallel.h"
+#include "mesitype_span.h"
+
+namespace Mesi {
+	class TaskGraph;
+
+	/**
+	 * An array of quantities of type Q that nodes of a TaskGraph read or
+	 * write. The values are owned by the caller; the graph only knows them
+	 * through the Span the buffer was created with.
+	 */
+	template<typename Q>
+	class Buffer
+	{
+	public:
+		using Value = Q;
+
+		Span<Q> span() const
+		{
+			return m_data;
+		}
+
+	private:
+		friend class TaskGraph;
+
+		Buffer(TaskGraph const* graph, std::size_t id, Span<Q> data)
+			: m_graph(graph)
+			, m_id(id)
+			, m_data(data)
+		{}
+
+		TaskGraph const* m_graph;
+		std::size_t m_id;
+		Span<Q> m_data;
+	};
+
+	/**
+	 * The buffers a node reads, made by reads()
+	 */
+	template<typename... Q>
+	struct Reads
+	{
+		std::tuple<Buffer<Q>...> buffers;
+	};
+
+	/**
+	 * The buffers a node writes, made by writes()
+	 */
+	template<typename... Q>
+	struct Writes
+	{
+		std::tuple<Buffer<Q>...> buffers;
+	};
+
+	template<typename... Q>
+	Reads<Q...> reads(Buffer<Q> const&... buffers)
+	{
+		return Reads<Q...>{ std::tuple<Buffer<Q>...>(buffers...) };
+	}
+
+	template<typename... Q>
+	Writes<Q...> writes(Buffer<Q> const&... buffers)
+	{
+		return Writes<Q...>{ std::tuple<Buffer<Q>...>(buffers...) };
+	}
+
+	namespace _internal {
+		template<typename F, typename... A>
+		struct Invocable
+		{
+			template<typename G>
+			static auto test(int) -> decltype(std::declval<G&>()(std::declval<A>()...), std::true_type());
+
+			template<typename G>
+			static std::false_type test(...);
+
+			static constexpr bool value = decltype(test<F>(0))::value;
+		};
+	}
+
+	/**
+	 * @brief Nodes of work that run in parallel as far as the buffers they
+	 * share allow
+	 *
+	 * Each node declares the buffers it reads and writes, and is called
+	 * with a Span of each, e.g. for one step of a simulation:
+	 *
+	 *     TaskGraph tick;
+	 *     auto f = tick.buffer(Span<Newtons>(forces.data(), n));
+	 *     auto a = tick.buffer(Span<Acceleration>(accelerations.data(), n));
+	 *     auto m = tick.buffer(Span<Kilograms>(masses.data(), n));
+	 *     tick.node(reads(f, m), writes(a), [](Span<Newtons const> f, Span<Kilograms const> m, Span<Acceleration> a) {
+	 *         ...
+	 *     });
+	 *
+	 * A node runs after every node added before it that writes a buffer
+	 * it reads or writes, or that reads a buffer it writes, so the graph
+	 * computes what calling the nodes in the order they were added would.
+	 * Nodes that share no written buffer run concurrently on the threads
+	 * of a ThreadPool. A node may also read the buffers it writes.
+	 *
+	 * A node's function must take a Span<Q const> of each buffer it reads
+	 * and a Span<Q> of each buffer it writes, in that order; if a
+	 * producer's buffer does not have the quantity type its consumer
+	 * expects, the node does not compile.
+	 *
+	 * The graph is built once and can be run any number of times, e.g.
+	 * once per tick, without allocating memory. A node may call
+	 * parallel_for and the other parallel algorithms on the graph's pool,
+	 * the default for both; those loops then run inline on the node's
+	 * thread, while the other threads of the pool run other nodes.
+	 */
+	class TaskGraph
+	{
+	public:
+		explicit TaskGraph(ThreadPool& pool = ThreadPool::shared())
+			: m_pool(pool)
+		{}
+
+		TaskGraph(TaskGraph const&) = delete;
+		TaskGraph& operator=(TaskGraph const&) = delete;
+
+		std::size_t size() const
+		{
+			return m_nodes.size();
+		}
+
+		/**
+		 * Makes data known to the graph as a buffer. Each call gives a
+		 * separate buffer, so one array must not be made a buffer twice.
+		 */
+		template<typename Q>
+		Buffer<Q> buffer(Span<Q> data)
+		{
+			m_buffers.push_back(BufferState{ npos, {} });
+			return Buffer<Q>(this, m_buffers.size() - 1, data);
+		}
+
+		/**
+		 * Adds a node that calls f with the spans of in and out
+		 */
+		template<typename... t_in, typename... t_out, typename F>
+		void node(Reads<t_in...> const& in, Writes<t_out...> const& out, F f)
+		{
+			static_assert(_internal::Invocable<F, Span<t_in const>..., Span<t_out>...>::value,
+				"The node's function must take a Span<Q const> of each buffer it reads and a Span<Q> of each buffer it writes");
+			checkAll(in.buffers, std::index_sequence_for<t_in...>());
+			checkAll(out.buffers, std::index_sequence_for<t_out...>());
+			std::size_t const id = m_nodes.size();
+			std::vector<std::size_t> after;
+			dependOn(in.buffers, std::index_sequence_for<t_in...>(), after, false);
+			dependOn(out.buffers, std::index_sequence_for<t_out...>(), after, true);
+			std::sort(after.begin(), after.end());
+			after.erase(std::unique(after.begin(), after.end()), after.end());
+
+			m_nodes.push_back(Node{ [f, in, out]() mutable {
+				call(f, in, out, std::index_sequence_for<t_in...>(), std::index_sequence_for<t_out...>());
+			}, {}, after.size() });
+			for(std::size_t const a : after)
+			{
+				m_nodes[a].next.push_back(id);
+			}
+			m_remaining.resize(m_nodes.size());
+			m_ready.reserve(m_nodes.size());
+		}
+
+		/**
+		 * Adds a node that only writes out
+		 */
+		template<typename... t_out, typename F>
+		void node(Writes<t_out...> const& out, F f)
+		{
+			node(Reads<>(), out, f);
+		}
+
+		/**
+		 * Runs every node once and returns when all have finished. If a
+		 * node throws, the nodes not yet started are skipped, and the first
+		 * exception is rethrown here.
+		 */
+		void run()
+		{
+			if(m_nodes.empty())
+			{
+				return;
+			}
+			m_ready.clear();
+			for(std::size_t i = 0; i < m_nodes.size(); i++)
+			{
+				m_remaining[i] = m_nodes[i].dependencies;
+				if(m_remaining[i] == 0)
+				{
+					m_ready.push_back(i);
+				}
+			}
+			// Take the first nodes first
+			std::reverse(m_ready.begin(), m_ready.end());
+			m_finished = 0;
+			m_exception = nullptr;
+			m_pool.run(m_pool.threads(), [this](std::size_t) { work(); });
+			if(m_exception)
+			{
+				std::rethrow_exception(m_exception);
+			}
+		}
+
+	private:
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		struct Node
+		{
+			std::function<void()> run;
+			/** Nodes that depend on this one */
+			std::vector<std::size_t> next;
+			std::size_t dependencies;
+		};
+
+		struct BufferState
+		{
+			/** The node that last wrote the buffer, or npos */
+			std::size_t writer;
+			/** The nodes that read the buffer since */
+			std::vector<std::size_t> readers;
+		};
+
+		template<typename... t_in, typename... t_out, typename F, std::size_t... t_i, std::size_t... t_o>
+		static void call(F& f, Reads<t_in...> const& in, Writes<t_out...> const& out, std::index_sequence<t_i...>, std::index_sequence<t_o...>)
+		{
+			f(Span<t_in const>(std::get<t_i>(in.buffers).span())..., std::get<t_o>(out.buffers).span()...);
+		}
+
+		template<typename t_tuple, std::size_t... t_i>
+		void dependOn(t_tuple const& buffers, std::index_sequence<t_i...>, std::vector<std::size_t>& after, bool write)
+		{
+			std::size_t const ids[] = { check(std::get<t_i>(buffers))..., npos };
+			std::size_t const id = m_nodes.size();
+			for(std::size_t i = 0; i < sizeof...(t_i); i++)
+			{
+				BufferState& b = m_buffers[ids[i]];
+				if(b.writer != npos && b.writer != id)
+				{
+					after.push_back(b.writer);
+				}
+				if(write)
+				{
+					for(std::size_t const r : b.readers)
+					{
+						if(r != id)
+						{
+							after.push_back(r);
+						}
+					}
+					b.readers.clear();
+					b.writer = id;
+				}
+				else
+				{
+					b.readers.push_back(id);
+				}
+			}
+		}
+
+		template<typename t_tuple, std::size_t... t_i>
+		void checkAll(t_tuple const& buffers, std::index_sequence<t_i...>) const
+		{
+			(void)std::initializer_list<int>{ (check(std::get<t_i>(buffers)), 0)... };
+		}
+
+		template<typename Q>
+		std::size_t check(Buffer<Q> const& b) const
+		{
+			if(b.m_graph != this)
+			{
+				throw std::invalid_argument("The buffer belongs to another task graph");
+			}
+			return b.m_id;
+		}
+
+		/**
+		 * Runs ready nodes until all have finished. A thread that finishes
+		 * a node goes on with one of the nodes it made ready, which likely
+		 * reads what it has just written.
+		 */
+		void work()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for(;;)
+			{
+				m_wake.wait(lock, [this] { return !m_ready.empty() || m_finished == m_nodes.size() || m_exception; });
+				if(m_finished == m_nodes.size() || m_exception)
+				{
+					return;
+				}
+				std::size_t node = m_ready.back();
+				m_ready.pop_back();
+				while(node != npos)
+				{
+					lock.unlock();
+					try
+					{
+						m_nodes[node].run();
+					}
+					catch(...)
+					{
+						lock.lock();
+						if(!m_exception)
+						{
+							m_exception = std::current_exception();
+						}
+						m_wake.notify_all();
+						return;
+					}
+					lock.lock();
+					m_finished++;
+					if(m_finished == m_nodes.size() || m_exception)
+					{
+						m_wake.notify_all();
+						return;
+					}
+					std::size_t following = npos;
+					std::size_t woken = 0;
+					for(std::size_t const n : m_nodes[node].next)
+					{
+						if(--m_remaining[n] == 0)
+						{
+							if(following == npos)
+							{
+								following = n;
+							}
+							else
+							{
+								m_ready.push_back(n);
+								woken++;
+							}
+						}
+					}
+					if(woken == 1)
+					{
+						m_wake.notify_one();
+					}
+					else if(woken > 1)
+					{
+						m_wake.notify_all();
+					}
+					node = following;
+				}
+			}
+		}
+
+		ThreadPool& m_pool;
+		std::vector<Node> m_nodes;
+		std::vector<BufferState> m_buffers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::vector<std::size_t> m_remaining;
+		std::vector<std::size_t> m_ready;
+		std::size_t m_finished = 0;
+		std::exception_ptr m_exception;
+	};
+}
@@ -0,0 +1,134 @@
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_angle.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using RadiansD = Mesi::Radians::WithBaseType<double>;
+	using DegreesD = Mesi::Degrees::WithBaseType<double>;
+	using ScalarD = Mesi::Scalar::WithBaseType<double>;
+
+	constexpr long double s_pi = 3.141592653589793238462643383279502884L;
+
+	bool near(double a, double b, double tolerance = 1e-6)
+	{
+		return std::fabs(a - b) <= tolerance;
+	}
+
+	/**
+	 * The largest absolute error of the bulk sine and cosine over n angles
+	 * spread evenly over [-range, range], relative to the exact values for
+	 * the angles converted to radians in T
+	 */
+	template<typename A>
+	long double bulkError(double range, std::size_t n)
+	{
+		using T = typename A::BaseType;
+		std::vector<A> in(n);
+		std::vector<Mesi::Type<T, 0, 0, 0>> s(n), c(n), s2(n);
+		for(std::size_t i = 0; i < n; i++)
+		{
+			in[i] = A(T(-range + 2 * range * double(i) / double(n - 1)));
+		}
+		Mesi::sincos(in.data(), n, s.data(), c.data());
+		Mesi::sin(in.data(), n, s2.data());
+		long double error = 0;
+		for(std::size_t i = 0; i < n; i++)
+		{
+			long double const x = in[i].radians().val;
+			error = std::max(error, std::fabs(std::sin(x) - (long double)(s[i].val)));
+			error = std::max(error, std::fabs(std::cos(x) - (long double)(c[i].val)));
+			error = std::max(error, std::fabs((long double)(s2[i].val) - (long double)(s[i].val)));
+		}
+		return error;
+	}
+}
+
+Tee_Test(test_angle) {
+	Tee_SubTest(test_types) {
+		static_assert(!std::is_convertible<Mesi::Radians, Mesi::Degrees>::value, "Radians and degrees do not mix");
+		static_assert(!std::is_convertible<Mesi::Radians, Mesi::Scalar>::value, "Angles are not Scalars");
+		static_assert(!std::is_convertible<Mesi::Scalar, Mesi::Radians>::value, "Scalars are not angles");
+		static_assert(std::is_same<decltype(Mesi::Radians{} / Mesi::Radians{}), Mesi::Scalar>::value, "The ratio of angles is a Scalar");
+		static_assert(std::is_same<decltype(Mesi::Degrees{} * Mesi::Scalar{}), Mesi::Degrees>::value, "Scalars scale angles");
+		static_assert(std::is_trivially_copyable<Mesi::Degrees>::value, "Angles are trivially copyable");
+
+		constexpr Mesi::Radians r = Mesi::Radians(Mesi::Degrees(180));
+		static_assert(r.val > 3.14159f && r.val < 3.1416f, "Conversions are constexpr");
+		static_assert(float(Mesi::Radians(1.5f)) == 1.5f, "Access to the value is constexpr");
+		static_assert(Mesi::_internal::ScaleFactor<DegreesD::ScaleInfo, double>::value() == double(s_pi / 180), "The degree ratio rounds to pi/180");
+
+		assert(Mesi::Radians::getUnit() == "rad");
+		assert(Mesi::Degrees::getUnit() == " * 21023143/1204537366 rad");
+	}
+
+	Tee_SubTest(test_arithmetic) {
+		using namespace Mesi::Literals;
+		assert(90_deg + 90_deg == 180_deg);
+		assert(1_rad - 0.5_rad == 0.5_rad);
+		assert(2 * 45_deg == 90_deg && 90_deg / 2 == 45_deg);
+		assert(Mesi::Scalar(2) * 45_deg == 90_deg);
+		assert(90_deg / 45_deg == Mesi::Scalar(2));
+		assert(-(10_deg) < 10_deg && 10_deg >= 10_deg);
+
+		Mesi::Degrees d = 30_deg;
+		d += 60_deg;
+		d *= 2;
+		assert(d == 180_deg);
+
+		assert(near(DegreesD(RadiansD(double(s_pi))).val, 180, 1e-12));
+		assert(near(DegreesD(90).radians().val, double(s_pi / 2), 1e-15));
+		Mesi::Meters const arc = Mesi::Meters(2) * (90_deg).radians();
+		assert(near(arc.val, double(s_pi), 1e-6));
+	}
+
+	Tee_SubTest(test_functions) {
+		using namespace Mesi::Literals;
+		assert(near(Mesi::sin(30_deg).val, 0.5));
+		assert(near(Mesi::cos(60_deg).val, 0.5));
+		assert(near(Mesi::tan(45_deg).val, 1));
+		auto const sc = Mesi::sincos(DegreesD(90));
+		static_assert(std::is_same<decltype(sc.sin), ScalarD>::value, "sincos yields Scalars");
+		assert(near(sc.sin.val, 1, 1e-15) && near(sc.cos.val, 0, 1e-15));
+
+		auto const a = Mesi::atan2(Mesi::Meters(1), Mesi::Meters(1));
+		static_assert(std::is_same<decltype(a), Mesi::Radians const>::value, "atan2 yields an angle");
+		assert(near(Mesi::Degrees(a).val, 45, 1e-5));
+		assert(near(Mesi::atan2(Mesi::Kilo<Mesi::Meters>(-1), Mesi::Kilo<Mesi::Meters>(0)).val, -s_pi / 2));
+		assert(near(DegreesD(Mesi::asin(ScalarD(0.5))).val, 30, 1e-12));
+		assert(near(DegreesD(Mesi::acos(ScalarD(0.5))).val, 60, 1e-12));
+		assert(near(DegreesD(Mesi::atan(ScalarD(1))).val, 45, 1e-12));
+	}
+
+	Tee_SubTest(test_bulk) {
+		assert(bulkError<Mesi::Radians>(8192, 100001) < 1e-7L);
+		assert(bulkError<Mesi::Radians>(4, 10001) < 1e-7L);
+		assert(bulkError<Mesi::Degrees>(720, 10001) < 1e-7L);
+		assert(bulkError<RadiansD>(1073741824.0, 100001) < 2e-16L);
+		assert(bulkError<RadiansD>(10, 10001) < 2e-16L);
+		assert(bulkError<DegreesD>(3600, 10001) < 2e-16L);
+
+		// Arguments beyond the polynomials' range, mixed with ones within it
+		std::vector<RadiansD> in(600, RadiansD(1));
+		in[3] = RadiansD(1e12);
+		in[300] = RadiansD(-std::numeric_limits<double>::infinity());
+		in[301] = RadiansD(std::numeric_limits<double>::quiet_NaN());
+		std::vector<ScalarD> s(in.size()), c(in.size());
+		Mesi::sincos(in.data(), in.size(), s.data(), c.data());
+		assert(s[3].val == std::sin(1e12) && c[3].val == std::cos(1e12));
+		assert(std::isnan(s[300].val) && std::isnan(c[301].val));
+		assert(near(s[0].val, std::sin(1.0), 2e-16) && near(c[599].val, std::cos(1.0), 2e-16));
+		Mesi::cos(in.data(), in.size(), c.data());
+		assert(c[3].val == std::cos(1e12) && near(c[4].val, std::cos(1.0), 2e-16));
+
+		// Types without polynomials use the standard library
+		using RadiansL = Mesi::Radians::WithBaseType<long double>;
+		RadiansL const l[] = { RadiansL(0.5L), RadiansL(2.0L) };
+		Mesi::Scalar::WithBaseType<long double> ls[2];
+		Mesi::sin(l, 2, ls);
+		assert(ls[0].val == std::sin(0.5L) && ls[1].val == std::sin(2.0L));
+	}
+}
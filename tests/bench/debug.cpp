@@ -0,0 +1,119 @@
+/*
+ * Unoptimised build benchmark.
+ *
+ * Integrates a set of damped oscillators with raw floats and with Mesi
+ * types and reports the ratio of their run times. The makefile builds this
+ * twice at -O0, as bench/debug and, with MESI_DEBUG_INLINE defined, as
+ * bench/debug_inline, so the ratio tracks the cost of Mesi types in debug
+ * builds with and without forced inlining.
+ *
+ * Usage: debug [oscillators] [steps] [max ratio]
+ *
+ * If a maximum ratio is given, exceeding it fails the run.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../../mesitype.h"
+
+using namespace std;
+
+namespace {
+	constexpr float s_stiffness = 40.0f;
+	constexpr float s_damping = 0.5f;
+	constexpr float s_dt = 1e-3f;
+
+	using Velocity = decltype(Mesi::Meters{} / Mesi::Seconds{});
+	using Stiffness = decltype(Mesi::Newtons{} / Mesi::Meters{});
+	using Damping = decltype(Mesi::Newtons{} / Velocity{});
+
+	struct Result
+	{
+		double seconds;
+		double checksum;
+	};
+
+	Result runRaw(size_t n, size_t steps)
+	{
+		vector<float> x(n), v(n, 0.0f), m(n);
+		for(size_t i = 0; i < n; i++)
+		{
+			x[i] = 0.001f * float(i % 1000);
+			m[i] = 1.0f + 0.01f * float(i % 100);
+		}
+		auto const start = chrono::steady_clock::now();
+		for(size_t s = 0; s < steps; s++)
+		{
+			for(size_t i = 0; i < n; i++)
+			{
+				float const f = -s_stiffness * x[i] - s_damping * v[i];
+				v[i] += f / m[i] * s_dt;
+				x[i] += v[i] * s_dt;
+			}
+		}
+		chrono::duration<double> const elapsed = chrono::steady_clock::now() - start;
+		double sum = 0;
+		for(size_t i = 0; i < n; i++)
+		{
+			sum += double(x[i]);
+		}
+		return Result{ elapsed.count(), sum };
+	}
+
+	Result runMesi(size_t n, size_t steps)
+	{
+		vector<Mesi::Meters> x(n);
+		vector<Velocity> v(n, Velocity(0.0f));
+		vector<Mesi::Kilograms> m(n);
+		for(size_t i = 0; i < n; i++)
+		{
+			x[i] = Mesi::Meters(0.001f * float(i % 1000));
+			m[i] = Mesi::Kilograms(1.0f + 0.01f * float(i % 100));
+		}
+		Stiffness const k(s_stiffness);
+		Damping const c(s_damping);
+		Mesi::Seconds const dt(s_dt);
+		auto const start = chrono::steady_clock::now();
+		for(size_t s = 0; s < steps; s++)
+		{
+			for(size_t i = 0; i < n; i++)
+			{
+				Mesi::Newtons const f = -k * x[i] - c * v[i];
+				v[i] += f / m[i] * dt;
+				x[i] += v[i] * dt;
+			}
+		}
+		chrono::duration<double> const elapsed = chrono::steady_clock::now() - start;
+		double sum = 0;
+		for(size_t i = 0; i < n; i++)
+		{
+			sum += double(x[i].val);
+		}
+		return Result{ elapsed.count(), sum };
+	}
+}
+
+int main(int argc, char** argv) {
+	size_t const n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4096;
+	size_t const steps = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000;
+	double const maxRatio = argc > 3 ? strtod(argv[3], nullptr) : 0;
+
+#ifdef MESI_DEBUG_INLINE
+	char const* mode = "forced inlining";
+#else
+	char const* mode = "default";
+#endif
+	Result const raw = runRaw(n, steps);
+	Result const typed = runMesi(n, steps);
+	double const ratio = typed.seconds / raw.seconds;
+	bool const match = abs(raw.checksum - typed.checksum) <= 1e-6 * abs(raw.checksum);
+	cout << "Debug build, " << mode << ", " << n << " oscillators, " << steps << " steps" << endl;
+	cout << fixed << setprecision(3)
+		<< "raw " << raw.seconds << " s, mesi " << typed.seconds << " s, overhead ratio "
+		<< setprecision(2) << ratio << (match ? "" : "  results differ") << endl;
+	return match && (maxRatio <= 0 || ratio <= maxRatio) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,462 @@
+/*
+ * Gravitational N-body benchmark.
+ *
+ * Runs the same step, direct summation of forces followed by a
+ * semi-implicit Euler update, with raw floating point values and with Mesi
+ * types, in array-of-structs and struct-of-arrays layouts, and reports the
+ * steps per second of each and the overhead of the Mesi version. The raw
+ * and Mesi kernels perform the same operations in the same order, so their
+ * results match exactly unless the compiler contracts them into FMAs
+ * differently; the makefile builds with -ffp-contract=off for that reason,
+ * and any difference beyond rounding fails the run.
+ *
+ * Usage: nbody [bodies] [steps] [threads]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../mesitype_parallel.h"
+
+using namespace std;
+
+namespace {
+	constexpr double s_gravity = 6.674e-11;
+	constexpr double s_softening = 1e-2;
+	constexpr double s_dt = 1e-3;
+	constexpr size_t s_block = 64;
+
+	/**
+	 * Deterministic initial conditions: bodies in a unit cube, at rest,
+	 * with masses around 10^9 kg
+	 */
+	struct Initial
+	{
+		double x, y, z, m;
+	};
+
+	vector<Initial> makeBodies(size_t n)
+	{
+		uint64_t state = 0x9e3779b97f4a7c15ull;
+		auto next = [&state] {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return double(state >> 11) / double(1ull << 53);
+		};
+		vector<Initial> ret(n);
+		for(auto& b : ret)
+		{
+			b.x = next();
+			b.y = next();
+			b.z = next();
+			b.m = 1e9 * (0.5 + next());
+		}
+		return ret;
+	}
+
+	template<typename T>
+	struct RawAos
+	{
+		struct Body
+		{
+			T x, y, z, vx, vy, vz, m;
+		};
+		struct Force
+		{
+			T x, y, z;
+		};
+
+		explicit RawAos(vector<Initial> const& init)
+		{
+			for(auto const& b : init)
+			{
+				bodies.push_back(Body{ T(b.x), T(b.y), T(b.z), T(0), T(0), T(0), T(b.m) });
+			}
+			forces.resize(init.size());
+		}
+
+		void computeForces(size_t begin, size_t end)
+		{
+			T const g = T(s_gravity);
+			T const soft2 = T(s_softening * s_softening);
+			for(size_t i = begin; i < end; i++)
+			{
+				Body const bi = bodies[i];
+				T fx = T(0), fy = T(0), fz = T(0);
+				for(auto const& bj : bodies)
+				{
+					T const dx = bj.x - bi.x;
+					T const dy = bj.y - bi.y;
+					T const dz = bj.z - bi.z;
+					T const r2 = dx * dx + dy * dy + dz * dz + soft2;
+					T const r3 = r2 * sqrt(r2);
+					T const s = g * bi.m * bj.m / r3;
+					fx += s * dx;
+					fy += s * dy;
+					fz += s * dz;
+				}
+				forces[i] = Force{ fx, fy, fz };
+			}
+		}
+
+		void integrate(size_t begin, size_t end)
+		{
+			T const dt = T(s_dt);
+			for(size_t i = begin; i < end; i++)
+			{
+				Body& b = bodies[i];
+				b.vx += forces[i].x / b.m * dt;
+				b.vy += forces[i].y / b.m * dt;
+				b.vz += forces[i].z / b.m * dt;
+				b.x += b.vx * dt;
+				b.y += b.vy * dt;
+				b.z += b.vz * dt;
+			}
+		}
+
+		double checksum() const
+		{
+			double ret = 0;
+			for(auto const& b : bodies)
+			{
+				ret += double(b.x) + double(b.y) + double(b.z);
+			}
+			return ret;
+		}
+
+		vector<Body> bodies;
+		vector<Force> forces;
+	};
+
+	template<typename T>
+	struct RawSoa
+	{
+		explicit RawSoa(vector<Initial> const& init)
+		{
+			for(auto const& b : init)
+			{
+				x.push_back(T(b.x));
+				y.push_back(T(b.y));
+				z.push_back(T(b.z));
+				m.push_back(T(b.m));
+			}
+			vx.assign(init.size(), T(0));
+			vy = vz = fx = fy = fz = vx;
+		}
+
+		void computeForces(size_t begin, size_t end)
+		{
+			T const g = T(s_gravity);
+			T const soft2 = T(s_softening * s_softening);
+			size_t const n = x.size();
+			for(size_t i = begin; i < end; i++)
+			{
+				T fxi = T(0), fyi = T(0), fzi = T(0);
+				for(size_t j = 0; j < n; j++)
+				{
+					T const dx = x[j] - x[i];
+					T const dy = y[j] - y[i];
+					T const dz = z[j] - z[i];
+					T const r2 = dx * dx + dy * dy + dz * dz + soft2;
+					T const r3 = r2 * sqrt(r2);
+					T const s = g * m[i] * m[j] / r3;
+					fxi += s * dx;
+					fyi += s * dy;
+					fzi += s * dz;
+				}
+				fx[i] = fxi;
+				fy[i] = fyi;
+				fz[i] = fzi;
+			}
+		}
+
+		void integrate(size_t begin, size_t end)
+		{
+			T const dt = T(s_dt);
+			for(size_t i = begin; i < end; i++)
+			{
+				vx[i] += fx[i] / m[i] * dt;
+				vy[i] += fy[i] / m[i] * dt;
+				vz[i] += fz[i] / m[i] * dt;
+				x[i] += vx[i] * dt;
+				y[i] += vy[i] * dt;
+				z[i] += vz[i] * dt;
+			}
+		}
+
+		double checksum() const
+		{
+			double ret = 0;
+			for(size_t i = 0; i < x.size(); i++)
+			{
+				ret += double(x[i]) + double(y[i]) + double(z[i]);
+			}
+			return ret;
+		}
+
+		vector<T> x, y, z, vx, vy, vz, m, fx, fy, fz;
+	};
+
+	/**
+	 * The quantities of the simulation with storage type T
+	 */
+	template<typename T>
+	struct Units
+	{
+		using Meters = Mesi::Meters::WithBaseType<T>;
+		using MetersSq = Mesi::MetersSq::WithBaseType<T>;
+		using Seconds = Mesi::Seconds::WithBaseType<T>;
+		using Kilograms = Mesi::Kilograms::WithBaseType<T>;
+		using Newtons = Mesi::Newtons::WithBaseType<T>;
+		using Velocity = typename decltype(Mesi::Meters{} / Mesi::Seconds{})::template WithBaseType<T>;
+		using Gravity = typename decltype(Mesi::Newtons{} * Mesi::MetersSq{} / Mesi::KilogramsSq{})::template WithBaseType<T>;
+	};
+
+	template<typename T>
+	struct MesiAos : Units<T>
+	{
+		using typename Units<T>::Meters;
+		using typename Units<T>::MetersSq;
+		using typename Units<T>::Seconds;
+		using typename Units<T>::Kilograms;
+		using typename Units<T>::Newtons;
+		using typename Units<T>::Velocity;
+		using typename Units<T>::Gravity;
+
+		struct Body
+		{
+			Meters x, y, z;
+			Velocity vx, vy, vz;
+			Kilograms m;
+		};
+		struct Force
+		{
+			Newtons x, y, z;
+		};
+
+		explicit MesiAos(vector<Initial> const& init)
+		{
+			for(auto const& b : init)
+			{
+				bodies.push_back(Body{ Meters(T(b.x)), Meters(T(b.y)), Meters(T(b.z)),
+					Velocity(T(0)), Velocity(T(0)), Velocity(T(0)), Kilograms(T(b.m)) });
+			}
+			forces.resize(init.size());
+		}
+
+		void computeForces(size_t begin, size_t end)
+		{
+			Gravity const g = Gravity(T(s_gravity));
+			MetersSq const soft2 = MetersSq(T(s_softening * s_softening));
+			for(size_t i = begin; i < end; i++)
+			{
+				Body const bi = bodies[i];
+				Newtons fx(T(0)), fy(T(0)), fz(T(0));
+				for(auto const& bj : bodies)
+				{
+					Meters const dx = bj.x - bi.x;
+					Meters const dy = bj.y - bi.y;
+					Meters const dz = bj.z - bi.z;
+					MetersSq const r2 = dx * dx + dy * dy + dz * dz + soft2;
+					// There is no typed sqrt, so the distance is rebuilt from val
+					auto const r3 = r2 * Meters(sqrt(r2.val));
+					auto const s = g * bi.m * bj.m / r3;
+					fx += s * dx;
+					fy += s * dy;
+					fz += s * dz;
+				}
+				forces[i] = Force{ fx, fy, fz };
+			}
+		}
+
+		void integrate(size_t begin, size_t end)
+		{
+			Seconds const dt = Seconds(T(s_dt));
+			for(size_t i = begin; i < end; i++)
+			{
+				Body& b = bodies[i];
+				b.vx += forces[i].x / b.m * dt;
+				b.vy += forces[i].y / b.m * dt;
+				b.vz += forces[i].z / b.m * dt;
+				b.x += b.vx * dt;
+				b.y += b.vy * dt;
+				b.z += b.vz * dt;
+			}
+		}
+
+		double checksum() const
+		{
+			double ret = 0;
+			for(auto const& b : bodies)
+			{
+				ret += double(b.x.val) + double(b.y.val) + double(b.z.val);
+			}
+			return ret;
+		}
+
+		vector<Body> bodies;
+		vector<Force> forces;
+	};
+
+	template<typename T>
+	struct MesiSoa : Units<T>
+	{
+		using typename Units<T>::Meters;
+		using typename Units<T>::MetersSq;
+		using typename Units<T>::Seconds;
+		using typename Units<T>::Kilograms;
+		using typename Units<T>::Newtons;
+		using typename Units<T>::Velocity;
+		using typename Units<T>::Gravity;
+
+		explicit MesiSoa(vector<Initial> const& init)
+		{
+			for(auto const& b : init)
+			{
+				x.push_back(Meters(T(b.x)));
+				y.push_back(Meters(T(b.y)));
+				z.push_back(Meters(T(b.z)));
+				m.push_back(Kilograms(T(b.m)));
+			}
+			vx.assign(init.size(), Velocity(T(0)));
+			vy = vz = vx;
+			fx.assign(init.size(), Newtons(T(0)));
+			fy = fz = fx;
+		}
+
+		void computeForces(size_t begin, size_t end)
+		{
+			Gravity const g = Gravity(T(s_gravity));
+			MetersSq const soft2 = MetersSq(T(s_softening * s_softening));
+			size_t const n = x.size();
+			for(size_t i = begin; i < end; i++)
+			{
+				Newtons fxi(T(0)), fyi(T(0)), fzi(T(0));
+				for(size_t j = 0; j < n; j++)
+				{
+					Meters const dx = x[j] - x[i];
+					Meters const dy = y[j] - y[i];
+					Meters const dz = z[j] - z[i];
+					MetersSq const r2 = dx * dx + dy * dy + dz * dz + soft2;
+					auto const r3 = r2 * Meters(sqrt(r2.val));
+					auto const s = g * m[i] * m[j] / r3;
+					fxi += s * dx;
+					fyi += s * dy;
+					fzi += s * dz;
+				}
+				fx[i] = fxi;
+				fy[i] = fyi;
+				fz[i] = fzi;
+			}
+		}
+
+		void integrate(size_t begin, size_t end)
+		{
+			Seconds const dt = Seconds(T(s_dt));
+			for(size_t i = begin; i < end; i++)
+			{
+				vx[i] += fx[i] / m[i] * dt;
+				vy[i] += fy[i] / m[i] * dt;
+				vz[i] += fz[i] / m[i] * dt;
+				x[i] += vx[i] * dt;
+				y[i] += vy[i] * dt;
+				z[i] += vz[i] * dt;
+			}
+		}
+
+		double checksum() const
+		{
+			double ret = 0;
+			for(size_t i = 0; i < x.size(); i++)
+			{
+				ret += double(x[i].val) + double(y[i].val) + double(z[i].val);
+			}
+			return ret;
+		}
+
+		vector<Meters> x, y, z;
+		vector<Velocity> vx, vy, vz;
+		vector<Kilograms> m;
+		vector<Newtons> fx, fy, fz;
+	};
+
+	struct Result
+	{
+		double stepsPerSecond;
+		double checksum;
+	};
+
+	/**
+	 * Runs steps steps of sim in blocks of s_block bodies on the pool,
+	 * after one untimed warm-up step
+	 */
+	template<typename Sim>
+	Result run(vector<Initial> const& init, size_t steps, Mesi::ThreadPool& pool)
+	{
+		Sim sim(init);
+		size_t const n = init.size();
+		size_t const blocks = (n + s_block - 1) / s_block;
+		auto step = [&] {
+			pool.run(blocks, [&](size_t b) { sim.computeForces(b * s_block, min(n, (b + 1) * s_block)); });
+			pool.run(blocks, [&](size_t b) { sim.integrate(b * s_block, min(n, (b + 1) * s_block)); });
+		};
+		step();
+		auto const start = chrono::steady_clock::now();
+		for(size_t s = 0; s < steps; s++)
+		{
+			step();
+		}
+		chrono::duration<double> const elapsed = chrono::steady_clock::now() - start;
+		return Result{ double(steps) / elapsed.count(), sim.checksum() };
+	}
+
+	bool s_mismatch = false;
+
+	template<template<typename> class Raw, template<typename> class Typed, typename T>
+	void compare(string const& layout, string const& type, vector<Initial> const& init, size_t steps, Mesi::ThreadPool& pool)
+	{
+		Result const raw = run<Raw<T>>(init, steps, pool);
+		Result const typed = run<Typed<T>>(init, steps, pool);
+		bool const match = abs(raw.checksum - typed.checksum) <= 1e-5 * abs(raw.checksum);
+		s_mismatch = s_mismatch || !match;
+		cout << left << setw(8) << layout << setw(8) << type << right
+			<< setw(8) << pool.threads()
+			<< fixed << setprecision(2)
+			<< setw(14) << raw.stepsPerSecond
+			<< setw(14) << typed.stepsPerSecond
+			<< setw(11) << showpos << (raw.stepsPerSecond / typed.stepsPerSecond - 1) * 100 << noshowpos << "%"
+			<< (match ? "" : "  results differ") << endl;
+	}
+
+	void runAll(vector<Initial> const& init, size_t steps, size_t threads)
+	{
+		Mesi::ThreadPool pool(threads);
+		compare<RawAos, MesiAos, float>("AoS", "float", init, steps, pool);
+		compare<RawSoa, MesiSoa, float>("SoA", "float", init, steps, pool);
+		compare<RawAos, MesiAos, double>("AoS", "double", init, steps, pool);
+		compare<RawSoa, MesiSoa, double>("SoA", "double", init, steps, pool);
+	}
+}
+
+int main(int argc, char** argv) {
+	size_t const bodies = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2048;
+	size_t const steps = argc > 2 ? strtoul(argv[2], nullptr, 10) : 10;
+	size_t const threads = argc > 3 ? strtoul(argv[3], nullptr, 10) : max(1u, thread::hardware_concurrency());
+
+	auto const init = makeBodies(bodies);
+	cout << "N-body, " << bodies << " bodies, " << steps << " steps" << endl;
+	cout << left << setw(8) << "layout" << setw(8) << "type" << right
+		<< setw(8) << "threads" << setw(14) << "raw steps/s" << setw(14) << "mesi steps/s" << setw(12) << "overhead" << endl;
+	runAll(init, steps, 1);
+	if(threads > 1)
+	{
+		runAll(init, steps, threads);
+	}
+	return s_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_calculus.h"
+#include "tee/tee.hpp"
+
+namespace {
+	bool close(float a, float b, float eps = 1e-4f)
+	{
+		return std::abs(a - b) < eps;
+	}
+}
+
+Tee_Test(test_calculus_types) {
+	Mesi::Seconds const* t = nullptr;
+	Mesi::Watts const* p = nullptr;
+	assert((std::is_same<decltype(Mesi::trapz(t, p, 0)), Mesi::Joules>::value));
+	assert((std::is_same<decltype(Mesi::simpson(Mesi::Seconds(1), p, 0)), Mesi::Joules>::value));
+	assert((std::is_same<decltype(Mesi::trapz(t, (Mesi::Joules const*)nullptr, 0)), decltype(Mesi::Joules{} * Mesi::Seconds{})>::value));
+}
+
+Tee_Test(test_calculus_uniform) {
+	// Power ramping linearly from 0 W to 100 W over 10 s, sampled every 0.5 s
+	std::size_t const n = 21;
+	auto const dt = Mesi::Seconds(0.5f);
+	std::vector<Mesi::Seconds> t;
+	std::vector<Mesi::Watts> p;
+	for(std::size_t i = 0; i < n; i++)
+	{
+		t.push_back(Mesi::Seconds(i * 0.5f));
+		p.push_back(Mesi::Watts(i * 5.f));
+	}
+
+	Tee_SubTest(test_trapz) {
+		assert(Mesi::trapz(dt, p.data(), n) == Mesi::Joules(500));
+		assert(Mesi::trapz(t.data(), p.data(), n) == Mesi::Joules(500));
+	}
+
+	Tee_SubTest(test_cumtrapz) {
+		std::vector<Mesi::Joules> e(n), e2(n);
+		Mesi::cumtrapz(dt, p.data(), n, e.data());
+		Mesi::cumtrapz(t.data(), p.data(), n, e2.data());
+		assert(e[0] == Mesi::Joules(0));
+		assert(e[10] == Mesi::Joules(125));
+		assert(e == e2);
+	}
+
+	Tee_SubTest(test_simpson_on_cubic) {
+		// x(t) = t^3 is integrated exactly by both variants of the rule
+		for(std::size_t m : {9, 10})
+		{
+			std::vector<Mesi::Meters> x;
+			for(std::size_t i = 0; i < m; i++)
+			{
+				x.push_back(Mesi::Meters(float(i * i * i)));
+			}
+			float const exact = std::pow(float(m - 1), 4.f) / 4;
+			assert(close(Mesi::simpson(Mesi::Seconds(1), x.data(), m).val, exact, 1e-3f));
+		}
+	}
+
+	Tee_SubTest(test_gradient) {
+		std::vector<decltype(Mesi::Watts{} / Mesi::Seconds{})> r(n), r2(n);
+		Mesi::gradient(dt, p.data(), n, r.data());
+		Mesi::gradient(t.data(), p.data(), n, r2.data());
+		for(std::size_t i = 0; i < n; i++)
+		{
+			assert(close(r[i].val, 10));
+			assert(close(r2[i].val, 10));
+		}
+	}
+
+	Tee_SubTest(test_spans) {
+		Mesi::Span<Mesi::Seconds> times(t.data(), n);
+		Mesi::Span<Mesi::Watts const> power(p.data(), n);
+		assert(Mesi::trapz(times, power) == Mesi::Joules(500));
+		assert(Mesi::trapz(dt, power) == Mesi::Joules(500));
+		assert(Mesi::simpson(times, power) == Mesi::simpson(t.data(), p.data(), n));
+		assert(Mesi::simpson(dt, power) == Mesi::simpson(dt, p.data(), n));
+
+		std::vector<Mesi::Joules> e(n), e2(n);
+		Mesi::cumtrapz(times, power, Mesi::Span<Mesi::Joules>(e.data(), n));
+		Mesi::cumtrapz(dt, power, Mesi::Span<Mesi::Joules>(e2.data(), n));
+		assert(e[10] == Mesi::Joules(125));
+		assert(e == e2);
+
+		std::vector<decltype(Mesi::Watts{} / Mesi::Seconds{})> r(n);
+		Mesi::gradient(dt, power, Mesi::Span<decltype(Mesi::Watts{} / Mesi::Seconds{})>(r.data(), n));
+		assert(close(r[3].val, 10));
+		Mesi::gradient(times, power, Mesi::Span<decltype(Mesi::Watts{} / Mesi::Seconds{})>(r.data(), n));
+		assert(close(r[3].val, 10));
+	}
+
+	Tee_SubTest(test_span_size_mismatch) {
+		bool threw = false;
+		try
+		{
+			Mesi::trapz(Mesi::Span<Mesi::Seconds>(t.data(), n), Mesi::Span<Mesi::Watts>(p.data(), n - 1));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
+
+Tee_Test(test_calculus_non_uniform) {
+	// x(t) = t^2 on uneven sample times
+	std::vector<Mesi::Seconds> t;
+	std::vector<Mesi::Meters> x;
+	for(float v : {0.f, 0.1f, 0.3f, 0.4f, 0.8f, 1.f, 1.5f, 2.f})
+	{
+		t.push_back(Mesi::Seconds(v));
+		x.push_back(Mesi::Meters(v * v));
+	}
+
+	Tee_SubTest(test_simpson_exact_on_quadratic) {
+		// The final trapezoid over [1.5, 2] overestimates by h^3 f'' / 12
+		float const expected = 8.f / 3 + 0.125f * 2 / 12;
+		assert(close(Mesi::simpson(t.data(), x.data(), t.size()).val, expected));
+		assert(close(Mesi::simpson(t.data(), x.data(), t.size() - 1).val, 1.5f * 1.5f * 1.5f / 3));
+	}
+
+	Tee_SubTest(test_gradient_exact_on_quadratic) {
+		std::vector<decltype(Mesi::Meters{} / Mesi::Seconds{})> v(t.size());
+		Mesi::gradient(t.data(), x.data(), t.size(), v.data());
+		for(std::size_t i = 1; i + 1 < t.size(); i++)
+		{
+			assert(close(v[i].val, 2 * t[i].val));
+		}
+	}
+}
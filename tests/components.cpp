@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../mesitype_components.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Velocity = decltype(Mesi::Meters{} / Mesi::Seconds{});
+
+	struct PositionName;
+	struct VelocityName;
+	using Position = Mesi::Component<PositionName, Mesi::Meters>;
+	using Speed = Mesi::Component<VelocityName, Velocity>;
+
+	using Pool = Mesi::ComponentPool<Position, Speed, Mesi::Kilograms, Mesi::Kelvin>;
+
+	bool aligned(void const* p)
+	{
+		return reinterpret_cast<std::uintptr_t>(p) % MESI_SIMD_ALIGNMENT == 0;
+	}
+}
+
+Tee_Test(test_component_pool) {
+	Tee_SubTest(test_handles) {
+		Pool pool;
+		auto const a = pool.create(Mesi::Meters(1), Velocity(10), Mesi::Kilograms(100), Mesi::Kelvin(300));
+		auto const b = pool.create(Mesi::Meters(2), Velocity(20), Mesi::Kilograms(200), Mesi::Kelvin(310));
+		auto const c = pool.create(Mesi::Meters(3), Velocity(30), Mesi::Kilograms(300), Mesi::Kelvin(320));
+		assert(pool.size() == 3);
+		static_assert(std::is_same<decltype(pool.get<Speed>(a)), Velocity&>::value, "Components have their value types");
+
+		// Destroying a moves c into its place, and c's handle follows it
+		pool.destroy(a);
+		assert(pool.size() == 2);
+		assert(!pool.alive(a) && pool.alive(b) && pool.alive(c));
+		assert(pool.index(c) == 0 && pool.entity(0) == c);
+		assert(pool.get<Position>(c) == Mesi::Meters(3));
+		assert(pool.get<Mesi::Kelvin>(c) == Mesi::Kelvin(320));
+		assert(pool.get<Mesi::Kilograms>(b) == Mesi::Kilograms(200));
+
+		// A reused slot does not revive the old handle
+		auto const d = pool.create();
+		assert(d.slot == a.slot && d != a);
+		assert(!pool.alive(a));
+		assert(pool.get<Position>(d) == Mesi::Meters(0));
+		bool threw = false;
+		try
+		{
+			pool.get<Position>(a);
+		}
+		catch(std::out_of_range const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+
+		// Destroying the last entity
+		pool.destroy(d);
+		assert(pool.size() == 2 && pool.alive(b) && pool.alive(c));
+
+		pool.clear();
+		assert(pool.empty() && !pool.alive(b) && !pool.alive(c));
+	}
+
+	Tee_SubTest(test_query) {
+		Pool pool;
+		pool.reserve(1000);
+		for(int i = 0; i < 1000; i++)
+		{
+			pool.create(Mesi::Meters(float(i)), Velocity(1), Mesi::Kilograms(1), Mesi::Kelvin(float(i)));
+		}
+		for(int i = 0; i < 1000; i += 3)
+		{
+			pool.destroy(pool.entity(std::size_t(i) / 3));
+		}
+
+		Mesi::Seconds const dt(0.5f);
+		pool.query<Speed, Position>([dt](Mesi::Span<Velocity> v, Mesi::Span<Mesi::Meters> x) {
+			assert(aligned(v.data()) && aligned(x.data()));
+			assert(v.size() == x.size());
+			for(std::size_t i = 0; i < x.size(); i++)
+			{
+				x[i] += v[i] * dt;
+			}
+		});
+
+		std::size_t chunks = 0;
+		std::size_t total = 0;
+		pool.query<Mesi::Kelvin>([&](Mesi::Span<Mesi::Kelvin> t) {
+			assert(aligned(t.data()) && t.size() <= 64);
+			chunks++;
+			total += t.size();
+		}, 64);
+		assert(total == pool.size() && chunks == (pool.size() + 63) / 64);
+
+		// Temperature was set equal to the initial position
+		auto const x = pool.span<Position>();
+		auto const t = pool.span<Mesi::Kelvin>();
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(x[i].val == t[i].val + 0.5f);
+		}
+		Pool const& constPool = pool;
+		static_assert(std::is_same<decltype(constPool.span<Mesi::Kelvin>()), Mesi::Span<Mesi::Kelvin const>>::value, "Spans of const pools are const");
+	}
+}
@@ -0,0 +1,52 @@
+#include <cmath>
+#include <type_traits>
+
+#include "../mesitype_constants.h"
+#include "tee/tee.hpp"
+
+namespace {
+	bool near(double a, double b)
+	{
+		return std::fabs(a - b) <= 1e-6 * std::fabs(b);
+	}
+}
+
+Tee_Test(test_constants) {
+	Tee_SubTest(test_dimensions) {
+		using Mesi::Constants::StandardGravity;
+		using Mesi::Constants::Boltzmann;
+		using Mesi::Constants::Gravitational;
+		static_assert(std::is_same<std::remove_const<decltype(StandardGravity)>::type, decltype(Mesi::Meters{} / Mesi::SecondsSq{})>::value, "g is an acceleration");
+		static_assert(std::is_same<std::remove_const<decltype(Boltzmann)>::type, decltype(Mesi::Joules{} / Mesi::Kelvin{})>::value, "k_B is energy per temperature");
+		static_assert(std::is_same<std::remove_const<decltype(Gravitational * Mesi::KilogramsSq{} / Mesi::MetersSq{})>::type, Mesi::Newtons>::value, "G m^2 / r^2 is a force");
+		static_assert(std::is_same<std::remove_const<decltype(Mesi::Constants::ElementaryCharge * Mesi::Constants::Avogadro)>::type, std::remove_const<decltype(Mesi::Constants::Faraday)>::type>::value, "F = e N_A");
+		static_assert(Mesi::Constants::SpeedOfLight.val == 299792458.0f, "Constants are constexpr");
+	}
+
+	Tee_SubTest(test_unit_forms) {
+		using namespace Mesi::Constants;
+		Mesi::Scalar::WithBaseType<double> const one(1);
+		assert(near(Mesi::Meters::WithBaseType<double>(one * Unit::StandardGravity * Mesi::SecondsSq(1)).val, StandardGravity.val));
+		assert(near(decltype(Mesi::Joules{} / Mesi::Kelvin{})::WithBaseType<double>(one * Unit::Boltzmann).val, Boltzmann.val));
+		assert(near(decltype(Mesi::Scalar{} / Mesi::Moles{})(Unit::Avogadro).val, Avogadro.val));
+		assert(near(decltype(Mesi::Joules{} / Mesi::Kelvin{} / Mesi::Moles{})(Unit::MolarGas).val, MolarGas.val));
+		assert(near(decltype(Mesi::Coulombs{} / Mesi::Moles{})(Unit::Faraday).val, Faraday.val));
+		assert(near(Mesi::Pascals(Unit::StandardAtmosphere).val, StandardAtmosphere.val));
+		assert(near(decltype(Mesi::Joules{} * Mesi::Seconds{})::WithBaseType<double>(one * Unit::Planck).val, Planck.val));
+		assert(near(Mesi::Coulombs::WithBaseType<double>(one * Unit::ElementaryCharge).val, ElementaryCharge.val));
+	}
+
+	Tee_SubTest(test_unit_arithmetic) {
+		using namespace Mesi::Constants;
+		// Multiplying by unit forms leaves the value alone and moves the
+		// constants into the Scale
+		Mesi::Kilograms::WithBaseType<double> const m(2);
+		auto const e = m * Unit::SpeedOfLight * Unit::SpeedOfLight;
+		assert(e.val == 2);
+		assert(Mesi::Joules::WithBaseType<double>(e).val == 2.0 * 299792458.0 * 299792458.0);
+
+		auto const d = Mesi::Seconds(3) * Unit::SpeedOfLight;
+		assert(d.val == 3);
+		assert(Mesi::Meters(d) == Mesi::Meters(3 * 299792458.0f));
+	}
+}
@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_events.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using DoubleSeconds = Mesi::Seconds::WithBaseType<double>;
+	using Nanoseconds = Mesi::Nano<Mesi::Seconds>::WithBaseType<std::int64_t>;
+	using Milliseconds = Mesi::Milli<Mesi::Seconds>::WithBaseType<std::int64_t>;
+}
+
+Tee_Test(test_events_conversion) {
+	Tee_SubTest(test_floating) {
+		assert(Mesi::_internal::toTime<DoubleSeconds>(Mesi::Minutes(2)) == DoubleSeconds(120));
+		assert(Mesi::_internal::toTime<DoubleSeconds>(Mesi::Hours(1)) == DoubleSeconds(3600));
+		assert(Mesi::_internal::toTime<DoubleSeconds>(Mesi::Milli<Mesi::Seconds>(250)) == DoubleSeconds(0.25));
+	}
+
+	Tee_SubTest(test_integral) {
+		assert(Mesi::_internal::toTime<Nanoseconds>(Milliseconds(3)) == Nanoseconds(3000000));
+		assert(Mesi::_internal::toTime<Nanoseconds>(Mesi::Seconds(1.5f)) == Nanoseconds(1500000000));
+		assert(Mesi::_internal::toTime<Nanoseconds>(Mesi::Minutes(1)) == Nanoseconds(60000000000));
+	}
+}
+
+Tee_Test(test_event_queue) {
+	Tee_SubTest(test_order) {
+		Mesi::EventQueue<int, DoubleSeconds> q;
+		q.push(Mesi::Seconds(3), 3);
+		q.push(Mesi::Milli<Mesi::Seconds>(500), 1);
+		q.push(Mesi::Minutes(1), 5);
+		q.push(Mesi::Seconds(2), 2);
+		q.push(Mesi::Hours(1), 6);
+		q.push(Mesi::Seconds(3), 4);
+		assert(q.size() == 6);
+		assert(q.nextTime() == DoubleSeconds(0.5));
+		for(int i = 1; i <= 6; i++)
+		{
+			auto const e = q.pop();
+			assert(e.payload == i);
+		}
+		assert(q.empty());
+	}
+
+	Tee_SubTest(test_many) {
+		// Pseudo-random times, checked against their sorted order while
+		// the queue grows, shrinks and re-estimates its bucket width
+		Mesi::EventQueue<std::uint32_t, Nanoseconds> q(Nanoseconds(1000));
+		std::uint32_t state = 1;
+		std::int64_t last = 0;
+		for(int round = 0; round < 4; round++)
+		{
+			for(int i = 0; i < 5000; i++)
+			{
+				state = state * 1664525u + 1013904223u;
+				q.push(Nanoseconds(last + (state >> 12)), state);
+			}
+			assert(q.buckets() > 16);
+			for(int i = 0; i < 4000; i++)
+			{
+				auto const e = q.pop();
+				assert(e.time.val >= last);
+				last = e.time.val;
+			}
+		}
+		while(!q.empty())
+		{
+			auto const e = q.pop();
+			assert(e.time.val >= last);
+			last = e.time.val;
+		}
+	}
+
+	Tee_SubTest(test_pop_until) {
+		Mesi::EventQueue<int, DoubleSeconds> q(DoubleSeconds(0.1));
+		for(int i = 0; i < 100; i++)
+		{
+			q.push(Mesi::Milli<Mesi::Seconds>(float((i * 37) % 100 * 10)), (i * 37) % 100);
+		}
+		std::vector<Mesi::EventQueue<int, DoubleSeconds>::Event> due;
+		assert(q.popUntil(Mesi::Milli<Mesi::Seconds>(250), due) == 25);
+		for(int i = 0; i < 25; i++)
+		{
+			assert(due[i].payload == i);
+		}
+		assert(q.popUntil(Mesi::Seconds(0.25f), due) == 0);
+		assert(q.popUntil(Mesi::Minutes(1), due) == 75);
+		for(int i = 0; i < 100; i++)
+		{
+			assert(due[i].payload == i);
+		}
+		assert(q.empty());
+
+		q.push(Mesi::Hours(2), 1);
+		assert(q.popUntil(Mesi::Hours(1), due) == 0);
+		assert(q.popUntil(Mesi::Hours(3), due) == 1);
+	}
+}
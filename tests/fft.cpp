@@ -0,0 +1,150 @@
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_fft.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Complex = std::complex<float>;
+	using ComplexMeters = Mesi::Meters::WithBaseType<Complex>;
+
+	std::vector<Mesi::Meters> samples(std::size_t n)
+	{
+		std::vector<Mesi::Meters> x;
+		for(std::size_t i = 0; i < n; i++)
+		{
+			x.push_back(Mesi::Meters(std::sin(0.3f * i) + 0.25f * std::cos(1.7f * i * i)));
+		}
+		return x;
+	}
+
+	// Reference DFT, scaled by dt like Mesi::fft
+	Complex dft(std::vector<Mesi::Meters> const& x, std::size_t k, float dt)
+	{
+		double re = 0, im = 0;
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			double const phase = -2 * 3.14159265358979323846 * double(k * i % x.size()) / x.size();
+			re += x[i].val * std::cos(phase);
+			im += x[i].val * std::sin(phase);
+		}
+		return Complex(float(re * dt), float(im * dt));
+	}
+
+	bool close(Complex a, Complex b)
+	{
+		return std::abs(a - b) < 1e-3f;
+	}
+}
+
+Tee_Test(test_fft_types) {
+	assert((std::is_same<Mesi::Spectrum<Mesi::Meters>, decltype(Mesi::Meters{} * Mesi::Seconds{})::WithBaseType<Complex>>::value));
+	assert((std::is_same<Mesi::PowerSpectrum<Mesi::Volts>, decltype(Mesi::Volts{} * Mesi::Volts{} / Mesi::Hertz{})>::value));
+	assert((std::is_same<decltype(Mesi::frequency(1, 8, Mesi::Seconds(1))), Mesi::Hertz>::value));
+}
+
+Tee_Test(test_fft_transforms) {
+	float const dt = 0.01f;
+
+	Tee_SubTest(test_complex_matches_dft) {
+		for(std::size_t n : {1, 2, 7, 8, 12, 30, 64})
+		{
+			auto const x = samples(n);
+			std::vector<ComplexMeters> in;
+			for(auto v : x)
+			{
+				in.push_back(ComplexMeters(Complex(v.val)));
+			}
+			std::vector<Mesi::Spectrum<Mesi::Meters>> out(n);
+			Mesi::fft(in.data(), n, Mesi::Seconds(dt), out.data());
+			for(std::size_t k = 0; k < n; k++)
+			{
+				assert(close(out[k].val, dft(x, k, dt)));
+			}
+		}
+	}
+
+	Tee_SubTest(test_real_matches_dft) {
+		for(std::size_t n : {2, 9, 16, 24, 50})
+		{
+			auto const x = samples(n);
+			std::vector<Mesi::Spectrum<Mesi::Meters>> out(n / 2 + 1);
+			Mesi::rfft(x.data(), n, Mesi::Seconds(dt), out.data());
+			for(std::size_t k = 0; k <= n / 2; k++)
+			{
+				assert(close(out[k].val, dft(x, k, dt)));
+			}
+		}
+	}
+
+	Tee_SubTest(test_held_plans) {
+		// 15 and 30 need the generic radix 3 and 5 butterflies
+		Mesi::FftPlan<float> plan(15);
+		Mesi::RealFftPlan<float> real(30);
+		for(int run = 0; run < 3; run++)
+		{
+			auto const x = samples(15 + run);
+			std::vector<ComplexMeters> in;
+			for(std::size_t i = 0; i < 15; i++)
+			{
+				in.push_back(ComplexMeters(Complex(x[i + run].val)));
+			}
+			std::vector<Mesi::Spectrum<Mesi::Meters>> out(15);
+			Mesi::fft(plan, in.data(), Mesi::Seconds(dt), out.data());
+			auto const window = std::vector<Mesi::Meters>(x.begin() + run, x.end());
+			for(std::size_t k = 0; k < 15; k++)
+			{
+				assert(close(out[k].val, dft(window, k, dt)));
+			}
+
+			auto const y = samples(30);
+			std::vector<Mesi::Spectrum<Mesi::Meters>> half(16);
+			Mesi::rfft(real, y.data(), Mesi::Seconds(dt), half.data());
+			for(std::size_t k = 0; k <= 15; k++)
+			{
+				assert(close(half[k].val, dft(y, k, dt)));
+			}
+		}
+	}
+
+	Tee_SubTest(test_inverse_round_trip) {
+		std::size_t const n = 20;
+		auto const x = samples(n);
+		std::vector<ComplexMeters> in, back(n);
+		for(auto v : x)
+		{
+			in.push_back(ComplexMeters(Complex(v.val, -v.val)));
+		}
+		std::vector<Mesi::Spectrum<Mesi::Meters>> spectrum(n);
+		Mesi::fft(in.data(), n, Mesi::Seconds(dt), spectrum.data());
+		Mesi::ifft(spectrum.data(), n, Mesi::Seconds(dt), back.data());
+		for(std::size_t i = 0; i < n; i++)
+		{
+			assert(close(back[i].val, in[i].val));
+		}
+	}
+
+	Tee_SubTest(test_power_spectrum_parseval) {
+		std::size_t const n = 32;
+		auto const x = samples(n);
+		std::vector<Mesi::Spectrum<Mesi::Meters>> spectrum(n / 2 + 1);
+		std::vector<Mesi::PowerSpectrum<Mesi::Meters>> psd(n / 2 + 1);
+		Mesi::rfft(x.data(), n, Mesi::Seconds(dt), spectrum.data());
+		Mesi::powerSpectrum(spectrum.data(), n / 2 + 1, n, Mesi::Seconds(dt), psd.data());
+
+		// Mean power equals the two-sided density integrated over all bins
+		float energy = 0, density = 0;
+		for(auto v : x)
+		{
+			energy += v.val * v.val / n;
+		}
+		for(std::size_t k = 0; k <= n / 2; k++)
+		{
+			density += (k == 0 || k == n / 2 ? 1 : 2) * psd[k].val;
+		}
+		density *= Mesi::frequency(1, n, Mesi::Seconds(dt)).val;
+		assert(std::abs(energy - density) < 1e-4f);
+	}
+}
@@ -0,0 +1,216 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "../mesitype_filter.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Acceleration = decltype(Mesi::Meters{} / Mesi::Seconds{} / Mesi::Seconds{});
+
+	std::vector<Mesi::Volts> signal(std::size_t n, float phase = 0)
+	{
+		std::vector<Mesi::Volts> x;
+		for(std::size_t i = 0; i < n; i++)
+		{
+			x.push_back(Mesi::Volts(std::sin(0.37f * i + phase) + 0.5f * std::cos(2.1f * i)));
+		}
+		return x;
+	}
+
+	std::vector<Mesi::Scalar> coefficients()
+	{
+		return {Mesi::Scalar(0.1f), Mesi::Scalar(0.2f), Mesi::Scalar(0.4f), Mesi::Scalar(0.2f), Mesi::Scalar(0.1f)};
+	}
+
+	bool close(float a, float b)
+	{
+		return std::abs(a - b) < 1e-5f;
+	}
+}
+
+Tee_Test(test_fir_filters) {
+	auto const x = signal(50);
+	auto const h = coefficients();
+
+	// Direct convolution, with zeros before the first sample
+	std::vector<Mesi::Volts> expected(x.size(), Mesi::Volts(0));
+	for(std::size_t i = 0; i < x.size(); i++)
+	{
+		for(std::size_t k = 0; k < h.size() && k <= i; k++)
+		{
+			expected[i] += h[k] * x[i - k];
+		}
+	}
+
+	Tee_SubTest(test_fir_matches_convolution_across_blocks) {
+		Mesi::FirFilter<Mesi::Volts> fir(h);
+		std::vector<Mesi::Volts> y(x.size());
+		fir.process(x.data(), y.data(), 13);
+		fir.process(x.data() + 13, y.data() + 13, 2);
+		fir.process(x.data() + 15, y.data() + 15, x.size() - 15);
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(close(y[i].val, expected[i].val));
+		}
+	}
+
+	Tee_SubTest(test_fir_channels_are_independent) {
+		auto const x2 = signal(x.size(), 1);
+		std::vector<Mesi::Volts> interleaved;
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			interleaved.push_back(x[i]);
+			interleaved.push_back(x2[i]);
+		}
+		Mesi::FirFilter<Mesi::Volts> stereo(h, 2), mono(h);
+		std::vector<Mesi::Volts> y(interleaved.size()), y2(x.size());
+		stereo.process(interleaved.data(), y.data(), x.size());
+		mono.process(x2.data(), y2.data(), x.size());
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(close(y[2 * i].val, expected[i].val));
+			assert(close(y[2 * i + 1].val, y2[i].val));
+		}
+	}
+
+	Tee_SubTest(test_decimator_keeps_every_nth_output) {
+		Mesi::FirDecimator<Mesi::Volts> decimator(h, 3);
+		std::vector<Mesi::Volts> y(x.size());
+		std::size_t n = decimator.process(x.data(), y.data(), 7);
+		n += decimator.process(x.data() + 7, y.data() + n, x.size() - 7);
+		assert(n == x.size() / 3);
+		for(std::size_t m = 0; m < n; m++)
+		{
+			assert(close(y[m].val, expected[3 * m + 2].val));
+		}
+	}
+
+	Tee_SubTest(test_spans) {
+		Mesi::FirFilter<Mesi::Volts> fir(h);
+		std::vector<Mesi::Volts> y(x.size());
+		fir.process(Mesi::Span<Mesi::Volts const>(x.data(), x.size()), Mesi::Span<Mesi::Volts>(y.data(), y.size()));
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(close(y[i].val, expected[i].val));
+		}
+
+		Mesi::FirDecimator<Mesi::Volts> decimator(h, 3);
+		std::size_t const n = decimator.process(Mesi::Span<Mesi::Volts const>(x.data(), x.size()), Mesi::Span<Mesi::Volts>(y.data(), x.size() / 3));
+		assert(n == x.size() / 3);
+		assert(close(y[4].val, expected[14].val));
+	}
+
+	Tee_SubTest(test_span_sizes) {
+		Mesi::FirFilter<Mesi::Volts> stereo(h, 2);
+		Mesi::FirDecimator<Mesi::Volts> decimator(h, 3);
+		std::vector<Mesi::Volts> y(x.size());
+		int threw = 0;
+		try
+		{
+			stereo.process(Mesi::Span<Mesi::Volts const>(x.data(), 4), Mesi::Span<Mesi::Volts>(y.data(), 6));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		try
+		{
+			stereo.process(Mesi::Span<Mesi::Volts const>(x.data(), 5), Mesi::Span<Mesi::Volts>(y.data(), 5));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		try
+		{
+			decimator.process(Mesi::Span<Mesi::Volts const>(x.data(), 9), Mesi::Span<Mesi::Volts>(y.data(), 2));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		assert(threw == 3);
+	}
+
+	Tee_SubTest(test_invalid_arguments) {
+		int threw = 0;
+		try
+		{
+			Mesi::FirFilter<Mesi::Volts> empty({});
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		try
+		{
+			Mesi::FirDecimator<Mesi::Volts> empty({}, 2);
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		try
+		{
+			Mesi::FirDecimator<Mesi::Volts> none(h, 0);
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw++;
+		}
+		assert(threw == 3);
+	}
+}
+
+Tee_Test(test_iir_filters) {
+	auto const cutoff = Mesi::Hertz(10);
+	auto const rate = Mesi::Hertz(1000);
+
+	Tee_SubTest(test_low_pass_passes_dc) {
+		auto lp = Mesi::Biquad<Acceleration>::lowPass(cutoff, rate);
+		std::vector<Acceleration> x(2000, Acceleration(9.81f)), y(x.size());
+		lp.process(x.data(), y.data(), x.size());
+		assert(std::abs(y.back().val - 9.81f) < 1e-3f);
+	}
+
+	Tee_SubTest(test_low_pass_attenuates_high_frequencies) {
+		auto lp = Mesi::Biquad<Mesi::Volts>::lowPass(cutoff, rate);
+		std::vector<Mesi::Volts> x, y(1000);
+		for(std::size_t i = 0; i < y.size(); i++)
+		{
+			x.push_back(Mesi::Volts(i % 2 ? 1.f : -1.f));
+		}
+		lp.process(x.data(), y.data(), x.size());
+		assert(std::abs(y.back().val) < 1e-3f);
+	}
+
+	Tee_SubTest(test_cascade_channels) {
+		auto section = Mesi::Biquad<Mesi::Volts>::lowPass(cutoff, rate, Mesi::Scalar(0.7071f), 2);
+		Mesi::BiquadCascade<Mesi::Volts> cascade({section, section});
+		auto single = Mesi::Biquad<Mesi::Volts>::lowPass(cutoff, rate);
+		auto const x = signal(64);
+		std::vector<Mesi::Volts> interleaved, y(2 * x.size()), once(x.size()), twice(x.size());
+		for(auto v : x)
+		{
+			interleaved.push_back(v);
+			interleaved.push_back(-v);
+		}
+		cascade.process(interleaved.data(), y.data(), x.size());
+		single.process(x.data(), once.data(), x.size());
+		single.reset();
+		single.process(once.data(), twice.data(), x.size());
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(close(y[2 * i].val, twice[i].val));
+			assert(close(y[2 * i + 1].val, -twice[i].val));
+		}
+
+		// The Span form continues from the same state
+		std::vector<Mesi::Volts> y2(y.size());
+		Mesi::BiquadCascade<Mesi::Volts> copy(cascade);
+		cascade.process(interleaved.data(), y.data(), x.size());
+		copy.process(Mesi::Span<Mesi::Volts const>(interleaved.data(), interleaved.size()), Mesi::Span<Mesi::Volts>(y2.data(), y2.size()));
+		assert(y == y2);
+	}
+}
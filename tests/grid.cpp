@@ -0,0 +1,134 @@
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../mesitype_grid.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Field = Mesi::Grid<Mesi::Kelvin, 2>;
+
+	bool close(float a, float b)
+	{
+		return std::abs(a - b) < 1e-2f;
+	}
+
+	// T(x, y) = x^2 + 3y with x = i * h, y = j * h
+	Field makeField(std::size_t n)
+	{
+		auto const h = Mesi::Meters(0.5f);
+		Field f({{n, n}}, h);
+		for(std::ptrdiff_t i = -1; i <= std::ptrdiff_t(n); i++)
+		{
+			for(std::ptrdiff_t j = -1; j <= std::ptrdiff_t(n); j++)
+			{
+				float const x = i * h.val, y = j * h.val;
+				f[{{i, j}}] = Mesi::Kelvin(x * x + 3 * y);
+			}
+		}
+		return f;
+	}
+}
+
+Tee_Test(test_grid_types) {
+	assert((std::is_same<Mesi::GradientGrid<Mesi::Kelvin, 2>::Value, decltype(Mesi::Kelvin{} / Mesi::Meters{})>::value));
+	assert((std::is_same<Mesi::LaplacianGrid<Mesi::Pascals, 3>::Value, decltype(Mesi::Pascals{} / Mesi::MetersSq{})>::value));
+}
+
+Tee_Test(test_grid_stencils) {
+	std::size_t const n = 37;
+	auto const f = makeField(n);
+
+	Tee_SubTest(test_gradient) {
+		Mesi::GradientGrid<Mesi::Kelvin, 2> gx(f.extent(), f.spacing()), gy(f.extent(), f.spacing());
+		Mesi::gradient(f, 0, gx);
+		Mesi::gradient(f, 1, gy);
+		assert(close(gx[{{4, 7}}].val, 2 * 4 * 0.5f));
+		assert(close(gy[{{4, 7}}].val, 3));
+		assert(close(gy[{{0, 0}}].val, 3));
+	}
+
+	Tee_SubTest(test_laplacian) {
+		Mesi::LaplacianGrid<Mesi::Kelvin, 2> l(f.extent(), f.spacing());
+		Mesi::laplacian(f, l);
+		for(std::ptrdiff_t i = 0; i < std::ptrdiff_t(n); i++)
+		{
+			for(std::ptrdiff_t j = 0; j < std::ptrdiff_t(n); j++)
+			{
+				assert(close(l[{{i, j}}].val, 2));
+			}
+		}
+	}
+
+	Tee_SubTest(test_threaded_sweep_matches_serial) {
+		Mesi::ThreadPool pool(4);
+		auto tiled = makeField(n);
+		tiled.setTileExtent({{5, 8}});
+		Mesi::LaplacianGrid<Mesi::Kelvin, 2> serial(f.extent(), f.spacing()), threaded(f.extent(), f.spacing());
+		Mesi::laplacian(f, serial);
+		for(int run = 0; run < 3; run++)
+		{
+			Mesi::laplacian(tiled, threaded, &pool);
+		}
+		for(std::ptrdiff_t i = 0; i < std::ptrdiff_t(n); i++)
+		{
+			for(std::ptrdiff_t j = 0; j < std::ptrdiff_t(n); j++)
+			{
+				assert((serial[{{i, j}}] == threaded[{{i, j}}]));
+			}
+		}
+	}
+
+	Tee_SubTest(test_zero_extent) {
+		bool threw = false;
+		try
+		{
+			Field empty({{4, 0}}, f.spacing());
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_mismatched_extent) {
+		Mesi::LaplacianGrid<Mesi::Kelvin, 2> small({{n, n - 1}}, f.spacing());
+		bool threw = false;
+		try
+		{
+			Mesi::laplacian(f, small);
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
+
+Tee_Test(test_grid_boundaries) {
+	Mesi::Grid<Mesi::Pascals, 1> g({{4}}, Mesi::Meters(1));
+	for(std::ptrdiff_t i = 0; i < 4; i++)
+	{
+		g[{{i}}] = Mesi::Pascals(float(i + 1));
+	}
+
+	Tee_SubTest(test_fill) {
+		g.fillHalo(Mesi::Pascals(0));
+		assert((g[{{-1}}] == Mesi::Pascals(0)));
+		assert((g[{{4}}] == Mesi::Pascals(0)));
+	}
+
+	Tee_SubTest(test_clamp) {
+		g.clampHalo();
+		assert((g[{{-1}}] == Mesi::Pascals(1)));
+		assert((g[{{4}}] == Mesi::Pascals(4)));
+	}
+
+	Tee_SubTest(test_wrap) {
+		g.wrapHalo();
+		assert((g[{{-1}}] == Mesi::Pascals(4)));
+		assert((g[{{4}}] == Mesi::Pascals(1)));
+	}
+}
@@ -0,0 +1,121 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../mesitype_instrument.h"
+#include "../mesitype.h"
+#include "tee/tee.hpp"
+
+namespace {
+	std::string nameA()
+	{
+		return " * 10^3 m";
+	}
+
+	std::string nameB()
+	{
+		return "m";
+	}
+
+	int s_hooked = 0;
+
+	void countingHook(Mesi::Instrument::Event, Mesi::Instrument::UnitName, Mesi::Instrument::UnitName, void const*)
+	{
+		s_hooked++;
+	}
+
+	void convertTwice()
+	{
+		for(int i = 0; i < 2; i++)
+		{
+			Mesi::_internal::instrumentEvent(Mesi::Instrument::Event::Conversion, &nameA, &nameB);
+		}
+	}
+}
+
+Tee_Test(test_instrument) {
+	Tee_SubTest(test_counts) {
+		Mesi::Instrument::reset();
+		convertTwice();
+		convertTwice();
+		std::thread t([] {
+			convertTwice();
+			Mesi::_internal::instrumentEvent(Mesi::Instrument::Event::Pow, &nameB, &nameA);
+		});
+		t.join();
+
+		auto const counts = Mesi::Instrument::counts();
+		assert(counts.size() == 2);
+		assert(counts[0].event == Mesi::Instrument::Event::Conversion);
+		assert(counts[0].count == 6);
+		assert(counts[0].from == nameA() && counts[0].to == nameB());
+		// One site in the source, but an unrolled loop reports several
+		assert(counts[0].sites >= 1);
+		assert(counts[1].event == Mesi::Instrument::Event::Pow && counts[1].count == 1);
+
+		std::ostringstream out;
+		Mesi::Instrument::dump(out);
+		assert(out.str().find("conversion    [* 10^3 m] -> [m]") != std::string::npos);
+
+		Mesi::Instrument::reset();
+		assert(Mesi::Instrument::counts().empty());
+	}
+
+	Tee_SubTest(test_sites) {
+		Mesi::Instrument::reset();
+		int sites[2];
+		for(int i = 0; i < 3; i++)
+		{
+			Mesi::Instrument::count(Mesi::Instrument::Event::Conversion, &nameA, &nameB, &sites[0]);
+		}
+		Mesi::Instrument::count(Mesi::Instrument::Event::Conversion, &nameA, &nameB, &sites[1]);
+
+		auto const counts = Mesi::Instrument::counts();
+		assert(counts.size() == 1);
+		assert(counts[0].count == 4);
+		assert(counts[0].sites == 2);
+		assert(counts[0].hottestSite == &sites[0]);
+		Mesi::Instrument::reset();
+	}
+
+	Tee_SubTest(test_hook) {
+		Mesi::Instrument::reset();
+		auto const previous = Mesi::Instrument::setHook(&countingHook);
+		convertTwice();
+		assert(s_hooked == 2);
+		Mesi::Instrument::setHook(nullptr);
+		convertTwice();
+		assert(s_hooked == 2);
+		Mesi::Instrument::setHook(previous);
+		assert(Mesi::Instrument::counts().empty());
+	}
+
+#ifdef MESI_INSTRUMENT
+	Tee_SubTest(test_operations) {
+		Mesi::Instrument::reset();
+		Mesi::Kilo<Mesi::Meters> const km(2);
+		std::vector<Mesi::Meters> m;
+		for(int i = 0; i < 3; i++)
+		{
+			m.push_back(Mesi::Meters(km));
+		}
+		auto const root = Mesi::pow<std::ratio<1, 2>>(km);
+		auto const m2 = Mesi::Meters::Pow<std::ratio<1, 2>>(root);
+		(void)m2;
+
+		auto const counts = Mesi::Instrument::counts();
+		assert(counts.size() == 4);
+		assert(counts[0].event == Mesi::Instrument::Event::Conversion);
+		assert(counts[0].count == 3);
+		assert(counts[0].from == Mesi::Kilo<Mesi::Meters>::getUnit());
+		assert(counts[0].to == Mesi::Meters::getUnit());
+		bool runtimeScale = false;
+		for(auto const& c : counts)
+		{
+			runtimeScale = runtimeScale || c.event == Mesi::Instrument::Event::RuntimePowerOfTen;
+		}
+		assert(runtimeScale);
+	}
+#endif
+}
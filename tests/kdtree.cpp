@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_kdtree.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Tree = Mesi::KdTree<Mesi::Meters, 4>;
+
+	std::vector<Tree::Point> randomPoints(std::size_t n)
+	{
+		std::uint32_t state = 12345;
+		auto next = [&state] {
+			state = state * 1664525u + 1013904223u;
+			return float(state >> 8) / float(1u << 24) * 10.f;
+		};
+		std::vector<Tree::Point> ret;
+		for(std::size_t i = 0; i < n; i++)
+		{
+			float const x = next();
+			float const y = next();
+			float const z = next();
+			ret.push_back(Tree::Point{ { Mesi::Meters(x), Mesi::Meters(y), Mesi::Meters(z) } });
+		}
+		return ret;
+	}
+
+	float distanceSq(Tree::Point const& a, Tree::Point const& b)
+	{
+		float ret = 0;
+		for(std::size_t d = 0; d < 3; d++)
+		{
+			float const diff = a[d].val - b[d].val;
+			ret += diff * diff;
+		}
+		return ret;
+	}
+
+	bool radiusMatches(Tree const& tree, std::vector<Tree::Point> const& points, Tree::Point const& q, float r)
+	{
+		std::vector<std::size_t> found;
+		tree.radius(q, Mesi::Meters(r), found);
+		std::sort(found.begin(), found.end());
+		std::vector<std::size_t> expected;
+		for(std::size_t i = 0; i < points.size(); i++)
+		{
+			if(distanceSq(points[i], q) <= r * r)
+			{
+				expected.push_back(i);
+			}
+		}
+		return found == expected;
+	}
+
+	bool nearestMatches(Tree const& tree, std::vector<Tree::Point> const& points, Tree::Point const& q, std::size_t k)
+	{
+		std::vector<Tree::Neighbour> found;
+		tree.nearest(q, k, found);
+		std::vector<float> expected;
+		for(auto const& p : points)
+		{
+			expected.push_back(distanceSq(p, q));
+		}
+		std::sort(expected.begin(), expected.end());
+		expected.resize(std::min(k, expected.size()));
+		if(found.size() != expected.size())
+		{
+			return false;
+		}
+		for(std::size_t i = 0; i < found.size(); i++)
+		{
+			if(found[i].distanceSq.val != expected[i] || distanceSq(points[found[i].index], q) != expected[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+Tee_Test(test_kdtree_types) {
+	assert((std::is_same<Tree::Area, Mesi::MetersSq>::value));
+	assert((std::is_same<decltype(Tree::Neighbour{}.distanceSq), Mesi::MetersSq>::value));
+}
+
+Tee_Test(test_kdtree_queries) {
+	auto const points = randomPoints(1000);
+	Tree const tree(points);
+	auto const queries = randomPoints(20);
+
+	Tee_SubTest(test_radius) {
+		assert(tree.size() == points.size());
+		for(auto const& q : queries)
+		{
+			assert(radiusMatches(tree, points, q, 0.5f));
+			assert(radiusMatches(tree, points, q, 2.f));
+		}
+		std::vector<std::size_t> all;
+		tree.radius(queries[0], Mesi::Meters(100), all);
+		assert(all.size() == points.size());
+	}
+
+	Tee_SubTest(test_nearest) {
+		for(auto const& q : queries)
+		{
+			assert(nearestMatches(tree, points, q, 1));
+			assert(nearestMatches(tree, points, q, 10));
+		}
+		assert(nearestMatches(tree, points, queries[0], 2000));
+	}
+
+	Tee_SubTest(test_parallel_build) {
+		Mesi::ThreadPool pool(4);
+		Tree const parallel(points, &pool);
+		for(auto const& q : queries)
+		{
+			assert(radiusMatches(parallel, points, q, 1.f));
+			assert(nearestMatches(parallel, points, q, 5));
+		}
+	}
+
+	Tee_SubTest(test_small) {
+		Tree const empty(nullptr, 0);
+		std::vector<Tree::Neighbour> found;
+		empty.nearest(queries[0], 3, found);
+		assert(found.empty());
+
+		std::vector<Tree::Point> three(points.begin(), points.begin() + 3);
+		Tree const small(three);
+		assert(nearestMatches(small, three, queries[0], 5));
+		assert(radiusMatches(small, three, queries[0], 5.f));
+	}
+}
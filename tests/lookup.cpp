@@ -0,0 +1,185 @@
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_lookup.h"
+#include "tee/tee.hpp"
+
+namespace {
+	bool close(float a, float b, float eps = 1e-4f)
+	{
+		return std::abs(a - b) < eps;
+	}
+
+	struct Square
+	{
+		constexpr Mesi::Volts operator()(Mesi::Kelvin k) const
+		{
+			return Mesi::Volts(k.val * k.val);
+		}
+	};
+
+	// Thermocouple-style calibration curve, built at compile time
+	constexpr auto s_linear = Mesi::LookupTable<Mesi::Kelvin, Mesi::Volts, 5>::uniform(
+		Mesi::Kelvin(0), Mesi::Kelvin(4),
+		{ Mesi::Volts(0), Mesi::Volts(1), Mesi::Volts(4), Mesi::Volts(9), Mesi::Volts(16) });
+	static_assert(s_linear(Mesi::Kelvin(1.5f)).val == 2.5f, "Linear lookups are constexpr");
+	static_assert(s_linear(Mesi::Kelvin(-1)).val == 0.f, "Inputs below the table are clamped");
+
+	constexpr auto s_cubic = Mesi::LookupTable<Mesi::Kelvin, Mesi::Volts, 5, Mesi::Interpolation::Cubic>::generate(
+		Mesi::Kelvin(0), Mesi::Kelvin(4), Square());
+	static_assert(s_cubic.value(3).val == 9.f, "Generated tables are constexpr");
+
+	struct Millimeters
+	{
+		constexpr Mesi::Meters operator()(std::size_t i) const
+		{
+			return Mesi::Meters(Mesi::Milli<Mesi::Meters>(float(i)));
+		}
+	};
+
+	/**
+	 * Factor from prefix 10^(3 i) to prefix 10^(3 j)
+	 */
+	struct PrefixFactor
+	{
+		constexpr double operator()(std::size_t i, std::size_t j) const
+		{
+			double ret = 1;
+			for(std::size_t k = j; k < i; k++)
+			{
+				ret *= 1000;
+			}
+			for(std::size_t k = i; k < j; k++)
+			{
+				ret /= 1000;
+			}
+			return ret;
+		}
+	};
+
+	constexpr auto s_millimeters = Mesi::make_table<16>(Millimeters());
+	static_assert(s_millimeters[5] == Mesi::Meters(Mesi::Milli<Mesi::Meters>(5.f)) && s_millimeters[5] > Mesi::Meters(0.0049f), "Tables are built at compile time");
+	constexpr auto s_prefixes = Mesi::make_table<4, 4>(PrefixFactor());
+	static_assert(s_prefixes[3][1] == 1e6 && s_prefixes[0][2] == 1e-6, "Two-dimensional tables are built at compile time");
+}
+
+Tee_Test(test_lookup_types) {
+	using Table = Mesi::LookupTable<Mesi::Kelvin, Mesi::Volts, 5>;
+	assert((std::is_same<decltype(s_linear(Mesi::Kelvin(1))), Mesi::Volts>::value));
+	assert((std::is_same<Table::Slope, decltype(Mesi::Volts{} / Mesi::Kelvin{})>::value));
+	assert(Table::Size == 5);
+}
+
+Tee_Test(test_lookup_uniform) {
+	Tee_SubTest(test_linear) {
+		assert(s_linear(Mesi::Kelvin(0)) == Mesi::Volts(0));
+		assert(s_linear(Mesi::Kelvin(2)) == Mesi::Volts(4));
+		assert(s_linear(Mesi::Kelvin(3.5f)) == Mesi::Volts(12.5f));
+		assert(s_linear(Mesi::Kelvin(4)) == Mesi::Volts(16));
+		assert(s_linear(Mesi::Kelvin(10)) == Mesi::Volts(16));
+	}
+
+	Tee_SubTest(test_cubic) {
+		// The slopes come from parabolas, so a quadratic is reproduced exactly
+		for(int i = 0; i <= 40; i++)
+		{
+			float const x = i * 0.1f;
+			assert(close(s_cubic(Mesi::Kelvin(x)).val, x * x));
+		}
+		assert(close(s_cubic.slope(0).val, 0.f));
+		assert(close(s_cubic.slope(4).val, 8.f));
+	}
+
+	Tee_SubTest(test_batch) {
+		std::vector<Mesi::Kelvin> in;
+		for(int i = -5; i < 50; i++)
+		{
+			in.push_back(Mesi::Kelvin(i * 0.1f));
+		}
+		std::vector<Mesi::Volts> out(in.size());
+		s_linear.eval(in.data(), out.data(), in.size());
+		for(std::size_t i = 0; i < in.size(); i++)
+		{
+			assert(out[i] == s_linear(in[i]));
+		}
+		s_cubic.eval(in.data(), out.data(), in.size());
+		for(std::size_t i = 0; i < in.size(); i++)
+		{
+			assert(out[i] == s_cubic(in[i]));
+		}
+	}
+}
+
+Tee_Test(test_lookup_non_uniform) {
+	auto const table = Mesi::LookupTable<Mesi::Seconds, Mesi::Meters, 4>::nonUniform(
+		{ Mesi::Seconds(0), Mesi::Seconds(1), Mesi::Seconds(3), Mesi::Seconds(7) },
+		{ Mesi::Meters(0), Mesi::Meters(2), Mesi::Meters(4), Mesi::Meters(0) });
+
+	Tee_SubTest(test_linear) {
+		assert(table(Mesi::Seconds(0.5f)) == Mesi::Meters(1));
+		assert(table(Mesi::Seconds(2)) == Mesi::Meters(3));
+		assert(table(Mesi::Seconds(5)) == Mesi::Meters(2));
+		assert(table(Mesi::Seconds(7)) == Mesi::Meters(0));
+		assert(table(Mesi::Seconds(-1)) == Mesi::Meters(0));
+	}
+
+	Tee_SubTest(test_batch) {
+		Mesi::Seconds const in[] = { Mesi::Seconds(6), Mesi::Seconds(1), Mesi::Seconds(9), Mesi::Seconds(0.25f) };
+		Mesi::Meters out[4];
+		table.eval(in, out, 4);
+		for(std::size_t i = 0; i < 4; i++)
+		{
+			assert(out[i] == table(in[i]));
+		}
+
+		Mesi::Meters spanOut[4];
+		table.eval(Mesi::Span<Mesi::Seconds const>(in), Mesi::Span<Mesi::Meters>(spanOut));
+		for(std::size_t i = 0; i < 4; i++)
+		{
+			assert(spanOut[i] == out[i]);
+		}
+
+		bool threw = false;
+		try
+		{
+			table.eval(Mesi::Span<Mesi::Seconds const>(in), Mesi::Span<Mesi::Meters>(spanOut, 3));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_cubic) {
+		auto const quadratic = Mesi::LookupTable<Mesi::Seconds, Mesi::Meters, 4, Mesi::Interpolation::Cubic>::nonUniform(
+			{ Mesi::Seconds(0), Mesi::Seconds(1), Mesi::Seconds(3), Mesi::Seconds(7) },
+			{ Mesi::Meters(0), Mesi::Meters(1), Mesi::Meters(9), Mesi::Meters(49) });
+		for(int i = 0; i <= 70; i++)
+		{
+			float const x = i * 0.1f;
+			assert(close(quadratic(Mesi::Seconds(x)).val, x * x, 1e-3f));
+		}
+	}
+}
+
+Tee_Test(test_lookup_make_table) {
+	Tee_SubTest(test_types) {
+		assert((std::is_same<decltype(s_millimeters), std::array<Mesi::Meters, 16> const>::value));
+		assert((std::is_same<decltype(s_prefixes), std::array<std::array<double, 4>, 4> const>::value));
+	}
+
+	Tee_SubTest(test_runtime) {
+		// Generators that are not constexpr give tables at run time
+		float scale = 2;
+		auto const doubled = Mesi::make_table<8>([scale](std::size_t i) { return Mesi::Seconds(scale * float(i)); });
+		for(std::size_t i = 0; i < doubled.size(); i++)
+		{
+			assert(doubled[i] == Mesi::Seconds(2 * float(i)));
+			assert(s_millimeters[i] == Mesi::Meters(Mesi::Milli<Mesi::Meters>(float(i))));
+		}
+	}
+}
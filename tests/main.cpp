@@ -229,6 +229,11 @@ Tee_Test(test_assignment_operators) {
 		assert(m.val == 2);
 	}
 
+	Tee_SubTest(test_copies_are_trivial) {
+		static_assert(std::is_trivially_copyable<Mesi::Meters>::value, "Mesi types copy like their storage type");
+		static_assert(std::is_trivially_copy_constructible<Mesi::Newtons>::value, "Mesi types copy like their storage type");
+	}
+
 	Tee_SubTest(test_add_assignment) {
 		m += Mesi::Meters(1);
 		assert(m.val == 3);
@@ -328,6 +333,21 @@ Tee_Test(test_conversions) {
 	Tee_SubTest(test_divisions) {
 		assert(Meters(Meters::Divide<5>(5)) == Meters(1));
 	}
+
+	Tee_SubTest(test_constant_conversions) {
+		static_assert(float(Meters(Kilometers(1.5f))) == 1500.f, "Scaled conversions are constexpr");
+
+		// Including those whose factor is a root, which match the one
+		// computed at run time
+		using RootKilometers = Kilometers::WithBaseType<double>::Pow<std::ratio<1, 2>>;
+		using RootMeters = Meters::WithBaseType<double>::Pow<std::ratio<1, 2>>;
+		constexpr double rootThousand = double(RootMeters(RootKilometers(1)));
+		static_assert(rootThousand > 31.6227766016837 && rootThousand < 31.6227766016838, "Roots of scales are constexpr");
+		RootKilometers volatile one(1);
+		double const root = double(RootMeters(RootKilometers(one.val)));
+		assert(std::abs(root - rootThousand) <= 1e-15 * root);
+		assert(std::abs(rootThousand - std::sqrt(1000.0)) <= 1e-15 * rootThousand);
+	}
 }
 
 Tee_Test(test_prefixes) {
@@ -383,6 +403,17 @@ Tee_Test(test_unit_scaling) {
 		using S6 = ScaleMultiply<Scale<Two,     2, OneHalf >, Scale<One,     1, Zero   >>::Scale;
 		assert(S6::value<float>() == std::pow(20.f, 0.5f));
 	}
+
+	Tee_SubTest(test_constant_scale_factors) {
+		static_assert(ScaleIsConstant<Scale<Two, 1, std::ratio<-9>>>::value, "Rational scales are constant");
+		static_assert(!ScaleIsConstant<Scale<One, 1, OneHalf>>::value, "Fractional powers of ten are not constant");
+		static_assert(!ScaleIsConstant<Scale<Two, 2, Zero>>::value, "Roots are not constant");
+
+		// Negative powers of ten are the reciprocals of exact positive ones
+		static_assert(ScaleFactor<Scale<One, 1, std::ratio<-9>>, double>::value() == 1e-9, "10^-9 is correctly rounded");
+		static_assert(ScaleFactor<Scale<One, 1, std::ratio<-22>>, double>::value() == 1e-22, "10^-22 is correctly rounded");
+		static_assert(ScaleFactor<Scale<One, 1, std::ratio<-42>>, float>::value() > 0, "10^-42 does not overflow in float");
+	}
 	Tee_SubTest(test_unit_scaling_maths) {
 		assert((std::is_same<Scalar::Multiply<2>::Multiply<3>, Scalar::Multiply<6>>::value));
 		assert((std::is_same<Scalar::Multiply<2>::Divide<2>, Scalar>::value));
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <type_traits>
+
+#include "../mesitype_matrix.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Speed = decltype(Mesi::Meters{} / Mesi::Seconds{});
+	using State = Mesi::UnitList<Mesi::Meters, Speed>;
+	using Covariance = Mesi::Matrix<State, Mesi::_internal::InvertUnits<State>::List>;
+	using Transition = Mesi::Matrix<State, State>;
+
+	bool close(float a, float b)
+	{
+		return std::abs(a - b) < 1e-4f;
+	}
+}
+
+Tee_Test(test_matrix_units) {
+	Tee_SubTest(test_element_types) {
+		assert((std::is_same<Covariance::Element<0, 0>, Mesi::MetersSq>::value));
+		assert((std::is_same<Transition::Element<0, 1>, Mesi::Seconds>::value));
+		assert((std::is_same<Transition::Element<1, 1>, Mesi::Scalar>::value));
+	}
+
+	Tee_SubTest(test_derived_types) {
+		assert((std::is_same<Covariance::Transposed, Covariance>::value));
+		assert((std::is_same<Transition::Inverse, Transition>::value));
+		assert((std::is_same<Covariance::CholeskyFactor::Element<1, 0>, Speed>::value));
+	}
+
+	Tee_SubTest(test_storage_is_padded) {
+		assert(Transition::Stride * sizeof(float) % MESI_SIMD_ALIGNMENT == 0);
+		assert(sizeof(Transition) == Transition::RowCount * Transition::Stride * sizeof(float));
+	}
+}
+
+Tee_Test(test_matrix_kernels) {
+	auto F = Transition::Identity();
+	F.set<0, 1>(Mesi::Seconds(2));
+
+	auto P = Covariance();
+	P.set<0, 0>(Mesi::MetersSq(4));
+	P.set<0, 1>(Mesi::MetersSq(2) / Mesi::Seconds(1));
+	P.set<1, 0>(Mesi::MetersSq(2) / Mesi::Seconds(1));
+	P.set<1, 1>(Speed(1) * Speed(5));
+
+	Tee_SubTest(test_product) {
+		auto FP = F * P;
+		assert((std::is_same<decltype(FP), Covariance>::value));
+		assert((FP.get<0, 0>() == Mesi::MetersSq(8)));
+		assert((FP.get<1, 1>() == Speed(1) * Speed(5)));
+	}
+
+	Tee_SubTest(test_inverse) {
+		auto I = F * F.inverse();
+		assert(close(I.raw(0, 0), 1) && close(I.raw(0, 1), 0));
+		assert(close(I.raw(1, 0), 0) && close(I.raw(1, 1), 1));
+	}
+
+	Tee_SubTest(test_cholesky) {
+		auto L = P.cholesky();
+		auto LLt = L * L.transpose();
+		assert((std::is_same<decltype(LLt), Covariance>::value));
+		assert(close(LLt.raw(0, 0), 4) && close(LLt.raw(0, 1), 2));
+		assert(close(LLt.raw(1, 0), 2) && close(LLt.raw(1, 1), 5));
+		assert(L.raw(0, 1) == 0);
+	}
+
+	Tee_SubTest(test_scaled_units) {
+		using Mixed = Mesi::Matrix<Mesi::UnitList<Mesi::Kilo<Mesi::Meters>, Mesi::Meters>, Mesi::UnitList<Mesi::Kilo<Mesi::Meters>, Mesi::Meters>>;
+		assert((std::is_same<Mixed::Element<0, 1>, Mesi::Kilo<Mesi::Scalar>>::value));
+
+		auto A = Mixed::Identity();
+		A.set<0, 1>(Mesi::Kilo<Mesi::Scalar>(0.5f));
+		A.set<1, 0>(Mesi::Milli<Mesi::Scalar>(3));
+		auto I = A * A.inverse();
+		assert(close(I.raw(0, 0), 1) && close(I.raw(0, 1), 0));
+		assert(close(I.raw(1, 0), 0) && close(I.raw(1, 1), 1));
+	}
+}
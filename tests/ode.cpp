@@ -0,0 +1,156 @@
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+#include "../mesitype_ode.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Speed = decltype(Mesi::Meters{} / Mesi::Seconds{});
+	using Acceleration = decltype(Speed{} / Mesi::Seconds{});
+	using Oscillator = std::tuple<Mesi::Meters, Speed>;
+
+	// x'' = -x, so the period is 2 pi seconds
+	auto oscillator = [](Mesi::Seconds, Oscillator const& y) {
+		return std::make_tuple(std::get<1>(y), Mesi::Hertz(1) * Mesi::Hertz(1) * -std::get<0>(y));
+	};
+
+	bool close(float a, float b, float eps)
+	{
+		return std::abs(a - b) < eps;
+	}
+}
+
+Tee_Test(test_ode_types) {
+	assert((std::is_same<Mesi::Derivative<Oscillator>, std::tuple<Speed, Acceleration>>::value));
+	assert((std::is_same<Mesi::Derivative<std::tuple<Mesi::Joules>>, std::tuple<Mesi::Watts>>::value));
+}
+
+Tee_Test(test_ode_steppers) {
+	float const pi = 3.14159265f;
+
+	Tee_SubTest(test_rk4_period) {
+		auto y = Oscillator(Mesi::Meters(1), Speed(0));
+		auto const dt = Mesi::Seconds(2 * pi / 200);
+		for(int i = 0; i < 200; i++)
+		{
+			y = Mesi::rk4Step(oscillator, Mesi::Seconds(i * dt.val), y, dt);
+		}
+		assert(close(std::get<0>(y).val, 1, 1e-4f));
+		assert(close(std::get<1>(y).val, 0, 1e-4f));
+	}
+
+	Tee_SubTest(test_rk45_decay) {
+		auto decay = [](Mesi::Seconds, std::tuple<Mesi::Kelvin> const& y) {
+			return std::make_tuple(std::get<0>(y) * -Mesi::Hertz(1));
+		};
+		auto dt = Mesi::Seconds(0.1f);
+		auto y = Mesi::rk45Integrate(decay, Mesi::Seconds(0), Mesi::Seconds(2), std::make_tuple(Mesi::Kelvin(300)),
+			dt, std::make_tuple(Mesi::Kelvin(1e-3f)), 1e-5f);
+		assert(close(std::get<0>(y).val, 300 * std::exp(-2.f), 1e-2f));
+	}
+
+	Tee_SubTest(test_rk45_rejects_large_steps) {
+		auto step = Mesi::rk45Step(oscillator, Mesi::Seconds(0), Oscillator(Mesi::Meters(1), Speed(0)), Mesi::Seconds(3),
+			Oscillator(Mesi::Meters(1e-6f), Speed(1e-6f)), 1e-6f);
+		assert(!step.accepted);
+		assert(step.dt < Mesi::Seconds(3));
+	}
+
+	Tee_SubTest(test_rk45_nan_error) {
+		auto nan = [](Mesi::Seconds, std::tuple<Mesi::Kelvin> const& y) {
+			return std::make_tuple(std::get<0>(y) * Mesi::Hertz(std::nanf("")));
+		};
+		auto dt = Mesi::Seconds(0.1f);
+		bool threw = false;
+		try
+		{
+			Mesi::rk45Integrate(nan, Mesi::Seconds(0), Mesi::Seconds(1), std::make_tuple(Mesi::Kelvin(300)),
+				dt, std::make_tuple(Mesi::Kelvin(1e-3f)), 1e-5f);
+		}
+		catch(std::domain_error const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_rk45_step_below_resolution) {
+		// Float times around 1e7 s are 1 s apart, far coarser than the
+		// steps this tolerance needs
+		auto dt = Mesi::Seconds(1);
+		bool threw = false;
+		try
+		{
+			Mesi::rk45Integrate(oscillator, Mesi::Seconds(1e7f), Mesi::Seconds(1e7f + 16), Oscillator(Mesi::Meters(1), Speed(0)),
+				dt, Oscillator(Mesi::Meters(1e-12f), Speed(1e-12f)), 0.f);
+		}
+		catch(std::underflow_error const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_semi_implicit_euler) {
+		auto gravity = [](Mesi::Seconds, std::tuple<Mesi::Meters> const&, std::tuple<Speed> const&) {
+			return std::make_tuple(Acceleration(-10));
+		};
+		auto x = std::make_tuple(Mesi::Meters(0));
+		auto v = std::make_tuple(Speed(10));
+		Mesi::semiImplicitEulerStep(gravity, Mesi::Seconds(0), x, v, Mesi::Seconds(0.5f));
+		assert(std::get<0>(v) == Speed(5));
+		assert(std::get<0>(x) == Mesi::Meters(2.5f));
+	}
+}
+
+Tee_Test(test_ode_batches) {
+	Mesi::StateBatch<Oscillator> batch(37);
+	for(std::size_t i = 0; i < batch.size(); i++)
+	{
+		batch.lane<0>()[i] = Mesi::Meters(float(i));
+		batch.lane<1>()[i] = Speed(1);
+	}
+	auto const dt = Mesi::Seconds(0.01f);
+
+	Tee_SubTest(test_batched_rk4_matches_single) {
+		Mesi::rk4Step(oscillator, Mesi::Seconds(0), batch, dt);
+		for(std::size_t i = 0; i < batch.size(); i++)
+		{
+			auto expected = Mesi::rk4Step(oscillator, Mesi::Seconds(0), Oscillator(Mesi::Meters(float(i)), Speed(1)), dt);
+			assert(batch.get(i) == expected);
+		}
+	}
+
+	Tee_SubTest(test_batched_semi_implicit_euler) {
+		Mesi::StateBatch<std::tuple<Mesi::Meters>> x(4);
+		Mesi::StateBatch<std::tuple<Speed>> v(4);
+		for(std::size_t i = 0; i < 4; i++)
+		{
+			v.lane<0>()[i] = Speed(float(i));
+		}
+		Mesi::semiImplicitEulerStep([](Mesi::Seconds, std::tuple<Mesi::Meters> const&, std::tuple<Speed> const&) {
+			return std::make_tuple(Acceleration(2));
+		}, Mesi::Seconds(0), x, v, Mesi::Seconds(1));
+		assert(v.lane<0>()[3] == Speed(5));
+		assert(x.lane<0>()[3] == Mesi::Meters(5));
+	}
+
+	Tee_SubTest(test_batch_size_mismatch) {
+		Mesi::StateBatch<std::tuple<Mesi::Meters>> x(4);
+		Mesi::StateBatch<std::tuple<Speed>> v(3);
+		bool threw = false;
+		try
+		{
+			Mesi::semiImplicitEulerStep([](Mesi::Seconds, std::tuple<Mesi::Meters> const&, std::tuple<Speed> const&) {
+				return std::make_tuple(Acceleration(2));
+			}, Mesi::Seconds(0), x, v, Mesi::Seconds(1));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
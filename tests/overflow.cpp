@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_overflow.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Sat32 = Mesi::Saturating<std::int32_t>;
+	using Checked32 = Mesi::Checked<std::int32_t>;
+	using Millivolts = Mesi::Milli<Mesi::Volts>::WithBaseType<Sat32>;
+	using Volts = Mesi::Volts::WithBaseType<Sat32>;
+	using Millimeters = Mesi::Milli<Mesi::Meters>::WithBaseType<Checked32>;
+	using Meters = Mesi::Meters::WithBaseType<Checked32>;
+
+	constexpr std::int32_t s_max = std::numeric_limits<std::int32_t>::max();
+	constexpr std::int32_t s_min = std::numeric_limits<std::int32_t>::min();
+
+	static_assert((Sat32(s_max) + Sat32(1)).value() == s_max, "Saturating arithmetic is constexpr");
+	static_assert((Checked32(s_max) + Checked32(1)).overflowed(), "Checked arithmetic is constexpr");
+	static_assert(std::is_trivially_copyable<Millivolts>::value, "Adaptors keep quantities trivially copyable");
+}
+
+Tee_Test(test_overflow_saturating) {
+	Tee_SubTest(test_arithmetic) {
+		assert((Sat32(s_max) + Sat32(1)).value() == s_max);
+		assert((Sat32(s_min) - Sat32(1)).value() == s_min);
+		assert((Sat32(s_min) + Sat32(-1)).value() == s_min);
+		assert((Sat32(5) + Sat32(-7)).value() == -2);
+		assert((Sat32(1 << 20) * Sat32(1 << 20)).value() == s_max);
+		assert((Sat32(1 << 20) * Sat32(-(1 << 20))).value() == s_min);
+		assert((Sat32(-46341) * Sat32(-46341)).value() == s_max);
+		assert((Sat32(s_min) / Sat32(-1)).value() == s_max);
+		assert((-Sat32(s_min)).value() == s_max);
+		assert(Sat32(std::int64_t(1) << 40).value() == s_max);
+
+		using Sat64 = Mesi::Saturating<std::int64_t>;
+		assert((Sat64(std::int64_t(1) << 40) * Sat64(std::int64_t(1) << 40)).value() == std::numeric_limits<std::int64_t>::max());
+		assert((Sat64(3) * Sat64(-4)).value() == -12);
+
+		using SatU8 = Mesi::Saturating<std::uint8_t>;
+		assert((SatU8(250) + SatU8(10)).value() == 255);
+		assert((SatU8(5) - SatU8(10)).value() == 0);
+		assert((SatU8(16) * SatU8(16)).value() == 255);
+		assert(SatU8(-3).value() == 0);
+
+		using Sat16 = Mesi::Saturating<std::int16_t>;
+		assert((Sat16(30000) + Sat16(30000)).value() == 32767);
+		assert((Sat16(-30000) - Sat16(30000)).value() == -32768);
+	}
+
+	Tee_SubTest(test_quantities) {
+		Millivolts const a(2000000000);
+		Millivolts const b(2000000000);
+		auto const sum = a + b;
+		static_assert(std::is_same<decltype(sum), Millivolts const>::value, "Sums keep the storage type");
+		assert(sum.val == Sat32(s_max));
+		assert((a * 3).val == Sat32(s_max));
+		assert((-a - b).val == Sat32(s_min));
+
+		auto const power = a * Mesi::Milli<Mesi::Amperes>::WithBaseType<Sat32>(2);
+		static_assert(std::is_same<decltype(power)::BaseType, Sat32>::value, "Products keep the storage type");
+		assert(power.val == Sat32(s_max));
+
+		// Converting to a finer scale saturates
+		assert(Millivolts(Volts(3000000)).val == Sat32(s_max));
+		assert(Millivolts(Volts(-3)).val == Sat32(-3000));
+
+		std::vector<Millivolts> v(1000, Millivolts(s_max - 10));
+		for(auto& x : v)
+		{
+			x += Millivolts(100);
+		}
+		assert(v[999].val == Sat32(s_max));
+	}
+}
+
+Tee_Test(test_overflow_checked) {
+	Tee_SubTest(test_arithmetic) {
+		Checked32 const big(s_max);
+		assert(!big.overflowed());
+		Checked32 const wrapped = big + Checked32(1);
+		assert(wrapped.overflowed() && wrapped.value() == s_min);
+
+		// The flag is sticky
+		assert((wrapped - Checked32(1)).overflowed());
+		assert((Checked32(2) * (wrapped * Checked32(0))).overflowed());
+		assert(!(Checked32(2) * Checked32(3)).overflowed());
+
+		assert((Checked32(1 << 16) * Checked32(1 << 15)).overflowed());
+		assert(!(Checked32(1 << 15) * Checked32(1 << 15)).overflowed());
+		assert((Checked32(s_min) / Checked32(-1)).overflowed());
+		assert((-Checked32(s_min)).overflowed());
+		assert(Checked32(std::uint32_t(1) << 31).overflowed());
+		assert(!Checked32(-5).overflowed());
+
+		using Checked64 = Mesi::Checked<std::int64_t>;
+		assert((Checked64(std::int64_t(1) << 32) * Checked64(std::int64_t(1) << 31)).overflowed());
+		assert(!(Checked64(std::int64_t(1) << 31) * Checked64(std::int64_t(1) << 31)).overflowed());
+
+		using CheckedU16 = Mesi::Checked<std::uint16_t>;
+		assert((CheckedU16(3) - CheckedU16(4)).overflowed());
+		assert((CheckedU16(3) - CheckedU16(4)).value() == 65535);
+	}
+
+	Tee_SubTest(test_quantities) {
+		std::vector<Millimeters> steps(100, Millimeters(30000000));
+		Millimeters total(0);
+		for(auto const& s : steps)
+		{
+			total += s;
+		}
+		// The sum went past 2^31 along the way; checked once at the end
+		assert(Mesi::overflowed(total));
+
+		Millimeters small(0);
+		for(std::size_t i = 0; i < 10; i++)
+		{
+			small += steps[i];
+		}
+		assert(!Mesi::overflowed(small) && small.val == Checked32(300000000));
+
+		auto const area = small * small;
+		static_assert(std::is_same<decltype(area)::BaseType, Checked32>::value, "Products keep the storage type");
+		assert(Mesi::overflowed(area));
+
+		assert(Mesi::overflowed(Millimeters(Meters(3000000))));
+		assert(!Mesi::overflowed(Millimeters(Meters(3000))));
+	}
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_parallel.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Acceleration = decltype(Mesi::Meters{} / Mesi::Seconds{} / Mesi::Seconds{});
+}
+
+Tee_Test(test_parallel) {
+	Tee_SubTest(test_pool) {
+		Mesi::ThreadPool pool(4);
+		assert(pool.threads() == 4);
+
+		// Uneven work makes threads steal from each other; every piece
+		// still runs exactly once
+		std::vector<std::atomic<int>> runs(1000);
+		pool.run(runs.size(), [&](std::size_t i) {
+			volatile std::size_t spin = 0;
+			for(std::size_t k = 0; k < (i < 100 ? 20000 : 10); k++)
+			{
+				spin = spin + k;
+			}
+			runs[i]++;
+		});
+		for(auto const& r : runs)
+		{
+			assert(r == 1);
+		}
+
+		bool threw = false;
+		try
+		{
+			pool.run(100, [](std::size_t i) {
+				if(i == 42)
+				{
+					throw std::runtime_error("piece 42");
+				}
+			});
+		}
+		catch(std::runtime_error const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+
+		// The pool is still usable afterwards
+		std::atomic<std::size_t> sum(0);
+		pool.run(10, [&](std::size_t i) { sum += i; });
+		assert(sum == 45);
+	}
+
+	Tee_SubTest(test_nested_run) {
+		// Nested calls run inline instead of waiting for the busy pool,
+		// also when they come back to it through another pool
+		Mesi::ThreadPool pool(4), other(2);
+		std::vector<std::atomic<int>> runs(64 * 16);
+		pool.run(64, [&](std::size_t i) {
+			pool.run(8, [&](std::size_t j) { runs[i * 16 + j]++; });
+			other.run(2, [&](std::size_t k) {
+				pool.run(4, [&](std::size_t j) { runs[i * 16 + 8 + k * 4 + j]++; });
+			});
+		});
+		for(auto const& r : runs)
+		{
+			assert(r == 1);
+		}
+	}
+
+	Tee_SubTest(test_chunks) {
+		alignas(64) float data[10000];
+		for(std::size_t offset = 0; offset < 16; offset++)
+		{
+			std::size_t const n = 10000 - offset;
+			Mesi::_internal::Chunks<sizeof(float)> const chunks(data + offset, n);
+			assert(chunks.begin(0) == 0 && chunks.end(chunks.count() - 1) == n);
+			for(std::size_t c = 1; c < chunks.count(); c++)
+			{
+				assert(chunks.begin(c) == chunks.end(c - 1));
+				assert(reinterpret_cast<std::uintptr_t>(data + offset + chunks.begin(c)) % 64 == 0);
+			}
+		}
+	}
+
+	Tee_SubTest(test_for) {
+		Mesi::ThreadPool pool(3);
+		std::vector<Mesi::Kelvin> t(100003);
+		for(std::size_t i = 0; i < t.size(); i++)
+		{
+			t[i] = Mesi::Kelvin(float(i));
+		}
+		Mesi::parallel_for(Mesi::Span<Mesi::Kelvin>(t.data(), t.size()), [](Mesi::Kelvin& k) { k += Mesi::Kelvin(1); }, pool);
+		for(std::size_t i = 0; i < t.size(); i++)
+		{
+			assert(t[i] == Mesi::Kelvin(float(i + 1)));
+		}
+		Mesi::parallel_for(Mesi::Span<Mesi::Kelvin>(t.data(), 0), [](Mesi::Kelvin& k) { k = Mesi::Kelvin(0); }, pool);
+	}
+
+	Tee_SubTest(test_transform) {
+		std::vector<Mesi::Kilograms> m(50001);
+		std::vector<Acceleration> a(50001);
+		for(std::size_t i = 0; i < m.size(); i++)
+		{
+			m[i] = Mesi::Kilograms(float(i % 100));
+			a[i] = Acceleration(0.5f);
+		}
+		Mesi::Span<Mesi::Kilograms const> const masses(m.data(), m.size());
+		Mesi::Span<Acceleration const> const accelerations(a.data(), a.size());
+
+		auto const f = Mesi::parallel_transform(masses, accelerations, [](Mesi::Kilograms mass, Acceleration acc) {
+			return mass * acc;
+		});
+		static_assert(std::is_same<decltype(f), std::vector<Mesi::Newtons> const>::value, "The output type follows the callable");
+		for(std::size_t i = 0; i < f.size(); i++)
+		{
+			assert(f[i] == Mesi::Newtons(float(i % 100) * 0.5f));
+		}
+
+		std::vector<Mesi::Milli<Mesi::Kilograms>> grams(m.size());
+		Mesi::parallel_transform(masses, grams.data(), [](Mesi::Kilograms mass) {
+			return Mesi::Milli<Mesi::Kilograms>(mass);
+		});
+		assert(grams[99] == Mesi::Milli<Mesi::Kilograms>(99000));
+
+		bool threw = false;
+		try
+		{
+			Mesi::parallel_transform(masses, Mesi::Span<Acceleration const>(a.data(), 3), [](Mesi::Kilograms mass, Acceleration acc) {
+				return mass * acc;
+			});
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
@@ -0,0 +1,178 @@
+#include "../mesitype_pipeline.h"
+#include "tee/tee.hpp"
+
+#ifdef MESI_PIPELINE
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+	Mesi::Pipeline::Task sum(Mesi::Pipeline::Channel<Mesi::Watts>& in, double& total, std::size_t& count)
+	{
+		Mesi::Watts batch[64];
+		while(std::size_t const n = co_await in.read(Mesi::Span<Mesi::Watts>(batch)))
+		{
+			for(std::size_t i = 0; i < n; i++)
+			{
+				total += double(batch[i].val);
+			}
+			count += n;
+		}
+	}
+
+	Mesi::Pipeline::Task produce(Mesi::Pipeline::Channel<Mesi::Meters>& out, int values, std::size_t& written)
+	{
+		for(int i = 0; i < values; i++)
+		{
+			Mesi::Meters const m{ float(i) };
+			co_await out.write(Mesi::Span<Mesi::Meters const>(&m, 1));
+			written++;
+		}
+		out.close();
+	}
+
+	Mesi::Pipeline::Task consume(Mesi::Pipeline::Channel<Mesi::Meters>& in, std::vector<float>& seen, std::size_t const& written, std::size_t& maxAhead)
+	{
+		Mesi::Meters batch[3];
+		while(std::size_t const n = co_await in.read(Mesi::Span<Mesi::Meters>(batch)))
+		{
+			maxAhead = std::max(maxAhead, written - seen.size());
+			for(std::size_t i = 0; i < n; i++)
+			{
+				seen.push_back(batch[i].val);
+			}
+		}
+	}
+
+	Mesi::Pipeline::Task wait(Mesi::Pipeline::Channel<Mesi::Meters>& in)
+	{
+		Mesi::Meters m;
+		co_await in.read(Mesi::Span<Mesi::Meters>(&m, 1));
+	}
+}
+
+Tee_Test(test_pipeline) {
+	Tee_SubTest(test_sources) {
+		// Many ADC sources, each on a pipe, served by one thread: counts
+		// become volts, volts become watts across a 2 ohm load
+		constexpr int sources = 500;
+		constexpr int samples = 100;
+		Mesi::Pipeline::Loop loop;
+		Mesi::Pipeline::Channel<Mesi::Volts> volts(loop, 256, sources);
+		Mesi::Pipeline::Channel<Mesi::Watts> watts(loop, 256);
+		std::vector<int> writeEnds;
+		for(int s = 0; s < sources; s++)
+		{
+			int fds[2];
+			assert(pipe(fds) == 0);
+			fcntl(fds[0], F_SETFL, O_NONBLOCK);
+			std::vector<std::int16_t> counts(samples, std::int16_t(s % 10));
+			assert(write(fds[1], counts.data(), sizeof(std::int16_t) * samples) == ssize_t(sizeof(std::int16_t) * samples));
+			writeEnds.push_back(fds[1]);
+			loop.spawn(Mesi::Pipeline::source<std::int16_t>(loop, fds[0], volts, [](std::int16_t c) {
+				return Mesi::Volts(float(c) * 0.5f);
+			}, 16));
+		}
+		for(int fd : writeEnds)
+		{
+			close(fd);
+		}
+		Mesi::Ohms const load(2);
+		loop.spawn(Mesi::Pipeline::transform(volts, watts, [load](Mesi::Volts v) {
+			return v * v / load;
+		}));
+		double total = 0;
+		std::size_t count = 0;
+		loop.spawn(sum(watts, total, count));
+		loop.run();
+
+		// Each source s contributes samples * (s % 10 / 2)^2 / 2 watts
+		double expected = 0;
+		for(int s = 0; s < sources; s++)
+		{
+			expected += samples * (s % 10) * (s % 10) / 8.0;
+		}
+		assert(count == std::size_t(sources * samples));
+		assert(total == expected);
+	}
+
+	Tee_SubTest(test_backpressure) {
+		Mesi::Pipeline::Loop loop;
+		Mesi::Pipeline::Channel<Mesi::Meters> channel(loop, 4);
+		std::size_t written = 0;
+		std::size_t maxAhead = 0;
+		std::vector<float> seen;
+		loop.spawn(produce(channel, 100, written));
+		loop.spawn(consume(channel, seen, written, maxAhead));
+		loop.run();
+		assert(seen.size() == 100 && written == 100);
+		for(std::size_t i = 0; i < seen.size(); i++)
+		{
+			assert(seen[i] == float(i));
+		}
+		// The producer never gets further ahead than the channel holds,
+		// plus the one write that is waiting
+		assert(maxAhead <= channel.capacity() + 1);
+	}
+
+	Tee_SubTest(test_deadlock) {
+		Mesi::Pipeline::Loop loop;
+		Mesi::Pipeline::Channel<Mesi::Meters> channel(loop, 4);
+		loop.spawn(wait(channel));
+		bool threw = false;
+		try
+		{
+			loop.run();
+		}
+		catch(std::logic_error const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_truncated_source) {
+		// Three bytes are one and a half 16 bit samples
+		Mesi::Pipeline::Loop loop;
+		Mesi::Pipeline::Channel<Mesi::Volts> volts(loop, 16);
+		int fds[2];
+		assert(pipe(fds) == 0);
+		fcntl(fds[0], F_SETFL, O_NONBLOCK);
+		unsigned char const bytes[3] = { 1, 0, 2 };
+		assert(write(fds[1], bytes, sizeof(bytes)) == ssize_t(sizeof(bytes)));
+		close(fds[1]);
+		loop.spawn(Mesi::Pipeline::source<std::int16_t>(loop, fds[0], volts, [](std::int16_t c) {
+			return Mesi::Volts(float(c));
+		}));
+		bool threw = false;
+		try
+		{
+			loop.run();
+		}
+		catch(std::runtime_error const&)
+		{
+			threw = true;
+		}
+		close(fds[0]);
+		assert(threw);
+	}
+
+	Tee_SubTest(test_empty_read) {
+		Mesi::Pipeline::Loop loop;
+		Mesi::Pipeline::Channel<Mesi::Meters> channel(loop, 4);
+		bool threw = false;
+		try
+		{
+			channel.read(Mesi::Span<Mesi::Meters>(nullptr, 0));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
+#endif
@@ -0,0 +1,85 @@
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../mesitype_polynomial.h"
+#include "tee/tee.hpp"
+
+namespace {
+	bool close(float a, float b, float eps = 1e-4f)
+	{
+		return std::abs(a - b) < eps;
+	}
+
+	// Resistance of a platinum sensor, R(T) = R0 (1 + A T + B T^2), with T
+	// in degrees above the ice point
+	using Resistance = Mesi::Polynomial<Mesi::Kelvin, Mesi::Ohms, 2>;
+	constexpr Resistance s_pt100(
+		Mesi::Ohms(100),
+		Mesi::Ohms(100 * 3.9083e-3f) / Mesi::Kelvin(1),
+		Mesi::Ohms(100 * -5.775e-7f) / (Mesi::Kelvin(1) * Mesi::Kelvin(1)));
+	static_assert(s_pt100(Mesi::Kelvin(0)).val == 100.f, "Evaluation is constexpr");
+
+	// Distance fallen from rest over time
+	constexpr Mesi::Polynomial<Mesi::Seconds, Mesi::Meters, 2> s_fall(
+		Mesi::Meters(0), Mesi::Meters(0) / Mesi::Seconds(1), Mesi::Meters(4.9f) / Mesi::SecondsSq(1));
+}
+
+Tee_Test(test_polynomial_types) {
+	using P = Mesi::Polynomial<Mesi::Seconds, Mesi::Meters, 3>;
+	assert((std::is_same<P::Coefficient<0>, Mesi::Meters>::value));
+	assert((std::is_same<P::Coefficient<1>, decltype(Mesi::Meters{} / Mesi::Seconds{})>::value));
+	assert((std::is_same<P::Coefficient<2>, decltype(Mesi::Meters{} / Mesi::SecondsSq{})>::value));
+	assert((std::is_same<decltype(s_fall(Mesi::Seconds(1))), Mesi::Meters>::value));
+	assert(P::Degree == 3);
+
+	// Scaled inputs carry their scale into the coefficients
+	using Q = Mesi::Polynomial<Mesi::Minutes, Mesi::Meters, 1>;
+	assert((std::is_same<Q::Coefficient<1>, decltype(Mesi::Meters{} / Mesi::Minutes{})>::value));
+	assert((!std::is_constructible<Q, Mesi::Meters, decltype(Mesi::Meters{} / Mesi::Seconds{})>::value));
+	assert((!std::is_constructible<Mesi::Polynomial<Mesi::Seconds, Mesi::Meters, 2>, Mesi::Meters, Mesi::Meters, Mesi::Meters>::value));
+}
+
+Tee_Test(test_polynomial_eval) {
+	Tee_SubTest(test_single) {
+		assert(s_fall(Mesi::Seconds(2)) == Mesi::Meters(19.6f));
+		assert(close(s_pt100(Mesi::Kelvin(100)).val, 138.5055f, 1e-3f));
+		assert(s_pt100.coefficient<0>() == Mesi::Ohms(100));
+	}
+
+	Tee_SubTest(test_scaled) {
+		// One metre per minute, starting at 5 m
+		constexpr Mesi::Polynomial<Mesi::Minutes, Mesi::Meters, 1> p(Mesi::Meters(5), Mesi::Meters(1) / Mesi::Minutes(1));
+		assert(p(Mesi::Minutes(3)) == Mesi::Meters(8));
+	}
+
+	Tee_SubTest(test_batch) {
+		std::vector<Mesi::Kelvin> in;
+		for(int i = -50; i < 300; i += 7)
+		{
+			in.push_back(Mesi::Kelvin(float(i)));
+		}
+		std::vector<Mesi::Ohms> out(in.size());
+		s_pt100.eval(in.data(), out.data(), in.size());
+		for(std::size_t i = 0; i < in.size(); i++)
+		{
+			assert(close(out[i].val, s_pt100(in[i]).val, 1e-3f));
+		}
+
+		std::vector<Mesi::Ohms> spanOut(in.size());
+		s_pt100.eval(Mesi::Span<Mesi::Kelvin const>(in.data(), in.size()), Mesi::Span<Mesi::Ohms>(spanOut.data(), spanOut.size()));
+		assert(spanOut == out);
+
+		bool threw = false;
+		try
+		{
+			s_pt100.eval(Mesi::Span<Mesi::Kelvin const>(in.data(), in.size()), Mesi::Span<Mesi::Ohms>(spanOut.data(), 1));
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+}
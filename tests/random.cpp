@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../mesitype_components.h"
+#include "../mesitype_random.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Milliseconds = Mesi::Milli<Mesi::Seconds>::WithBaseType<double>;
+
+	template<typename Q>
+	double mean(std::vector<Q> const& v)
+	{
+		double sum = 0;
+		for(auto const& q : v)
+		{
+			sum += double(q.val);
+		}
+		return sum / double(v.size());
+	}
+
+	template<typename Q>
+	double stddev(std::vector<Q> const& v)
+	{
+		double const m = mean(v);
+		double sum = 0;
+		for(auto const& q : v)
+		{
+			sum += (double(q.val) - m) * (double(q.val) - m);
+		}
+		return std::sqrt(sum / double(v.size()));
+	}
+}
+
+Tee_Test(test_random_philox) {
+	Tee_SubTest(test_known_answers) {
+		// Known answer tests of the Random123 reference implementation
+		std::uint32_t out[4];
+		Mesi::Random::Philox(0, 0).generate(0, 1, out);
+		assert(out[0] == 0x6627e8d5 && out[1] == 0xe169c58d && out[2] == 0xbc57ac4c && out[3] == 0x9b00dbd8);
+		Mesi::Random::Philox(~0ull, ~0ull).generate(~0ull, 1, out);
+		assert(out[0] == 0x408f276d && out[1] == 0x41c83b0e && out[2] == 0xa20bc7c6 && out[3] == 0x6d5451fd);
+		Mesi::Random::Philox(0x299f31d0a4093822ull, 0x0370734413198a2eull).generate(0x85a308d3243f6a88ull, 1, out);
+		assert(out[0] == 0xd16cfe09 && out[1] == 0x94fdcceb && out[2] == 0x5001e420 && out[3] == 0x24126ea1);
+	}
+
+	Tee_SubTest(test_positions) {
+		Mesi::Random::Philox a(42);
+		std::uint32_t whole[17];
+		a.fill(whole, 17);
+
+		Mesi::Random::Philox b(42);
+		std::uint32_t parts[17];
+		b.fill(parts, 3);
+		b.fill(parts + 3, 1);
+		b.fill(parts + 4, 10);
+		parts[14] = b();
+		b.fill(parts + 15, 2);
+		assert(std::equal(whole, whole + 17, parts));
+
+		b.seek(2);
+		assert(b() == whole[8]);
+		assert(a.stream(0)() == whole[0]);
+
+		std::uniform_int_distribution<int> dice(1, 6);
+		int const roll = dice(a);
+		assert(roll >= 1 && roll <= 6);
+	}
+
+	Tee_SubTest(test_streams) {
+		Mesi::Random::Philox const base(7);
+		assert(base.stream(3)() == Mesi::Random::Philox(7, 3)());
+		assert(base.stream(3)() != base.stream(4)());
+
+		// Each thread draws from its own stream, which gives the same
+		// values however the threads are scheduled
+		Mesi::Random::Normal<Mesi::Meters> const d(Mesi::Meters(0), Mesi::Meters(1));
+		std::vector<std::vector<Mesi::Meters>> threaded(4, std::vector<Mesi::Meters>(1000));
+		std::vector<std::thread> threads;
+		for(std::size_t t = 0; t < threaded.size(); t++)
+		{
+			threads.emplace_back([&, t] {
+				Mesi::Random::Philox g = base.stream(t);
+				d.fill(g, threaded[t].data(), threaded[t].size());
+			});
+		}
+		for(auto& t : threads)
+		{
+			t.join();
+		}
+		for(std::size_t t = 0; t < threaded.size(); t++)
+		{
+			Mesi::Random::Philox g(7, t);
+			std::vector<Mesi::Meters> serial(1000);
+			d.fill(g, serial.data(), serial.size());
+			assert(std::equal(serial.begin(), serial.end(), threaded[t].begin()));
+		}
+		assert(!std::equal(threaded[0].begin(), threaded[0].end(), threaded[1].begin()));
+	}
+}
+
+Tee_Test(test_random_distributions) {
+	Tee_SubTest(test_uniform) {
+		Mesi::Random::Philox g(1);
+		std::vector<Mesi::Kelvin> v(100001);
+		Mesi::Random::Uniform<Mesi::Kelvin>(Mesi::Kelvin(270), Mesi::Kelvin(280)).fill(g, v.data(), v.size());
+		auto const range = std::minmax_element(v.begin(), v.end());
+		assert(*range.first >= Mesi::Kelvin(270) && *range.second < Mesi::Kelvin(280));
+		assert(std::fabs(mean(v) - 275) < 0.05);
+		assert(std::fabs(stddev(v) - 10 / std::sqrt(12.0)) < 0.05);
+
+		std::vector<Milliseconds> d(100001);
+		Mesi::Random::Uniform<Milliseconds>(Milliseconds(-1), Milliseconds(1)).fill(g, d.data(), d.size());
+		assert(std::fabs(mean(d)) < 0.01);
+	}
+
+	Tee_SubTest(test_normal) {
+		Mesi::Random::Philox g(2);
+		std::vector<Mesi::Meters> v(100001);
+		Mesi::Random::Normal<Mesi::Meters>(Mesi::Meters(5), Mesi::Meters(0.5f)).fill(g, v.data(), v.size());
+		assert(std::fabs(mean(v) - 5) < 0.01);
+		assert(std::fabs(stddev(v) - 0.5) < 0.01);
+		std::size_t const within = std::count_if(v.begin(), v.end(), [](Mesi::Meters m) {
+			return m > Mesi::Meters(4.5f) && m < Mesi::Meters(5.5f);
+		});
+		assert(std::fabs(double(within) / double(v.size()) - 0.6827) < 0.01);
+
+		std::vector<Milliseconds> d(10001);
+		Mesi::Random::Normal<Milliseconds> const jitter(Milliseconds(0), Milliseconds(2));
+		jitter.fill(g, d.data(), d.size());
+		assert(std::fabs(stddev(d) - 2) < 0.1);
+		Milliseconds const one = jitter(g);
+		assert(std::isfinite(one.val));
+	}
+
+	Tee_SubTest(test_exponential) {
+		Mesi::Random::Philox g(3);
+		std::vector<Mesi::Seconds> v(100001);
+		Mesi::Random::Exponential<Mesi::Seconds>(Mesi::Seconds(3)).fill(g, v.data(), v.size());
+		assert(*std::min_element(v.begin(), v.end()) >= Mesi::Seconds(0));
+		assert(std::fabs(mean(v) - 3) < 0.05);
+		assert(std::fabs(stddev(v) - 3) < 0.05);
+	}
+
+	Tee_SubTest(test_log_normal) {
+		Mesi::Random::Philox g(4);
+		std::vector<Milliseconds> v(100001);
+		Mesi::Random::LogNormal<Milliseconds>(Milliseconds(10), Mesi::Scalar::WithBaseType<double>(0.25)).fill(g, v.data(), v.size());
+		std::size_t const below = std::count_if(v.begin(), v.end(), [](Milliseconds m) {
+			return m < Milliseconds(10);
+		});
+		assert(std::fabs(double(below) / double(v.size()) - 0.5) < 0.01);
+		assert(std::fabs(mean(v) - 10 * std::exp(0.25 * 0.25 / 2)) < 0.05);
+	}
+
+	Tee_SubTest(test_fill_component_span) {
+		Mesi::ComponentPool<Mesi::Kelvin, Mesi::Seconds> pool;
+		for(int i = 0; i < 33; i++)
+		{
+			pool.create(Mesi::Kelvin(0), Mesi::Seconds(0));
+		}
+		Mesi::Random::Philox a(5), b(5);
+		Mesi::Random::Normal<Mesi::Kelvin> const temperature(Mesi::Kelvin(300), Mesi::Kelvin(5));
+		Mesi::Random::Exponential<Mesi::Seconds> const lifetime(Mesi::Seconds(2));
+		temperature.fill(a, pool.span<Mesi::Kelvin>());
+		lifetime.fill(a, pool.span<Mesi::Seconds>());
+
+		std::vector<Mesi::Kelvin> t(pool.size());
+		std::vector<Mesi::Seconds> l(pool.size());
+		temperature.fill(b, t.data(), t.size());
+		lifetime.fill(b, l.data(), l.size());
+		for(std::size_t i = 0; i < pool.size(); i++)
+		{
+			assert(pool.span<Mesi::Kelvin>()[i] == t[i]);
+			assert(pool.span<Mesi::Seconds>()[i] == l[i]);
+		}
+	}
+}
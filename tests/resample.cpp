@@ -0,0 +1,88 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../mesitype_resample.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Nanoseconds = Mesi::Nano<Mesi::Seconds>::WithBaseType<std::int64_t>;
+}
+
+Tee_Test(test_resample_join) {
+	Tee_SubTest(test_merge_join) {
+		Nanoseconds const ta[] = { Nanoseconds(0), Nanoseconds(10), Nanoseconds(20), Nanoseconds(30) };
+		Mesi::Watts const a[] = { Mesi::Watts(1), Mesi::Watts(2), Mesi::Watts(3), Mesi::Watts(4) };
+		Nanoseconds const tb[] = { Nanoseconds(10), Nanoseconds(15), Nanoseconds(30) };
+		Mesi::Kelvin const b[] = { Mesi::Kelvin(300), Mesi::Kelvin(301), Mesi::Kelvin(302) };
+		Nanoseconds t[3];
+		Mesi::Watts outA[3];
+		Mesi::Kelvin outB[3];
+		assert(Mesi::mergeJoin(ta, a, 4, tb, b, 3, t, outA, outB) == 2);
+		assert(t[0] == Nanoseconds(10) && outA[0] == Mesi::Watts(2) && outB[0] == Mesi::Kelvin(300));
+		assert(t[1] == Nanoseconds(30) && outA[1] == Mesi::Watts(4) && outB[1] == Mesi::Kelvin(302));
+	}
+
+	Tee_SubTest(test_as_of_join) {
+		Nanoseconds const ts[] = { Nanoseconds(10), Nanoseconds(20), Nanoseconds(40) };
+		Mesi::Kelvin const source[] = { Mesi::Kelvin(1), Mesi::Kelvin(2), Mesi::Kelvin(3) };
+		Nanoseconds const tt[] = { Nanoseconds(0), Nanoseconds(5), Nanoseconds(10), Nanoseconds(39), Nanoseconds(40), Nanoseconds(100) };
+		Mesi::Kelvin out[6] = { Mesi::Kelvin(-1), Mesi::Kelvin(-1) };
+		assert(Mesi::asOfJoin(ts, source, 3, tt, 6, out) == 2);
+		assert(out[0] == Mesi::Kelvin(-1) && out[1] == Mesi::Kelvin(-1));
+		assert(out[2] == Mesi::Kelvin(1));
+		assert(out[3] == Mesi::Kelvin(2));
+		assert(out[4] == Mesi::Kelvin(3));
+		assert(out[5] == Mesi::Kelvin(3));
+	}
+}
+
+Tee_Test(test_resample) {
+	Tee_SubTest(test_nearest) {
+		Nanoseconds const ts[] = { Nanoseconds(10), Nanoseconds(20), Nanoseconds(40) };
+		Mesi::Meters const source[] = { Mesi::Meters(1), Mesi::Meters(2), Mesi::Meters(3) };
+		Nanoseconds const tt[] = { Nanoseconds(0), Nanoseconds(14), Nanoseconds(15), Nanoseconds(16), Nanoseconds(31), Nanoseconds(50) };
+		Mesi::Meters out[6];
+		Mesi::resampleNearest(ts, source, 3, tt, 6, out);
+		assert(out[0] == Mesi::Meters(1));
+		assert(out[1] == Mesi::Meters(1));
+		assert(out[2] == Mesi::Meters(1));
+		assert(out[3] == Mesi::Meters(2));
+		assert(out[4] == Mesi::Meters(3));
+		assert(out[5] == Mesi::Meters(3));
+	}
+
+	Tee_SubTest(test_linear) {
+		// A 1 kHz ramp resampled onto an offset 3 kHz base spanning
+		// several blocks, with nanosecond timestamps far from zero
+		std::int64_t const start = 1700000000000000000;
+		std::vector<Nanoseconds> ts, tt;
+		std::vector<Mesi::Watts> source;
+		for(int i = 0; i < 100; i++)
+		{
+			ts.push_back(Nanoseconds(start + 1000000 * i));
+			source.push_back(Mesi::Watts(2.0f * float(i)));
+		}
+		for(int i = 0; i < 320; i++)
+		{
+			tt.push_back(Nanoseconds(start - 1000000 + 333333 * i));
+		}
+		std::vector<Mesi::Watts> out(tt.size());
+		Mesi::resampleLinear(ts.data(), source.data(), ts.size(), tt.data(), tt.size(), out.data());
+		for(std::size_t i = 0; i < tt.size(); i++)
+		{
+			float const ms = float((tt[i] - ts[0]).val) / 1e6f;
+			float const expected = 2.0f * std::fmin(std::fmax(ms, 0.0f), 99.0f);
+			assert(std::fabs(out[i].val - expected) < 1e-4f);
+		}
+	}
+
+	Tee_SubTest(test_single_sample) {
+		Mesi::Seconds const ts[] = { Mesi::Seconds(1) };
+		Mesi::Meters const source[] = { Mesi::Meters(5) };
+		Mesi::Seconds const tt[] = { Mesi::Seconds(0), Mesi::Seconds(2) };
+		Mesi::Meters out[2];
+		Mesi::resampleLinear(ts, source, 1, tt, 2, out);
+		assert(out[0] == Mesi::Meters(5) && out[1] == Mesi::Meters(5));
+	}
+}
@@ -0,0 +1,253 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../mesitype_taskgraph.h"
+#include "tee/tee.hpp"
+
+namespace {
+	using Velocity = decltype(Mesi::Meters{} / Mesi::Seconds{});
+	using Acceleration = decltype(Velocity{} / Mesi::Seconds{});
+	using Stiffness = decltype(Mesi::Newtons{} / Mesi::Meters{});
+
+	struct Particles
+	{
+		std::vector<Mesi::Kilograms> m;
+		std::vector<Mesi::Newtons> f;
+		std::vector<Acceleration> a;
+		std::vector<Velocity> v;
+		std::vector<Mesi::Meters> x;
+		std::vector<Mesi::Kelvin> t;
+
+		explicit Particles(std::size_t n)
+			: m(n), f(n), a(n), v(n), x(n), t(n)
+		{
+			for(std::size_t i = 0; i < n; i++)
+			{
+				m[i] = Mesi::Kilograms(float(1 + i % 3));
+				v[i] = Velocity(0);
+				x[i] = Mesi::Meters(float(i % 7));
+				t[i] = Mesi::Kelvin(300);
+			}
+		}
+	};
+
+	template<typename Q>
+	Mesi::Span<Q> all(std::vector<Q>& v)
+	{
+		return Mesi::Span<Q>(v.data(), v.size());
+	}
+
+	Stiffness const k(2);
+	Mesi::Seconds const dt(0.01f);
+
+	void forces(Mesi::Span<Mesi::Meters const> x, Mesi::Span<Mesi::Newtons> f)
+	{
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			f[i] = -k * x[i];
+		}
+	}
+
+	void accelerations(Mesi::Span<Mesi::Newtons const> f, Mesi::Span<Mesi::Kilograms const> m, Mesi::Span<Acceleration> a)
+	{
+		for(std::size_t i = 0; i < f.size(); i++)
+		{
+			a[i] = f[i] / m[i];
+		}
+	}
+
+	void velocities(Mesi::Span<Acceleration const> a, Mesi::Span<Velocity> v)
+	{
+		for(std::size_t i = 0; i < a.size(); i++)
+		{
+			v[i] += a[i] * dt;
+		}
+	}
+
+	void positions(Mesi::Span<Velocity const> v, Mesi::Span<Mesi::Meters> x)
+	{
+		for(std::size_t i = 0; i < v.size(); i++)
+		{
+			x[i] += v[i] * dt;
+		}
+	}
+
+	void cooling(Mesi::Span<Mesi::Kelvin> t)
+	{
+		for(auto& k : t)
+		{
+			k -= Mesi::Kelvin(0.5f);
+		}
+	}
+}
+
+Tee_Test(test_task_graph) {
+	Tee_SubTest(test_ticks) {
+		Mesi::ThreadPool pool(4);
+		Particles p(1000);
+		Particles serial(1000);
+
+		Mesi::TaskGraph tick(pool);
+		auto const m = tick.buffer(all(p.m));
+		auto const f = tick.buffer(all(p.f));
+		auto const a = tick.buffer(all(p.a));
+		auto const v = tick.buffer(all(p.v));
+		auto const x = tick.buffer(all(p.x));
+		auto const t = tick.buffer(all(p.t));
+
+		std::mutex mutex;
+		std::vector<int> order;
+		auto const log = [&](int node) {
+			std::lock_guard<std::mutex> lock(mutex);
+			order.push_back(node);
+		};
+		tick.node(Mesi::reads(x), Mesi::writes(f), [&](Mesi::Span<Mesi::Meters const> x, Mesi::Span<Mesi::Newtons> f) {
+			forces(x, f);
+			log(0);
+		});
+		tick.node(Mesi::reads(f, m), Mesi::writes(a), [&](Mesi::Span<Mesi::Newtons const> f, Mesi::Span<Mesi::Kilograms const> m, Mesi::Span<Acceleration> a) {
+			accelerations(f, m, a);
+			log(1);
+		});
+		tick.node(Mesi::reads(a), Mesi::writes(v), [&](Mesi::Span<Acceleration const> a, Mesi::Span<Velocity> v) {
+			velocities(a, v);
+			log(2);
+		});
+		tick.node(Mesi::reads(v), Mesi::writes(x), [&](Mesi::Span<Velocity const> v, Mesi::Span<Mesi::Meters> x) {
+			positions(v, x);
+			log(3);
+		});
+		tick.node(Mesi::writes(t), [&](Mesi::Span<Mesi::Kelvin> t) {
+			cooling(t);
+			log(4);
+		});
+		assert(tick.size() == 5);
+
+		for(int step = 0; step < 20; step++)
+		{
+			order.clear();
+			tick.run();
+			assert(order.size() == 5);
+			for(std::size_t i = 0, expected = 0; i < order.size(); i++)
+			{
+				if(order[i] != 4)
+				{
+					assert(order[i] == int(expected++));
+				}
+			}
+
+			forces(all(serial.x), all(serial.f));
+			accelerations(all(serial.f), all(serial.m), all(serial.a));
+			velocities(all(serial.a), all(serial.v));
+			positions(all(serial.v), all(serial.x));
+			cooling(all(serial.t));
+		}
+		for(std::size_t i = 0; i < p.x.size(); i++)
+		{
+			assert(p.x[i] == serial.x[i] && p.v[i] == serial.v[i] && p.t[i] == serial.t[i]);
+		}
+	}
+
+	Tee_SubTest(test_concurrency) {
+		// Two nodes writing different buffers run at the same time: each
+		// waits until the other has started
+		Mesi::ThreadPool pool(2);
+		Mesi::TaskGraph graph(pool);
+		Mesi::Meters x[4];
+		Mesi::Kelvin t[4];
+		auto const bx = graph.buffer(Mesi::Span<Mesi::Meters>(x));
+		auto const bt = graph.buffer(Mesi::Span<Mesi::Kelvin>(t));
+		std::atomic<int> started(0);
+		auto const meet = [&] {
+			started++;
+			auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			while(started < 2 && std::chrono::steady_clock::now() < deadline)
+			{
+				std::this_thread::yield();
+			}
+			assert(started == 2);
+		};
+		graph.node(Mesi::writes(bx), [&](Mesi::Span<Mesi::Meters>) { meet(); });
+		graph.node(Mesi::writes(bt), [&](Mesi::Span<Mesi::Kelvin>) { meet(); });
+		graph.run();
+		started = 0;
+		graph.run();
+	}
+
+	Tee_SubTest(test_dependencies) {
+		Mesi::ThreadPool pool(3);
+		Mesi::TaskGraph graph(pool);
+		int x[1];
+		auto const b = graph.buffer(Mesi::Span<int>(x));
+		std::atomic<int> readers(0);
+		std::atomic<bool> ok(true);
+
+		// Readers of one buffer run after its writer, and the next writer
+		// waits for all of them
+		graph.node(Mesi::writes(b), [](Mesi::Span<int> x) { x[0] = 1; });
+		for(int i = 0; i < 5; i++)
+		{
+			graph.node(Mesi::reads(b), Mesi::Writes<>(), [&](Mesi::Span<int const> x) {
+				ok = ok && x[0] == 1;
+				readers++;
+			});
+		}
+		graph.node(Mesi::writes(b), [&](Mesi::Span<int> x) {
+			ok = ok && readers == 5;
+			x[0] = 2;
+		});
+		graph.run();
+		assert(ok && x[0] == 2);
+
+		graph.node(Mesi::writes(b), [](Mesi::Span<int>) { throw std::runtime_error("node"); });
+		bool threw = false;
+		try
+		{
+			graph.run();
+		}
+		catch(std::runtime_error const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+
+		Mesi::TaskGraph other(pool);
+		threw = false;
+		try
+		{
+			other.node(Mesi::writes(b), [](Mesi::Span<int>) {});
+		}
+		catch(std::invalid_argument const&)
+		{
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	Tee_SubTest(test_nested_parallel_for) {
+		// The graph and the loops inside its nodes share the default pool
+		Mesi::TaskGraph graph;
+		std::vector<Mesi::Meters> x(20000, Mesi::Meters(1));
+		std::vector<Mesi::Kelvin> t(20000, Mesi::Kelvin(300));
+		auto const bx = graph.buffer(Mesi::Span<Mesi::Meters>(x.data(), x.size()));
+		auto const bt = graph.buffer(Mesi::Span<Mesi::Kelvin>(t.data(), t.size()));
+		graph.node(Mesi::writes(bx), [](Mesi::Span<Mesi::Meters> x) {
+			Mesi::parallel_for(x, [](Mesi::Meters& m) { m += Mesi::Meters(1); });
+		});
+		graph.node(Mesi::writes(bt), [](Mesi::Span<Mesi::Kelvin> t) {
+			Mesi::parallel_for(t, [](Mesi::Kelvin& k) { k -= Mesi::Kelvin(10); });
+		});
+		for(int tick = 0; tick < 3; tick++)
+		{
+			graph.run();
+		}
+		for(std::size_t i = 0; i < x.size(); i++)
+		{
+			assert(x[i] == Mesi::Meters(4) && t[i] == Mesi::Kelvin(270));
+		}
+	}
+}